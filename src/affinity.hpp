@@ -1,6 +1,7 @@
 #pragma once
 
 #include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
 #include <thread>
 #include <iostream>
 #include <vector>
@@ -57,7 +58,7 @@ bool set_current_thread_affinity(int cpu_id) {
 }
 
 
-class AffinityBenchmark : public benchmark::Fixture {
+class AffinityBenchmark : public AllocCountingFixture {
 public:
     void SetUp(const benchmark::State& state) override {
         data.resize(data_size, 1);
@@ -93,7 +94,7 @@ static void run_on_thread_with_affinity(bool use_affinity, const std::vector<int
             set_current_thread_affinity(2);
         }
         while (!ready);
-        for (auto _ : state) {
+        for (auto _ : alloc_counter::counted(state)) {
             compute_heavy_work(data, result);
             benchmark::DoNotOptimize(result);
         }
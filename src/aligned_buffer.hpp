@@ -0,0 +1,139 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+#if defined(_WIN32)
+    #include <malloc.h>
+#elif defined(__linux__)
+    #include <sys/mman.h>
+#endif
+
+
+enum class PageSize {
+    Default,
+    Huge,   // 2MB pages: explicit hugetlb pages if any are reserved, otherwise a
+            // transparent huge page hint. Falls back to normal pages on other platforms.
+};
+
+
+// A fixed-size, zero-initialised array of trivially copyable T whose first element
+// sits on a cache line boundary, so aligned vector loads are legal and no vector
+// load straddles two lines. Memory comes straight from the OS or aligned_alloc
+// rather than operator new, so it does not show up in the allocation counters.
+template <typename T>
+class AlignedBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "AlignedBuffer does not run constructors");
+public:
+    static constexpr std::size_t alignment = 64;
+    static constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+
+    AlignedBuffer() = default;
+
+    explicit AlignedBuffer(std::size_t size, PageSize pages = PageSize::Default) : size_(size) {
+        const std::size_t bytes = round_up(size * sizeof(T), pages == PageSize::Huge ? huge_page_size : alignment);
+        if (bytes == 0) return;
+        if (pages == PageSize::Huge) {
+            allocate_huge(bytes);
+        }
+        if (data_ == nullptr) {
+            allocate_aligned(bytes);
+        }
+    }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    AlignedBuffer(AlignedBuffer&& other) noexcept { swap(other); }
+
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept {
+        AlignedBuffer(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~AlignedBuffer() {
+        release();
+    }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    T& operator[](std::size_t i) { return data_[i]; }
+    const T& operator[](std::size_t i) const { return data_[i]; }
+    T* begin() { return data_; }
+    T* end() { return data_ + size_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+
+    // True when the memory is backed by explicitly reserved huge pages.
+    bool huge_pages() const { return huge_; }
+
+    void swap(AlignedBuffer& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(mapped_bytes_, other.mapped_bytes_);
+        std::swap(huge_, other.huge_);
+    }
+
+private:
+    static std::size_t round_up(std::size_t bytes, std::size_t to) {
+        return (bytes + to - 1) & ~(to - 1);
+    }
+
+    void allocate_huge(std::size_t bytes) {
+#if defined(__linux__)
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            huge_ = true;
+        } else {
+            p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) return;
+            madvise(p, bytes, MADV_HUGEPAGE);
+        }
+        // Anonymous mappings are already zeroed.
+        data_ = static_cast<T*>(p);
+        mapped_bytes_ = bytes;
+#else
+        (void)bytes;
+#endif
+    }
+
+    void allocate_aligned(std::size_t bytes) {
+#if defined(_WIN32)
+        void* p = _aligned_malloc(bytes, alignment);
+#else
+        void* p = std::aligned_alloc(alignment, bytes);
+#endif
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        std::memset(p, 0, bytes);
+        data_ = static_cast<T*>(p);
+    }
+
+    void release() {
+        if (data_ == nullptr) return;
+#if defined(__linux__)
+        if (mapped_bytes_ != 0) {
+            munmap(data_, mapped_bytes_);
+            data_ = nullptr;
+            return;
+        }
+#endif
+#if defined(_WIN32)
+        _aligned_free(data_);
+#else
+        std::free(data_);
+#endif
+        data_ = nullptr;
+    }
+
+    T* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t mapped_bytes_ = 0;
+    bool huge_ = false;
+};
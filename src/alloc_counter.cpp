@@ -0,0 +1,150 @@
+#include "alloc_counter.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+
+namespace alloc_counter {
+
+thread_local ThreadState thread_state{};
+
+static void on_allocate(std::size_t size) {
+    ThreadState& ts = thread_state;
+    ++ts.counters.allocations;
+    ts.counters.bytes_allocated += size;
+    if (ts.no_alloc_depth != 0) {
+        ++ts.counters.violations;
+        if (ts.on_violation == OnViolation::Abort) {
+            std::fputs("alloc_counter: heap allocation inside NoAllocScope\n", stderr);
+            std::abort();
+        }
+    }
+}
+
+static void on_deallocate() {
+    ++thread_state.counters.deallocations;
+}
+
+static void* allocate(std::size_t size) {
+    if (size == 0) size = 1;
+    for (;;) {
+        if (void* ptr = std::malloc(size)) {
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+static void* allocate_aligned(std::size_t size, std::size_t alignment) {
+    if (size == 0) size = 1;
+    for (;;) {
+#if defined(_WIN32)
+        void* ptr = _aligned_malloc(size, alignment);
+#else
+        // aligned_alloc wants the size to be a multiple of the alignment.
+        void* ptr = std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+        if (ptr) {
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+static void free_aligned(void* ptr) {
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+}
+
+
+void* operator new(std::size_t size) {
+    alloc_counter::on_allocate(size);
+    return alloc_counter::allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    alloc_counter::on_allocate(size);
+    return alloc_counter::allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    alloc_counter::on_allocate(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    alloc_counter::on_allocate(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    alloc_counter::on_allocate(size);
+    return alloc_counter::allocate_aligned(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    alloc_counter::on_allocate(size);
+    return alloc_counter::allocate_aligned(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) return;
+    alloc_counter::on_deallocate();
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    if (!ptr) return;
+    alloc_counter::on_deallocate();
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    ::operator delete[](ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    ::operator delete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    ::operator delete[](ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    if (!ptr) return;
+    alloc_counter::on_deallocate();
+    alloc_counter::free_aligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    if (!ptr) return;
+    alloc_counter::on_deallocate();
+    alloc_counter::free_aligned(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+    ::operator delete(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+    ::operator delete[](ptr, alignment);
+}
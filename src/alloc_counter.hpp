@@ -0,0 +1,150 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+
+
+// Counters fed by the replacement global operator new/delete in alloc_counter.cpp.
+// Everything is per-thread, so a benchmark only sees the allocations made by the
+// thread that runs it.
+namespace alloc_counter {
+
+enum class OnViolation {
+    Report,  // count the allocation and carry on
+    Abort    // print a message and abort, so a debugger stops on the offending call
+};
+
+struct Counters {
+    uint64_t allocations;
+    uint64_t deallocations;
+    uint64_t bytes_allocated;
+    uint64_t violations;  // allocations made inside a NoAllocScope
+};
+
+struct ThreadState {
+    Counters counters;
+    uint32_t no_alloc_depth;
+    OnViolation on_violation;
+};
+
+// Trivially initialised so that touching it from inside operator new never allocates.
+extern thread_local ThreadState thread_state;
+
+inline const Counters& thread_counters() {
+    return thread_state.counters;
+}
+
+
+// Marks a region that must not touch the heap. Scopes nest; the innermost one decides
+// what happens on a violation.
+class NoAllocScope {
+public:
+    explicit NoAllocScope(OnViolation on_violation = OnViolation::Report)
+        : previous_(thread_state.on_violation)
+        , violations_at_entry_(thread_state.counters.violations)
+    {
+        thread_state.on_violation = on_violation;
+        ++thread_state.no_alloc_depth;
+    }
+
+    ~NoAllocScope() {
+        --thread_state.no_alloc_depth;
+        thread_state.on_violation = previous_;
+    }
+
+    NoAllocScope(const NoAllocScope&) = delete;
+    NoAllocScope& operator=(const NoAllocScope&) = delete;
+
+    uint64_t violations() const {
+        return thread_state.counters.violations - violations_at_entry_;
+    }
+
+private:
+    OnViolation previous_;
+    uint64_t violations_at_entry_;
+};
+
+}
+
+
+// for (auto _ : alloc_counter::counted(state)) runs like for (auto _ : state) and
+// reports allocs_per_iter: the heap allocations made from the start of the first
+// iteration to the end of the last, averaged over the iterations. Setup before the
+// loop, counters set after it and the library's own bookkeeping are left out.
+namespace alloc_counter {
+
+class CountedLoop {
+public:
+    class Iterator {
+    public:
+        BENCHMARK_ALWAYS_INLINE Iterator(CountedLoop* loop, benchmark::State::StateIterator it)
+            : loop_(loop), it_(it) {}
+
+        BENCHMARK_ALWAYS_INLINE auto operator*() const { return *it_; }
+
+        BENCHMARK_ALWAYS_INLINE Iterator& operator++() {
+            ++it_;
+            return *this;
+        }
+
+        BENCHMARK_ALWAYS_INLINE bool operator!=(const Iterator& end) const {
+            if (BENCHMARK_BUILTIN_EXPECT(it_ != end.it_, true)) return true;
+            loop_->finish();
+            return false;
+        }
+
+    private:
+        CountedLoop* loop_;
+        benchmark::State::StateIterator it_;
+    };
+
+    explicit CountedLoop(benchmark::State& state) : state_(state) {}
+
+    BENCHMARK_ALWAYS_INLINE Iterator begin() {
+        const benchmark::State::StateIterator it = state_.begin();
+        start_ = thread_counters().allocations;
+        return {this, it};
+    }
+
+    BENCHMARK_ALWAYS_INLINE Iterator end() { return {this, state_.end()}; }
+
+private:
+    void finish() {
+        const uint64_t allocations = thread_counters().allocations - start_;
+        state_.counters["allocs_per_iter"] = benchmark::Counter(
+            static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+    }
+
+    benchmark::State& state_;
+    uint64_t start_ = 0;
+};
+
+inline CountedLoop counted(benchmark::State& state) {
+    return CountedLoop(state);
+}
+
+}
+
+
+// Fixture base that reports allocations made inside a NoAllocScope anywhere in the
+// benchmark as no_alloc_violations. Derived fixtures keep overriding the const
+// SetUp/TearDown overloads; these run around them.
+class AllocCountingFixture : public benchmark::Fixture {
+public:
+    void SetUp(benchmark::State& state) override {
+        benchmark::Fixture::SetUp(state);
+        violations_at_start_ = alloc_counter::thread_counters().violations;
+    }
+
+    void TearDown(benchmark::State& state) override {
+        const uint64_t violations = alloc_counter::thread_counters().violations - violations_at_start_;
+        if (violations != 0) {
+            state.counters["no_alloc_violations"] = static_cast<double>(violations);
+        }
+        benchmark::Fixture::TearDown(state);
+    }
+
+private:
+    uint64_t violations_at_start_ = 0;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Build with HFT_ALLOCATOR_STATS=0 to compile the bookkeeping out of Arena and
+// PoolAllocator entirely.
+#ifndef HFT_ALLOCATOR_STATS
+# define HFT_ALLOCATOR_STATS 1
+#endif
+
+
+struct AllocatorStatsSnapshot {
+    uint64_t capacity_bytes = 0;
+    uint64_t bytes_in_use = 0;
+    uint64_t high_water_bytes = 0;
+    uint64_t allocations = 0;
+    uint64_t failed_allocations = 0;
+    uint64_t padding_bytes = 0;
+};
+
+
+#if HFT_ALLOCATOR_STATS
+
+// Single-writer statistics. The owning thread updates the fields with relaxed
+// load/store pairs (no locked instructions) inside a sequence counter, so any other
+// thread can take a consistent snapshot() without the hot path ever waiting.
+class AllocatorStats {
+public:
+    static constexpr bool enabled = true;
+
+    explicit AllocatorStats(uint64_t capacity_bytes)
+        : capacity_bytes_(capacity_bytes) {}
+
+    void on_allocate(uint64_t bytes, uint64_t padding) {
+        begin_write();
+        const uint64_t in_use = bytes_in_use_.load(std::memory_order_relaxed) + bytes + padding;
+        bytes_in_use_.store(in_use, std::memory_order_relaxed);
+        if (in_use > high_water_bytes_.load(std::memory_order_relaxed)) {
+            high_water_bytes_.store(in_use, std::memory_order_relaxed);
+        }
+        allocations_.store(allocations_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        padding_bytes_.store(padding_bytes_.load(std::memory_order_relaxed) + padding, std::memory_order_relaxed);
+        end_write();
+    }
+
+    void on_deallocate(uint64_t bytes, uint64_t padding) {
+        begin_write();
+        bytes_in_use_.store(bytes_in_use_.load(std::memory_order_relaxed) - bytes - padding, std::memory_order_relaxed);
+        padding_bytes_.store(padding_bytes_.load(std::memory_order_relaxed) - padding, std::memory_order_relaxed);
+        end_write();
+    }
+
+    void on_failed_allocation() {
+        begin_write();
+        failed_allocations_.store(failed_allocations_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        end_write();
+    }
+
+    // Releases everything at once, as Arena::reset does. The high-water mark is kept.
+    void on_reset() {
+        begin_write();
+        bytes_in_use_.store(0, std::memory_order_relaxed);
+        padding_bytes_.store(0, std::memory_order_relaxed);
+        end_write();
+    }
+
+    // Safe to call from any thread.
+    AllocatorStatsSnapshot snapshot() const {
+        AllocatorStatsSnapshot result;
+        uint64_t before, after;
+        do {
+            before = sequence_.load(std::memory_order_acquire);
+            result.capacity_bytes = capacity_bytes_;
+            result.bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+            result.high_water_bytes = high_water_bytes_.load(std::memory_order_relaxed);
+            result.allocations = allocations_.load(std::memory_order_relaxed);
+            result.failed_allocations = failed_allocations_.load(std::memory_order_relaxed);
+            result.padding_bytes = padding_bytes_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+        return result;
+    }
+
+private:
+    void begin_write() {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void end_write() {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    std::atomic<uint64_t> sequence_{0};
+    const uint64_t capacity_bytes_;
+    std::atomic<uint64_t> bytes_in_use_{0};
+    std::atomic<uint64_t> high_water_bytes_{0};
+    std::atomic<uint64_t> allocations_{0};
+    std::atomic<uint64_t> failed_allocations_{0};
+    std::atomic<uint64_t> padding_bytes_{0};
+};
+
+#else
+
+class AllocatorStats {
+public:
+    static constexpr bool enabled = false;
+
+    explicit AllocatorStats(uint64_t capacity_bytes) : capacity_bytes_(capacity_bytes) {}
+
+    void on_allocate(uint64_t, uint64_t) {}
+    void on_deallocate(uint64_t, uint64_t) {}
+    void on_failed_allocation() {}
+    void on_reset() {}
+
+    AllocatorStatsSnapshot snapshot() const {
+        AllocatorStatsSnapshot result;
+        result.capacity_bytes = capacity_bytes_;
+        return result;
+    }
+
+private:
+    uint64_t capacity_bytes_;
+};
+
+#endif
+
+
+inline void report_allocator_stats(benchmark::State& state, const AllocatorStatsSnapshot& stats) {
+    if (!AllocatorStats::enabled) return;
+    state.counters["capacity_bytes"] = static_cast<double>(stats.capacity_bytes);
+    state.counters["high_water_bytes"] = static_cast<double>(stats.high_water_bytes);
+    state.counters["high_water_pct"] = stats.capacity_bytes
+        ? 100.0 * static_cast<double>(stats.high_water_bytes) / static_cast<double>(stats.capacity_bytes)
+        : 0.0;
+    state.counters["bytes_in_use"] = static_cast<double>(stats.bytes_in_use);
+    state.counters["allocations"] = static_cast<double>(stats.allocations);
+    state.counters["failed_allocations"] = static_cast<double>(stats.failed_allocations);
+    state.counters["padding_bytes"] = static_cast<double>(stats.padding_bytes);
+}
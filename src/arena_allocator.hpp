@@ -1,13 +1,17 @@
 #pragma once
 #include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "allocator_stats.hpp"
 #include <vector>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <memory>
 
 
 class Arena {
 public:
-    Arena(std::size_t size) {
+    Arena(std::size_t size) : stats_(size) {
         base = static_cast<char*>(std::malloc(size));
         current = base;
         end = base + size;
@@ -17,23 +21,33 @@ public:
         std::free(base);
     }
 
-    void* allocate(std::size_t size) {
-        if (current + size > end) {
+    void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+        const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(current);
+        const std::size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+        if (padding + size > static_cast<std::size_t>(end - current)) {
+            stats_.on_failed_allocation();
             throw std::bad_alloc();
         }
 
-        void* result = current;
-        current += size;
+        void* result = current + padding;
+        current += padding + size;
+        stats_.on_allocate(size, padding);
         return result;
     }
 
     void reset() {
         current = base;
+        stats_.on_reset();
+    }
+
+    AllocatorStatsSnapshot stats() const {
+        return stats_.snapshot();
     }
 private:
     char* base;
     char* current;
     char* end;
+    AllocatorStats stats_;
 };
 
 
@@ -42,7 +56,7 @@ struct MyObject {
 };
 
 
-class ArenaBenchmark : public benchmark::Fixture {
+class ArenaBenchmark : public AllocCountingFixture {
 public:
     static constexpr int num_objects = 10000;
     static constexpr std::size_t arena_size = num_objects * sizeof(MyObject);
@@ -60,7 +74,7 @@ public:
 
 
 BENCHMARK_F(ArenaBenchmark, NormalAllocation)(benchmark::State& state) {
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         std::vector<MyObject*> objects;
         objects.reserve(num_objects);
         for (int i = 0; i < num_objects; ++i) {
@@ -76,15 +90,19 @@ BENCHMARK_F(ArenaBenchmark, NormalAllocation)(benchmark::State& state) {
 }
 
 BENCHMARK_F(ArenaBenchmark, ArenaAllocation)(benchmark::State& state) {
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         std::vector<MyObject*> objects;
         objects.reserve(num_objects);
-        for (int i = 0; i < num_objects; ++i) {
-            objects.push_back(new (arena->allocate(sizeof(MyObject))) MyObject{1, 2, 3, 4});
+        {
+            alloc_counter::NoAllocScope no_alloc;
+            for (int i = 0; i < num_objects; ++i) {
+                objects.push_back(new (arena->allocate(sizeof(MyObject), alignof(MyObject))) MyObject{1, 2, 3, 4});
+            }
+            benchmark::DoNotOptimize(objects);
         }
-        benchmark::DoNotOptimize(objects);
         state.PauseTiming();
         arena->reset();
         state.ResumeTiming();
     }
+    report_allocator_stats(state, arena->stats());
 }
\ No newline at end of file
@@ -0,0 +1,417 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "aligned_buffer.hpp"
+#include "vos_vs_sov.hpp"
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+// Columnar bar file. A header, a table with one entry per symbol, then each symbol's
+// columns one after another, every column starting on a 64-byte boundary:
+//
+//   Header | SymbolEntry x symbol_count | ts opens highs lows closes volumes | ts ...
+//
+// Timestamps are int64 nanoseconds and the rest float, all in host byte order (the
+// header records which). Opening a file maps it read-only; the columns are used in
+// place, so there is nothing to parse and a symbol's pages are only read in when the
+// first indicator touches them.
+namespace bar_file {
+
+constexpr char magic[8] = {'H', 'F', 'T', 'B', 'A', 'R', 'S', '1'};
+constexpr uint32_t byte_order_mark = 0x01020304;
+constexpr size_t column_alignment = 64;
+
+enum Column : size_t { Timestamps, Opens, Highs, Lows, Closes, Volumes, ColumnCount };
+
+struct Header {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t symbol_count;
+    uint64_t file_size;
+};
+
+struct SymbolEntry {
+    char name[16];                   // NUL padded
+    uint64_t bars;
+    uint64_t columns[ColumnCount];   // byte offset of each column from the file start
+};
+
+struct Symbol {
+    std::string name;
+    std::vector<int64_t> timestamps;
+    SOV::OpenHighLowCloses bars;     // volumes may be empty, and are then written as 0
+};
+
+inline uint64_t align_up(uint64_t offset) {
+    return (offset + column_alignment - 1) & ~uint64_t(column_alignment - 1);
+}
+
+// Writes symbols to path. Throws std::runtime_error if the file can't be written.
+inline void write(const std::string& path, const std::vector<Symbol>& symbols) {
+    std::vector<SymbolEntry> entries(symbols.size());
+    uint64_t offset = align_up(sizeof(Header) + symbols.size() * sizeof(SymbolEntry));
+    for (size_t k = 0; k < symbols.size(); ++k) {
+        const Symbol& symbol = symbols[k];
+        SymbolEntry& entry = entries[k];
+        std::memset(&entry, 0, sizeof(entry));
+        std::strncpy(entry.name, symbol.name.c_str(), sizeof(entry.name) - 1);
+        entry.bars = symbol.bars.closes.size();
+        for (size_t c = 0; c < ColumnCount; ++c) {
+            entry.columns[c] = offset;
+            offset = align_up(offset + entry.bars * (c == Timestamps ? sizeof(int64_t) : sizeof(float)));
+        }
+    }
+
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.byte_order = byte_order_mark;
+    header.symbol_count = static_cast<uint32_t>(symbols.size());
+    header.file_size = offset;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("bar_file: cannot create " + path);
+    uint64_t written = 0;
+    auto put = [&](const void* data, uint64_t bytes) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        written += bytes;
+    };
+    auto pad_to = [&](uint64_t target) {
+        static const char zeros[column_alignment] = {};
+        put(zeros, target - written);
+    };
+
+    put(&header, sizeof(header));
+    put(entries.data(), entries.size() * sizeof(SymbolEntry));
+    for (size_t k = 0; k < symbols.size(); ++k) {
+        const Symbol& symbol = symbols[k];
+        const SymbolEntry& entry = entries[k];
+        const size_t bars = entry.bars;
+        const std::vector<float> no_volume(symbol.bars.volumes.empty() ? bars : 0, 0.0f);
+        if (symbol.timestamps.size() != bars || symbol.bars.opens.size() != bars ||
+            symbol.bars.highs.size() != bars || symbol.bars.lows.size() != bars ||
+            (!symbol.bars.volumes.empty() && symbol.bars.volumes.size() != bars)) {
+            throw std::invalid_argument("bar_file: columns of " + symbol.name + " differ in length");
+        }
+        const void* columns[ColumnCount] = {
+            symbol.timestamps.data(), symbol.bars.opens.data(), symbol.bars.highs.data(),
+            symbol.bars.lows.data(), symbol.bars.closes.data(),
+            symbol.bars.volumes.empty() ? no_volume.data() : symbol.bars.volumes.data(),
+        };
+        for (size_t c = 0; c < ColumnCount; ++c) {
+            pad_to(entry.columns[c]);
+            put(columns[c], bars * (c == Timestamps ? sizeof(int64_t) : sizeof(float)));
+        }
+    }
+    pad_to(offset);
+    if (!out.flush()) throw std::runtime_error("bar_file: cannot write " + path);
+}
+
+}
+
+
+// A bar file opened for reading. The mapping lives as long as the object, and the
+// views it hands out point into it. Throws std::runtime_error if the file can't be
+// opened or isn't a bar file written on a machine of the same byte order. Where mmap
+// isn't available the file is read into an aligned buffer instead.
+class BarFile {
+public:
+    explicit BarFile(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("bar_file: cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            throw std::runtime_error("bar_file: cannot stat " + path);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("bar_file: cannot map " + path);
+        data_ = static_cast<const char*>(p);
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) throw std::runtime_error("bar_file: cannot open " + path);
+        size_ = static_cast<size_t>(in.tellg());
+        copy_ = AlignedBuffer<char>(size_);
+        in.seekg(0);
+        in.read(copy_.data(), static_cast<std::streamsize>(size_));
+        data_ = copy_.data();
+#endif
+        try {
+            validate(path);
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    BarFile(const BarFile&) = delete;
+    BarFile& operator=(const BarFile&) = delete;
+
+    ~BarFile() {
+        release();
+    }
+
+    size_t size() const { return header().symbol_count; }
+
+    std::string_view name(size_t k) const {
+        const char* name = entry(k).name;
+        return std::string_view(name, strnlen(name, sizeof(entry(k).name)));
+    }
+
+    // Index of the symbol called name, or size() if there is none.
+    size_t find(std::string_view name) const {
+        for (size_t k = 0; k < size(); ++k) {
+            if (this->name(k) == name) return k;
+        }
+        return size();
+    }
+
+    SOV::OpenHighLowClosesView bars(size_t k) const {
+        return {column<float>(k, bar_file::Opens), column<float>(k, bar_file::Highs),
+                column<float>(k, bar_file::Lows), column<float>(k, bar_file::Closes),
+                column<float>(k, bar_file::Volumes)};
+    }
+
+    std::span<const int64_t> timestamps(size_t k) const {
+        return column<int64_t>(k, bar_file::Timestamps);
+    }
+
+private:
+    const bar_file::Header& header() const {
+        return *reinterpret_cast<const bar_file::Header*>(data_);
+    }
+
+    const bar_file::SymbolEntry& entry(size_t k) const {
+        return reinterpret_cast<const bar_file::SymbolEntry*>(data_ + sizeof(bar_file::Header))[k];
+    }
+
+    template <typename T>
+    std::span<const T> column(size_t k, bar_file::Column c) const {
+        return {reinterpret_cast<const T*>(data_ + entry(k).columns[c]), static_cast<size_t>(entry(k).bars)};
+    }
+
+    // Checks everything the accessors rely on, once, so they don't have to.
+    void validate(const std::string& path) const {
+        auto fail = [&](const char* what) {
+            throw std::runtime_error("bar_file: " + path + ": " + what);
+        };
+        if (size_ < sizeof(bar_file::Header)) fail("truncated header");
+        const bar_file::Header& h = header();
+        if (std::memcmp(h.magic, bar_file::magic, sizeof(bar_file::magic)) != 0) fail("not a bar file");
+        if (h.byte_order != bar_file::byte_order_mark) fail("written with the other byte order");
+        if (h.file_size != size_) fail("size does not match the header");
+        if (sizeof(bar_file::Header) + uint64_t(h.symbol_count) * sizeof(bar_file::SymbolEntry) > size_) fail("truncated symbol table");
+        for (size_t k = 0; k < h.symbol_count; ++k) {
+            const bar_file::SymbolEntry& e = entry(k);
+            for (size_t c = 0; c < bar_file::ColumnCount; ++c) {
+                const uint64_t width = c == bar_file::Timestamps ? sizeof(int64_t) : sizeof(float);
+                if (e.columns[c] % bar_file::column_alignment != 0) fail("misaligned column");
+                if (e.columns[c] > size_ || e.bars > (size_ - e.columns[c]) / width) fail("column past the end of the file");
+            }
+        }
+    }
+
+    void release() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (data_ != nullptr) ::munmap(const_cast<char*>(data_), size_);
+#endif
+        data_ = nullptr;
+    }
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#if !(defined(__unix__) || defined(__APPLE__))
+    AlignedBuffer<char> copy_;
+#endif
+};
+
+
+namespace bar_file {
+
+// The same bars as CSV, one row per bar: symbol,timestamp,open,high,low,close,volume.
+inline void write_csv(const std::string& path, const std::vector<Symbol>& symbols) {
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (f == nullptr) throw std::runtime_error("bar_file: cannot create " + path);
+    for (const Symbol& s : symbols) {
+        for (size_t i = 0; i < s.bars.closes.size(); ++i) {
+            std::fprintf(f, "%s,%lld,%.9g,%.9g,%.9g,%.9g,%.9g\n", s.name.c_str(),
+                         static_cast<long long>(s.timestamps[i]), s.bars.opens[i], s.bars.highs[i],
+                         s.bars.lows[i], s.bars.closes[i], s.bars.volumes.empty() ? 0.0f : s.bars.volumes[i]);
+        }
+    }
+    std::fclose(f);
+}
+
+// Reads a whole file into memory.
+inline std::string slurp(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) throw std::runtime_error("bar_file: cannot open " + path);
+    std::string text(static_cast<size_t>(in.tellg()), '\0');
+    in.seekg(0);
+    in.read(text.data(), static_cast<std::streamsize>(text.size()));
+    return text;
+}
+
+// Parses write_csv output back into symbols, with std::from_chars. Rows of a symbol
+// must be contiguous.
+inline std::vector<Symbol> read_csv(const std::string& path) {
+    const std::string text = slurp(path);
+    std::vector<Symbol> symbols;
+    const char* p = text.data();
+    const char* const end = p + text.size();
+    while (p < end) {
+        const char* comma = static_cast<const char*>(std::memchr(p, ',', static_cast<size_t>(end - p)));
+        if (comma == nullptr) break;
+        const std::string_view name(p, static_cast<size_t>(comma - p));
+        if (symbols.empty() || symbols.back().name != name) {
+            symbols.push_back(Symbol{std::string(name), {}, {}});
+        }
+        Symbol& s = symbols.back();
+        p = comma + 1;
+        int64_t timestamp = 0;
+        p = std::from_chars(p, end, timestamp).ptr + 1;
+        float v[5];
+        for (float& x : v) {
+            p = std::from_chars(p, end, x).ptr + 1;
+        }
+        s.timestamps.push_back(timestamp);
+        s.bars.opens.push_back(v[0]);
+        s.bars.highs.push_back(v[1]);
+        s.bars.lows.push_back(v[2]);
+        s.bars.closes.push_back(v[3]);
+        s.bars.volumes.push_back(v[4]);
+    }
+    return symbols;
+}
+
+// Reads a bar file the ordinary way: every column copied into vectors.
+inline std::vector<Symbol> read_into_vectors(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("bar_file: cannot open " + path);
+    Header header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("bar_file: " + path + ": not a bar file");
+    }
+    std::vector<SymbolEntry> entries(header.symbol_count);
+    in.read(reinterpret_cast<char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(SymbolEntry)));
+
+    std::vector<Symbol> symbols(entries.size());
+    for (size_t k = 0; k < entries.size(); ++k) {
+        const SymbolEntry& e = entries[k];
+        Symbol& s = symbols[k];
+        s.name.assign(e.name, strnlen(e.name, sizeof(e.name)));
+        auto read = [&](auto& column, Column c) {
+            column.resize(e.bars);
+            in.seekg(static_cast<std::streamoff>(e.columns[c]));
+            in.read(reinterpret_cast<char*>(column.data()), static_cast<std::streamsize>(e.bars * sizeof(column[0])));
+        };
+        read(s.timestamps, Timestamps);
+        read(s.bars.opens, Opens);
+        read(s.bars.highs, Highs);
+        read(s.bars.lows, Lows);
+        read(s.bars.closes, Closes);
+        read(s.bars.volumes, Volumes);
+    }
+    if (!in) throw std::runtime_error("bar_file: " + path + ": truncated");
+    return symbols;
+}
+
+}
+
+
+// Startup: from a file on disk to the ADX of every symbol, for 1000 symbols of ten
+// years of daily bars (2520 each, 60MB as columns). The files come from the page
+// cache, so this is the cost of parsing and copying rather than of the disk. They are
+// written once, under a name unique to the run, and removed when the program exits.
+class BarFileBenchmark : public AllocCountingFixture {
+public:
+    struct TempFile {
+        std::string path;
+        ~TempFile() {
+            std::error_code ignored;
+            if (!path.empty()) std::filesystem::remove(path, ignored);
+        }
+    };
+
+    void SetUp(const ::benchmark::State& state) override {
+        if (binary_file.path.empty()) {
+            const auto dir = std::filesystem::temp_directory_path();
+            const std::string name = "hft_patterns_bars_" + std::to_string(std::random_device{}());
+            binary_file.path = (dir / (name + ".bin")).string();
+            csv_file.path = (dir / (name + ".csv")).string();
+            std::vector<bar_file::Symbol> symbols(n_symbols);
+            for (size_t k = 0; k < n_symbols; ++k) {
+                symbols[k].name = "SYM" + std::to_string(k);
+                symbols[k].bars = generateSOVData(n_bars);
+                symbols[k].bars.volumes.assign(n_bars, 1000.0f);
+                symbols[k].timestamps.resize(n_bars);
+                for (size_t i = 0; i < n_bars; ++i) {
+                    symbols[k].timestamps[i] = static_cast<int64_t>(i) * 86400000000000;
+                }
+            }
+            bar_file::write(binary_file.path, symbols);
+            bar_file::write_csv(csv_file.path, symbols);
+        }
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    static const size_t n_symbols = 1000;
+    static const size_t n_bars = 2520;
+    static inline TempFile binary_file;
+    static inline TempFile csv_file;
+};
+
+
+BENCHMARK_F(BarFileBenchmark, BM_LoadCSV)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        const std::vector<bar_file::Symbol> symbols = bar_file::read_csv(csv_file.path);
+        float sum = 0.0f;
+        for (const bar_file::Symbol& s : symbols) sum += SOV::ADX(s.bars);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_symbols * n_bars));
+}
+
+BENCHMARK_F(BarFileBenchmark, BM_LoadVectors)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        const std::vector<bar_file::Symbol> symbols = bar_file::read_into_vectors(binary_file.path);
+        float sum = 0.0f;
+        for (const bar_file::Symbol& s : symbols) sum += SOV::ADX(s.bars);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_symbols * n_bars));
+}
+
+BENCHMARK_F(BarFileBenchmark, BM_MapFile)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        const BarFile file(binary_file.path);
+        float sum = 0.0f;
+        for (size_t k = 0; k < file.size(); ++k) sum += SOV::ADX(file.bars(k));
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_symbols * n_bars));
+}
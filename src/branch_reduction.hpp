@@ -1,14 +1,17 @@
 #pragma once
 
 #include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
 
 
 #ifdef _MSC_VER
     #define LIKELY(x)   (x)
     #define UNLIKELY(x) (x)
+    #define UNREACHABLE() __assume(0)
 #else
     #define LIKELY(x)   (__builtin_expect(!!(x), 1))
     #define UNLIKELY(x) (__builtin_expect(!!(x), 0))
+    #define UNREACHABLE() __builtin_unreachable()
 #endif
 
 
@@ -97,13 +100,13 @@ ErrorFlags checkForErrors()
 
 void handleErrors(ErrorFlags errors)
 {
-    if (errors && ErrorFlags::ErrorA) {
+    if (errors & ErrorFlags::ErrorA) {
         handleErrorA();
     }
-    if (errors && ErrorFlags::ErrorB) {
+    if (errors & ErrorFlags::ErrorB) {
         handleErrorB();
     }
-    if (errors && ErrorFlags::ErrorC) {
+    if (errors & ErrorFlags::ErrorC) {
         handleErrorC();
     }
 }
@@ -122,7 +125,7 @@ void doFn() {
 }
 
 
-class BranchReductionBenchmark : public benchmark::Fixture
+class BranchReductionBenchmark : public AllocCountingFixture
 {
 public:
     void SetUp(const ::benchmark::State& state) override {
@@ -138,7 +141,7 @@ public:
 
 BENCHMARK_F(BranchReductionBenchmark, Branching)(benchmark::State& state)
 {
-    for (auto _ : state)
+    for (auto _ : alloc_counter::counted(state))
     {
         for (size_t i=0; i<nLoops; ++i) {
             branching::doFn();
@@ -149,7 +152,7 @@ BENCHMARK_F(BranchReductionBenchmark, Branching)(benchmark::State& state)
 
 BENCHMARK_F(BranchReductionBenchmark, BranchReduction)(benchmark::State& state)
 {
-    for (auto _ : state)
+    for (auto _ : alloc_counter::counted(state))
     {
         for (size_t i=0; i<nLoops; ++i) {
             branchreduction::doFn();
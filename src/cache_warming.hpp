@@ -1,6 +1,7 @@
 #pragma once
 
 #include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
 #include <vector>
 #include <algorithm>
 
@@ -10,7 +11,7 @@ std::vector<int> data(kSize);
 std::vector<int> indices(kSize);
 
 
-class CacheBenchmark : public benchmark::Fixture {
+class CacheBenchmark : public AllocCountingFixture {
 public:
     void SetUp(const ::benchmark::State& state) override {
 
@@ -27,7 +28,7 @@ BENCHMARK_F(CacheBenchmark, BM_CacheCold)(benchmark::State& state) {
         index = rand() % kSize;
     }
 
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         int sum = 0;
         for (int i = 0; i < kSize; ++i) {
             benchmark::DoNotOptimize(sum += data[indices[i]]);
@@ -43,7 +44,7 @@ BENCHMARK_F(CacheBenchmark, BM_CacheWarm)(benchmark::State& state) {
     }
     benchmark::ClobberMemory();
 
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         int sum = 0;
         for (int i = 0; i < kSize; ++i) {
             benchmark::DoNotOptimize(sum += data[i]);
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+# include <intrin.h>
+#elif defined(__GNUC__) || defined(__clang__)
+# include <cpuid.h>
+#else
+# error "cpuid not supported on this compiler"
+#endif
+
+
+// What the host CPU (and OS, for the wider register files) supports. Detected once,
+// on first use.
+struct CpuFeatures {
+    bool sse2 = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool bmi1 = false;
+    bool bmi2 = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+    bool avx512dq = false;
+    bool avx512vl = false;
+};
+
+
+namespace cpu_features_detail {
+
+inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<uint32_t>(out[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+inline uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+inline CpuFeatures detect() {
+    CpuFeatures features;
+    uint32_t regs[4];
+
+    cpuid(0, 0, regs);
+    const uint32_t max_leaf = regs[0];
+    if (max_leaf < 1) return features;
+
+    cpuid(1, 0, regs);
+    const uint32_t ecx1 = regs[2];
+    const uint32_t edx1 = regs[3];
+    features.sse2 = (edx1 >> 26) & 1;
+
+    // The OS has to save the YMM (and for AVX-512, the opmask and ZMM) state.
+    const bool osxsave = (ecx1 >> 27) & 1;
+    const uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+    const bool os_avx = (xcr0 & 0x6) == 0x6;
+    const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+    const bool avx = os_avx && ((ecx1 >> 28) & 1);
+    features.fma = avx && ((ecx1 >> 12) & 1);
+
+    if (max_leaf < 7) return features;
+    cpuid(7, 0, regs);
+    const uint32_t ebx7 = regs[1];
+    features.avx2 = avx && ((ebx7 >> 5) & 1);
+    features.bmi1 = (ebx7 >> 3) & 1;
+    features.bmi2 = (ebx7 >> 8) & 1;
+    features.avx512f = os_avx512 && ((ebx7 >> 16) & 1);
+    features.avx512dq = features.avx512f && ((ebx7 >> 17) & 1);
+    features.avx512bw = features.avx512f && ((ebx7 >> 30) & 1);
+    features.avx512vl = features.avx512f && ((ebx7 >> 31) & 1);
+    return features;
+}
+
+}
+
+
+inline const CpuFeatures& cpu_features() {
+    static const CpuFeatures features = cpu_features_detail::detect();
+    return features;
+}
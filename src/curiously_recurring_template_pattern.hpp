@@ -1,6 +1,7 @@
 #pragma once
 
 #include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
 
 
 namespace polymorphic 
@@ -56,7 +57,7 @@ int doAdd(Base<Derived>* base, int times) {
 }
 
 
-class CRTPBenchmark : public benchmark::Fixture {
+class CRTPBenchmark : public AllocCountingFixture {
 public:
     void SetUp(const ::benchmark::State& state) override {
 
@@ -73,7 +74,7 @@ BENCHMARK_F(CRTPBenchmark, Polymorphism)(benchmark::State& state)
     polymorphic::Derived d;
     polymorphic::Base* base = &d;
     int result = 0;
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         result += doAdd(base, 1000);
     }
     benchmark::DoNotOptimize(result);
@@ -84,7 +85,7 @@ BENCHMARK_F(CRTPBenchmark, CRTP)(benchmark::State& state)
     CRTP::Derived d;
 
     int result = 0;
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         result += CRTP::doAdd(&d, 1000);
     }
     benchmark::DoNotOptimize(result);
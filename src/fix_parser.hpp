@@ -0,0 +1,451 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "simd_dispatch.hpp"
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+// Decoding tag=value FIX: find the SOH and '=' delimiters, then turn prices and
+// quantities into int64 ticks. The SIMD versions are KernelTable::fix_split and
+// KernelTable::parse_ticks (simd_fix.hpp); the baselines here walk the bytes one at
+// a time and parse numbers with strtol or std::from_chars.
+namespace fix {
+
+constexpr char soh = '\x01';
+constexpr int price_decimals = 4;
+
+// Tags whose values are decoded into ticks, and their scale.
+inline int decimals_for(uint32_t tag) {
+    switch (tag) {
+    case 31:    // LastPx
+    case 44:    // Price
+    case 6:     // AvgPx
+    case 270:   // MDEntryPx
+        return price_decimals;
+    case 14:    // CumQty
+    case 32:    // LastQty
+    case 38:    // OrderQty
+    case 151:   // LeavesQty
+    case 271:   // MDEntrySize
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+// buffer ends with fix_padding zero bytes, for the SIMD kernels.
+struct Corpus {
+    std::string buffer;
+    std::vector<std::string_view> messages;
+
+    size_t bytes() const { return buffer.size() - simd_kernels::fix_padding; }
+};
+
+// New orders, execution reports and market data snapshots with 1 to 10 entries, in
+// roughly the mix a gateway sees. The 9= and 10= values are placeholders; nothing
+// here checks them.
+inline Corpus make_corpus(size_t count, uint32_t seed = 42) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> kind(0, 9);
+    std::uniform_int_distribution<int> price(50000, 2000000);    // 5.0000 to 200.0000
+    std::uniform_int_distribution<int> quantity(1, 100000);
+    std::uniform_int_distribution<int> entries(1, 10);
+    const char* symbols[] = {"AAPL", "MSFT", "ES", "EURUSD", "VOD.L", "7203.T"};
+
+    auto px = [&](std::string& out) {
+        const int ticks = price(rng);
+        out += std::to_string(ticks / 10000);
+        const int fraction = ticks % 10000;
+        if (fraction != 0) {
+            out += '.';
+            out += std::to_string(10000 + fraction).substr(1);
+            while (out.back() == '0') out.pop_back();
+        }
+    };
+    auto field = [&](std::string& out, int tag, const std::string& value) {
+        out += std::to_string(tag);
+        out += '=';
+        out += value;
+        out += soh;
+    };
+
+    Corpus corpus;
+    std::vector<std::pair<size_t, size_t>> spans;
+    for (size_t i = 0; i < count; ++i) {
+        std::string m;
+        field(m, 8, "FIX.4.4");
+        field(m, 9, "000");
+        const int k = kind(rng);
+        const char* symbol = symbols[rng() % 6];
+        std::string p;
+        if (k < 3) {
+            field(m, 35, "D");
+            field(m, 49, "CLIENT1");
+            field(m, 56, "EXCH");
+            field(m, 34, std::to_string(i + 1));
+            field(m, 52, "20260101-12:34:56.789");
+            field(m, 11, "ORD" + std::to_string(rng() % 1000000));
+            field(m, 55, symbol);
+            field(m, 54, std::to_string(1 + rng() % 2));
+            field(m, 38, std::to_string(quantity(rng)));
+            field(m, 40, "2");
+            px(p); field(m, 44, p);
+            field(m, 59, "0");
+        } else if (k < 6) {
+            field(m, 35, "8");
+            field(m, 49, "EXCH");
+            field(m, 56, "CLIENT1");
+            field(m, 34, std::to_string(i + 1));
+            field(m, 52, "20260101-12:34:56.789");
+            field(m, 37, std::to_string(rng() % 100000000));
+            field(m, 17, "EX" + std::to_string(rng() % 100000000));
+            field(m, 150, "F");
+            field(m, 39, "1");
+            field(m, 55, symbol);
+            field(m, 54, "1");
+            px(p); field(m, 31, p);
+            field(m, 32, std::to_string(quantity(rng)));
+            field(m, 151, std::to_string(quantity(rng)));
+            field(m, 14, std::to_string(quantity(rng)));
+            p.clear(); px(p); field(m, 6, p);
+        } else {
+            field(m, 35, "X");
+            field(m, 49, "EXCH");
+            field(m, 56, "FEED");
+            field(m, 34, std::to_string(i + 1));
+            field(m, 52, "20260101-12:34:56.789");
+            const int n = entries(rng);
+            field(m, 268, std::to_string(n));
+            for (int e = 0; e < n; ++e) {
+                field(m, 279, std::to_string(rng() % 3));
+                field(m, 269, std::to_string(rng() % 2));
+                field(m, 55, symbol);
+                p.clear(); px(p); field(m, 270, p);
+                field(m, 271, std::to_string(quantity(rng)));
+            }
+        }
+        field(m, 10, "000");
+        spans.emplace_back(corpus.buffer.size(), m.size());
+        corpus.buffer += m;
+    }
+    corpus.buffer.append(simd_kernels::fix_padding, '\0');
+    for (const auto& [offset, length] : spans) {
+        corpus.messages.emplace_back(corpus.buffer.data() + offset, length);
+    }
+    return corpus;
+}
+
+
+// Byte-at-a-time version of KernelTable::fix_split, with the same output.
+inline size_t split_scalar(const char* data, size_t n, simd_kernels::FixField* fields, size_t max_fields) {
+    size_t count = 0;
+    size_t i = 0;
+    while (i < n && count < max_fields) {
+        uint32_t tag = 0;
+        size_t j = i;
+        for (; j < n && data[j] != '=' && data[j] != soh; ++j) {
+            tag = tag * 10 + static_cast<uint32_t>(data[j] - '0');
+        }
+        if (j == n) break;
+        if (data[j] == soh) {
+            i = j + 1;
+            continue;
+        }
+        const size_t value = j + 1;
+        size_t end = value;
+        while (end < n && data[end] != soh) ++end;
+        if (end == n) break;
+        fields[count++] = {tag, static_cast<uint32_t>(value), static_cast<uint32_t>(end - value)};
+        i = end + 1;
+    }
+    return count;
+}
+
+constexpr int64_t powers_of_ten[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+inline bool is_digit(char c) {
+    return static_cast<unsigned>(c - '0') <= 9;
+}
+
+// Both baselines read the text the way KernelTable::parse_ticks does: an optional
+// '-', the whole digits, then after a '.' at most decimals fraction digits, with the
+// rest dropped. Values that do not fit in int64 are out of range for every parser.
+//
+// strtol needs a terminator, so the digits it parses are copied out first: the whole
+// part without its leading zeros and the kept fraction digits, as one number that is
+// then scaled. Anything in range fits in text.
+inline int64_t parse_ticks_strtol(const char* s, size_t len, int decimals) {
+    const char* const end = s + len;
+    const bool negative = s != end && *s == '-';
+    const char* p = s + negative;
+    while (p != end && *p == '0') ++p;
+    char text[32];
+    size_t n = 0;
+    for (; p != end && is_digit(*p) && n < 19; ++p) text[n++] = *p;
+    int digits = 0;
+    if (p != end && *p == '.') {
+        for (++p; p != end && digits < decimals && is_digit(*p); ++p, ++digits) text[n++] = *p;
+    }
+    text[n] = '\0';
+    const int64_t ticks = std::strtoll(text, nullptr, 10) * powers_of_ten[decimals - digits];
+    return negative ? -ticks : ticks;
+}
+
+// from_chars takes no '-' in front of a '.', so the sign is handled here, and the
+// fraction is parsed from at most decimals digits.
+inline int64_t parse_ticks_from_chars(const char* s, size_t len, int decimals) {
+    const char* const end = s + len;
+    const bool negative = s != end && *s == '-';
+    uint64_t whole = 0;
+    const char* const p = std::from_chars(s + negative, end, whole).ptr;
+    uint64_t ticks = whole * powers_of_ten[decimals];
+    if (p != end && *p == '.') {
+        const char* const fraction_end = end - (p + 1) > decimals ? p + 1 + decimals : end;
+        uint64_t fraction = 0;
+        const char* const q = std::from_chars(p + 1, fraction_end, fraction).ptr;
+        ticks += fraction * powers_of_ten[decimals - (q - p - 1)];
+    }
+    return negative ? -static_cast<int64_t>(ticks) : static_cast<int64_t>(ticks);
+}
+
+struct Number {
+    const char* text;
+    uint32_t length;
+    int decimals;
+};
+
+// Parses numbers, and texts at the edges of the format at every scale, with both
+// baselines and every supported KernelTable::parse_ticks. Returns the first text they
+// do not all agree on, or an empty string.
+inline std::string find_parse_mismatch(std::vector<Number> numbers) {
+    static const char* const edge_cases[] = {
+        "0", "-0", "7", "-7", "", "-", ".", "-.", ".5", "-.5", "5.", "3.14159", "007.50",
+        "12.5x", "1.2.3", "+5", "--5", "99999999.99999999", "-1234567890.4567",
+        "0.1234567890123456789", "0000000000000000000000000000000000000042.125",
+    };
+    std::string buffer;
+    for (const char* text : edge_cases) buffer += text;
+    buffer.append(simd_kernels::fix_padding, '\0');
+    size_t offset = 0;
+    for (const char* text : edge_cases) {
+        const uint32_t length = static_cast<uint32_t>(std::string_view(text).size());
+        for (int decimals : {0, 2, 4, 8}) {
+            numbers.push_back({buffer.data() + offset, length, decimals});
+        }
+        offset += length;
+    }
+
+    for (const Number& number : numbers) {
+        const int64_t expected = parse_ticks_from_chars(number.text, number.length, number.decimals);
+        bool agree = parse_ticks_strtol(number.text, number.length, number.decimals) == expected;
+        for (simd_kernels::Isa isa : {simd_kernels::Isa::SSE2, simd_kernels::Isa::AVX2, simd_kernels::Isa::AVX512}) {
+            if (simd_kernels::supported(isa)) {
+                agree &= simd_kernels::table(isa).parse_ticks(number.text, number.length, number.decimals) == expected;
+            }
+        }
+        if (!agree) return std::string(number.text, number.length) + " at " + std::to_string(number.decimals) + " decimals";
+    }
+    return {};
+}
+
+// Splits every message in the corpus with split_scalar and every supported
+// KernelTable::fix_split. Returns the first message and kernel whose fields differ,
+// or an empty string.
+inline std::string find_split_mismatch(const Corpus& corpus, size_t max_fields) {
+    std::vector<simd_kernels::FixField> expected(max_fields), actual(max_fields);
+    for (simd_kernels::Isa isa : {simd_kernels::Isa::SSE2, simd_kernels::Isa::AVX2, simd_kernels::Isa::AVX512}) {
+        if (!simd_kernels::supported(isa)) continue;
+        const simd_kernels::KernelTable& kernels = simd_kernels::table(isa);
+        for (size_t m = 0; m < corpus.messages.size(); ++m) {
+            const std::string_view message = corpus.messages[m];
+            const size_t count = split_scalar(message.data(), message.size(), expected.data(), max_fields);
+            bool agree = kernels.fix_split(message.data(), message.size(), actual.data(), max_fields) == count;
+            for (size_t i = 0; agree && i < count; ++i) {
+                agree = actual[i].tag == expected[i].tag && actual[i].offset == expected[i].offset &&
+                        actual[i].length == expected[i].length;
+            }
+            if (!agree) return "message " + std::to_string(m) + " with " + kernels.name;
+        }
+    }
+    return {};
+}
+
+}
+
+
+class FixParserBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        if (!corpus.messages.empty()) return;
+        corpus = fix::make_corpus(message_count);
+        fields.resize(max_fields);
+        for (std::string_view message : corpus.messages) {
+            const size_t count = fix::split_scalar(message.data(), message.size(), fields.data(), max_fields);
+            for (size_t i = 0; i < count; ++i) {
+                const int decimals = fix::decimals_for(fields[i].tag);
+                if (decimals >= 0) {
+                    numbers.push_back({message.data() + fields[i].offset, fields[i].length, decimals});
+                }
+            }
+        }
+        parse_mismatch = fix::find_parse_mismatch(numbers);
+        split_mismatch = fix::find_split_mismatch(corpus, max_fields);
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    static constexpr size_t message_count = 10000;
+    static constexpr size_t max_fields = 64;
+    fix::Corpus corpus;
+    std::vector<simd_kernels::FixField> fields;
+    std::vector<fix::Number> numbers;
+    std::string parse_mismatch;
+    std::string split_mismatch;
+};
+
+
+BENCHMARK_DEFINE_F(FixParserBenchmark, BM_SplitScalar)(benchmark::State& state) {
+    if (!split_mismatch.empty()) {
+        state.SkipWithError(("splitters disagree on " + split_mismatch).c_str());
+        return;
+    }
+    for (auto _ : alloc_counter::counted(state)) {
+        size_t total = 0;
+        for (std::string_view message : corpus.messages) {
+            total += fix::split_scalar(message.data(), message.size(), fields.data(), max_fields);
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(corpus.bytes()));
+}
+BENCHMARK_REGISTER_F(FixParserBenchmark, BM_SplitScalar);
+
+BENCHMARK_DEFINE_F(FixParserBenchmark, BM_SplitSIMD)(benchmark::State& state) {
+    if (!split_mismatch.empty()) {
+        state.SkipWithError(("splitters disagree on " + split_mismatch).c_str());
+        return;
+    }
+    const simd_kernels::KernelTable& kernels = simd_kernels::table_for(state);
+    for (auto _ : alloc_counter::counted(state)) {
+        size_t total = 0;
+        for (std::string_view message : corpus.messages) {
+            total += kernels.fix_split(message.data(), message.size(), fields.data(), max_fields);
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(corpus.bytes()));
+    state.SetLabel(kernels.name);
+}
+BENCHMARK_REGISTER_F(FixParserBenchmark, BM_SplitSIMD)->Apply(simd_kernels::supported_isa_args);
+
+
+// Every price and quantity in the corpus, as ticks.
+BENCHMARK_DEFINE_F(FixParserBenchmark, BM_ParseTicksStrtol)(benchmark::State& state) {
+    if (!parse_mismatch.empty()) {
+        state.SkipWithError(("parsers disagree on " + parse_mismatch).c_str());
+        return;
+    }
+    for (auto _ : alloc_counter::counted(state)) {
+        int64_t sum = 0;
+        for (const fix::Number& number : numbers) {
+            sum += fix::parse_ticks_strtol(number.text, number.length, number.decimals);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(numbers.size()));
+}
+BENCHMARK_REGISTER_F(FixParserBenchmark, BM_ParseTicksStrtol);
+
+BENCHMARK_DEFINE_F(FixParserBenchmark, BM_ParseTicksFromChars)(benchmark::State& state) {
+    if (!parse_mismatch.empty()) {
+        state.SkipWithError(("parsers disagree on " + parse_mismatch).c_str());
+        return;
+    }
+    for (auto _ : alloc_counter::counted(state)) {
+        int64_t sum = 0;
+        for (const fix::Number& number : numbers) {
+            sum += fix::parse_ticks_from_chars(number.text, number.length, number.decimals);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(numbers.size()));
+}
+BENCHMARK_REGISTER_F(FixParserBenchmark, BM_ParseTicksFromChars);
+
+BENCHMARK_DEFINE_F(FixParserBenchmark, BM_ParseTicksSIMD)(benchmark::State& state) {
+    if (!parse_mismatch.empty()) {
+        state.SkipWithError(("parsers disagree on " + parse_mismatch).c_str());
+        return;
+    }
+    const simd_kernels::KernelTable& kernels = simd_kernels::table_for(state);
+    for (auto _ : alloc_counter::counted(state)) {
+        int64_t sum = 0;
+        for (const fix::Number& number : numbers) {
+            sum += kernels.parse_ticks(number.text, number.length, number.decimals);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(numbers.size()));
+    state.SetLabel(kernels.name);
+}
+BENCHMARK_REGISTER_F(FixParserBenchmark, BM_ParseTicksSIMD)->Apply(simd_kernels::supported_isa_args);
+
+
+// Split every message and decode its prices and quantities.
+BENCHMARK_DEFINE_F(FixParserBenchmark, BM_DecodeFromChars)(benchmark::State& state) {
+    if (!split_mismatch.empty() || !parse_mismatch.empty()) {
+        const std::string error = split_mismatch.empty() ? "parsers disagree on " + parse_mismatch
+                                                         : "splitters disagree on " + split_mismatch;
+        state.SkipWithError(error.c_str());
+        return;
+    }
+    for (auto _ : alloc_counter::counted(state)) {
+        int64_t sum = 0;
+        for (std::string_view message : corpus.messages) {
+            const size_t count = fix::split_scalar(message.data(), message.size(), fields.data(), max_fields);
+            for (size_t i = 0; i < count; ++i) {
+                const int decimals = fix::decimals_for(fields[i].tag);
+                if (decimals >= 0) {
+                    sum += fix::parse_ticks_from_chars(message.data() + fields[i].offset, fields[i].length, decimals);
+                }
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(corpus.bytes()));
+}
+BENCHMARK_REGISTER_F(FixParserBenchmark, BM_DecodeFromChars);
+
+BENCHMARK_DEFINE_F(FixParserBenchmark, BM_DecodeSIMD)(benchmark::State& state) {
+    if (!split_mismatch.empty() || !parse_mismatch.empty()) {
+        const std::string error = split_mismatch.empty() ? "parsers disagree on " + parse_mismatch
+                                                         : "splitters disagree on " + split_mismatch;
+        state.SkipWithError(error.c_str());
+        return;
+    }
+    const simd_kernels::KernelTable& kernels = simd_kernels::table_for(state);
+    for (auto _ : alloc_counter::counted(state)) {
+        int64_t sum = 0;
+        for (std::string_view message : corpus.messages) {
+            const size_t count = kernels.fix_split(message.data(), message.size(), fields.data(), max_fields);
+            for (size_t i = 0; i < count; ++i) {
+                const int decimals = fix::decimals_for(fields[i].tag);
+                if (decimals >= 0) {
+                    sum += kernels.parse_ticks(message.data() + fields[i].offset, fields[i].length, decimals);
+                }
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(corpus.bytes()));
+    state.SetLabel(kernels.name);
+}
+BENCHMARK_REGISTER_F(FixParserBenchmark, BM_DecodeSIMD)->Apply(simd_kernels::supported_isa_args);
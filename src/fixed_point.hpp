@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+// Fixed-point arithmetic for the tick-price indicators (tick_indicators.hpp), shared
+// with the SIMD kernel adx_lanes_ticks so both round the same way. Prices are int64
+// ticks. Smoothed values are Q8: ticks scaled by 2^fraction_bits.
+//
+// Dividing by the period becomes a multiply by a 24-bit reciprocal and a rounding
+// shift. The one division that stays is the DX ratio. It is done in double, which
+// is exact for these integer inputs and correctly rounded, so every build gives the
+// same bits.
+//
+// Limits: true ranges below 2^29 ticks (max_true_range) and periods below 2^12.
+// Within them nothing overflows and every int64 <-> double conversion is exact.
+namespace fixed {
+
+constexpr int fraction_bits = 8;
+constexpr int reciprocal_bits = 24;
+constexpr int64_t max_true_range = int64_t(1) << 29;
+constexpr int64_t hundred = int64_t(100) << fraction_bits;
+
+// round(2^reciprocal_bits / period).
+inline int64_t reciprocal(size_t period) {
+    return ((int64_t(1) << reciprocal_bits) + static_cast<int64_t>(period / 2)) / static_cast<int64_t>(period);
+}
+
+// x / period, rounded, for 0 <= x < 2^(63 - reciprocal_bits) * period.
+inline int64_t divide(int64_t x, int64_t recip) {
+    return (x * recip + (int64_t(1) << (reciprocal_bits - 1))) >> reciprocal_bits;
+}
+
+// One step of Wilder smoothing, (s * (period - 1) + x) / period, with s and x in the
+// same scale.
+inline int64_t wilder(int64_t s, int64_t x, int64_t period_minus_1, int64_t recip) {
+    return divide(s * period_minus_1 + x, recip);
+}
+
+// Round to nearest, for 0 <= d < 2^52, the way the vector to_int64 does it.
+inline int64_t round_to_int64(double d) {
+    d += 0x1p52;
+    int64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    return bits ^ 0x4330000000000000;
+}
+
+// DX = 100 * |plus - minus| / (plus + minus) in Q8, from smoothed +DM and -DM (the
+// smoothed TR cancels). 0 where both are 0; the float path gives NaN there.
+inline int64_t dx(int64_t plus, int64_t minus) {
+    const int64_t sum = plus + minus;
+    if (sum == 0) return 0;
+    const int64_t diff = plus > minus ? plus - minus : minus - plus;
+    return round_to_int64(static_cast<double>(diff * hundred) / static_cast<double>(sum));
+}
+
+inline float to_float(int64_t q8) {
+    return static_cast<float>(q8) * (1.0f / (1 << fraction_bits));
+}
+
+}
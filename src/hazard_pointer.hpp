@@ -1,6 +1,7 @@
 #pragma once
 
 #include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
 #include <atomic>
 #include <memory>
 #include <mutex>
@@ -112,7 +113,7 @@ public:
 
 
 
-class HazardPointerBenchmark : public benchmark::Fixture
+class HazardPointerBenchmark : public AllocCountingFixture
 {
 public:
     void SetUp(const ::benchmark::State& state) override {
@@ -141,7 +142,7 @@ BENCHMARK_F(HazardPointerBenchmark, Locking)(benchmark::State& state) {
     };
 
     std::vector<std::thread> threads;
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         threads.clear();
         for (int i = 0; i < nThreads; ++i) {
             threads.emplace_back(run_insert_delete);
@@ -166,7 +167,7 @@ BENCHMARK_F(HazardPointerBenchmark, NonLocking)(benchmark::State& state) {
     };
 
     std::vector<std::thread> threads;
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         threads.clear();
         for (int i = 0; i < nThreads; ++i) {
             threads.emplace_back(run_insert_delete);
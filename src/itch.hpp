@@ -0,0 +1,391 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "branch_reduction.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string_view>
+#include <vector>
+#ifdef _MSC_VER
+    #include <stdlib.h>
+#endif
+
+
+// Decoding a binary, big-endian market data feed modelled on Nasdaq TotalView-ITCH
+// 5.0: each message is a 2-byte length followed by that many bytes, the first of which
+// is the message type. The message structs below are views over the buffer, not
+// copies; each accessor loads its field and byteswaps it, so only the fields a handler
+// reads are ever decoded. Offsets and sizes are ITCH 5.0's.
+namespace itch {
+
+#ifdef _MSC_VER
+    inline uint16_t bswap(uint16_t v) { return _byteswap_ushort(v); }
+    inline uint32_t bswap(uint32_t v) { return _byteswap_ulong(v); }
+    inline uint64_t bswap(uint64_t v) { return _byteswap_uint64(v); }
+#else
+    inline uint16_t bswap(uint16_t v) { return __builtin_bswap16(v); }
+    inline uint32_t bswap(uint32_t v) { return __builtin_bswap32(v); }
+    inline uint64_t bswap(uint64_t v) { return __builtin_bswap64(v); }
+#endif
+
+// Big-endian field at p. The memcpy is a single unaligned load.
+template<typename T>
+T load_be(const uint8_t* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return bswap(v);
+}
+
+template<typename T>
+void store_be(uint8_t* p, T v) {
+    v = bswap(v);
+    std::memcpy(p, &v, sizeof(T));
+}
+
+// Every message starts with the type, the stock locate (a dense instrument index),
+// a tracking number, and nanoseconds since midnight in 6 bytes.
+struct Message {
+    const uint8_t* data;
+
+    char type() const { return static_cast<char>(data[0]); }
+    uint16_t stock_locate() const { return load_be<uint16_t>(data + 1); }
+    uint16_t tracking_number() const { return load_be<uint16_t>(data + 3); }
+    uint64_t timestamp() const {
+        return uint64_t(load_be<uint16_t>(data + 5)) << 32 | load_be<uint32_t>(data + 7);
+    }
+};
+
+struct SystemEvent : Message {
+    static constexpr char id = 'S';
+    static constexpr size_t size = 12;
+    char event_code() const { return static_cast<char>(data[11]); }
+};
+
+struct AddOrder : Message {
+    static constexpr char id = 'A';
+    static constexpr size_t size = 36;
+    uint64_t order_reference() const { return load_be<uint64_t>(data + 11); }
+    bool buy() const { return data[19] == 'B'; }
+    uint32_t shares() const { return load_be<uint32_t>(data + 20); }
+    std::string_view stock() const { return {reinterpret_cast<const char*>(data + 24), 8}; }
+    uint32_t price() const { return load_be<uint32_t>(data + 32); }   // 4 implied decimals
+};
+
+// AddOrder with the market participant attributed.
+struct AddOrderMPID : AddOrder {
+    static constexpr char id = 'F';
+    static constexpr size_t size = 40;
+    std::string_view attribution() const { return {reinterpret_cast<const char*>(data + 36), 4}; }
+};
+
+struct OrderExecuted : Message {
+    static constexpr char id = 'E';
+    static constexpr size_t size = 31;
+    uint64_t order_reference() const { return load_be<uint64_t>(data + 11); }
+    uint32_t executed_shares() const { return load_be<uint32_t>(data + 19); }
+    uint64_t match_number() const { return load_be<uint64_t>(data + 23); }
+};
+
+struct OrderExecutedWithPrice : OrderExecuted {
+    static constexpr char id = 'C';
+    static constexpr size_t size = 36;
+    bool printable() const { return data[31] == 'Y'; }
+    uint32_t execution_price() const { return load_be<uint32_t>(data + 32); }
+};
+
+struct OrderCancel : Message {
+    static constexpr char id = 'X';
+    static constexpr size_t size = 23;
+    uint64_t order_reference() const { return load_be<uint64_t>(data + 11); }
+    uint32_t cancelled_shares() const { return load_be<uint32_t>(data + 19); }
+};
+
+struct OrderDelete : Message {
+    static constexpr char id = 'D';
+    static constexpr size_t size = 19;
+    uint64_t order_reference() const { return load_be<uint64_t>(data + 11); }
+};
+
+struct OrderReplace : Message {
+    static constexpr char id = 'U';
+    static constexpr size_t size = 35;
+    uint64_t original_order_reference() const { return load_be<uint64_t>(data + 11); }
+    uint64_t new_order_reference() const { return load_be<uint64_t>(data + 19); }
+    uint32_t shares() const { return load_be<uint32_t>(data + 27); }
+    uint32_t price() const { return load_be<uint32_t>(data + 31); }
+};
+
+// A match against a non-displayed order.
+struct Trade : Message {
+    static constexpr char id = 'P';
+    static constexpr size_t size = 44;
+    uint64_t order_reference() const { return load_be<uint64_t>(data + 11); }
+    bool buy() const { return data[19] == 'B'; }
+    uint32_t shares() const { return load_be<uint32_t>(data + 20); }
+    std::string_view stock() const { return {reinterpret_cast<const char*>(data + 24), 8}; }
+    uint32_t price() const { return load_be<uint32_t>(data + 32); }
+    uint64_t match_number() const { return load_be<uint64_t>(data + 36); }
+};
+
+
+// Splits a buffer into messages and calls Derived::on_<message>(view) for each, with
+// the type resolved at compile time, so a handler's callbacks inline into the loop.
+// A handler only defines the callbacks it wants; the rest fall through to the no-ops
+// here. Types the decoder doesn't know, and messages shorter than their type's size,
+// go to on_unknown and on_malformed.
+template<typename Derived>
+class Decoder {
+public:
+    // Decodes every complete message in [data, data + size) and returns the bytes
+    // consumed. A message cut off at the end is left for the next call, prefixed with
+    // whatever arrives next.
+    size_t decode(const uint8_t* data, size_t size) {
+        size_t offset = 0;
+        while (LIKELY(offset + 2 <= size)) {
+            const size_t length = load_be<uint16_t>(data + offset);
+            if (UNLIKELY(offset + 2 + length > size)) break;
+            dispatch(data + offset + 2, length);
+            offset += 2 + length;
+        }
+        return offset;
+    }
+
+    void on_system_event(SystemEvent) {}
+    void on_add_order(AddOrder) {}
+    void on_add_order_mpid(AddOrderMPID) {}
+    void on_order_executed(OrderExecuted) {}
+    void on_order_executed_with_price(OrderExecutedWithPrice) {}
+    void on_order_cancel(OrderCancel) {}
+    void on_order_delete(OrderDelete) {}
+    void on_order_replace(OrderReplace) {}
+    void on_trade(Trade) {}
+    void on_unknown(const uint8_t*, size_t) {}
+    void on_malformed(const uint8_t*, size_t) {}
+
+private:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+
+    template<typename View, typename Callback>
+    void deliver(const uint8_t* message, size_t length, Callback callback) {
+        if (UNLIKELY(length < View::size)) {
+            derived().on_malformed(message, length);
+            return;
+        }
+        View view;
+        view.data = message;
+        (derived().*callback)(view);
+    }
+
+    void dispatch(const uint8_t* message, size_t length) {
+        if (UNLIKELY(length == 0)) {
+            derived().on_malformed(message, length);
+            return;
+        }
+        switch (static_cast<char>(message[0])) {
+        case AddOrder::id:               deliver<AddOrder>(message, length, &Derived::on_add_order); break;
+        case OrderDelete::id:            deliver<OrderDelete>(message, length, &Derived::on_order_delete); break;
+        case OrderReplace::id:           deliver<OrderReplace>(message, length, &Derived::on_order_replace); break;
+        case OrderExecuted::id:          deliver<OrderExecuted>(message, length, &Derived::on_order_executed); break;
+        case OrderCancel::id:            deliver<OrderCancel>(message, length, &Derived::on_order_cancel); break;
+        case OrderExecutedWithPrice::id: deliver<OrderExecutedWithPrice>(message, length, &Derived::on_order_executed_with_price); break;
+        case AddOrderMPID::id:           deliver<AddOrderMPID>(message, length, &Derived::on_add_order_mpid); break;
+        case Trade::id:                  deliver<Trade>(message, length, &Derived::on_trade); break;
+        case SystemEvent::id:            deliver<SystemEvent>(message, length, &Derived::on_system_event); break;
+        default:                         derived().on_unknown(message, length); break;
+        }
+    }
+};
+
+
+// A synthetic session: a start-of-messages event and then adds, deletes, replaces,
+// executions, partial cancels and hidden trades, in roughly the proportions of a real
+// Nasdaq day, over `stocks` instruments. Every reference-carrying message names an
+// order that is live at that point. Each stock has a mid between $20 and $200 that
+// takes a cent random walk step now and then; orders rest a few cents behind it.
+// Timestamps rise by a few hundred ns a message.
+inline std::vector<uint8_t> generate_feed(size_t messages, uint16_t stocks = 64, uint32_t seed = 5) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_int_distribution<uint16_t> locate(1, stocks);
+    std::uniform_int_distribution<uint32_t> shares(1, 1000);
+    std::uniform_int_distribution<uint32_t> start(2000, 20000);   // cents
+    std::exponential_distribution<double> depth(1.0 / 5.0);
+    std::uniform_int_distribution<uint64_t> gap(50, 500);
+
+    std::vector<uint32_t> mids(stocks + 1);
+    for (uint32_t& mid : mids) mid = start(rng);
+    // ITCH price (4 decimals) for a new order on this side of the stock's mid.
+    auto price = [&](uint16_t stock, bool buy) {
+        uint32_t& mid = mids[stock];
+        if (uniform(rng) < 0.05) mid += uniform(rng) < 0.5 ? -1 : 1;
+        const uint32_t behind = 1 + static_cast<uint32_t>(depth(rng));
+        return (buy ? mid - behind : mid + behind) * 100;
+    };
+
+    struct Live { uint64_t reference; uint16_t locate; uint32_t shares; bool buy; };
+    std::vector<Live> live;
+    std::vector<uint8_t> feed;
+    feed.reserve(messages * 36);
+    uint64_t next_reference = 1, match = 1, timestamp = 34200000000000;   // 09:30
+
+    auto begin = [&](char type, size_t size, uint16_t stock) {
+        const size_t at = feed.size();
+        feed.resize(at + 2 + size);
+        uint8_t* p = feed.data() + at;
+        store_be<uint16_t>(p, static_cast<uint16_t>(size));
+        p += 2;
+        p[0] = static_cast<uint8_t>(type);
+        store_be<uint16_t>(p + 1, stock);
+        store_be<uint16_t>(p + 3, 0);
+        timestamp += gap(rng);
+        store_be<uint16_t>(p + 5, static_cast<uint16_t>(timestamp >> 32));
+        store_be<uint32_t>(p + 7, static_cast<uint32_t>(timestamp));
+        return p;
+    };
+    auto symbol = [](uint8_t* p, uint16_t stock) {
+        char name[9];
+        std::snprintf(name, sizeof(name), "STK%-5u", static_cast<unsigned>(stock));
+        std::memcpy(p, name, 8);
+    };
+    auto take = [&](size_t k) {
+        const Live order = live[k];
+        live[k] = live.back();
+        live.pop_back();
+        return order;
+    };
+
+    begin(SystemEvent::id, SystemEvent::size, 0)[11] = 'O';
+    for (size_t i = 1; i < messages; ++i) {
+        const double r = uniform(rng);
+        if (live.empty() || r < 0.42) {
+            const bool mpid = uniform(rng) < 0.05;
+            const Live order{next_reference++, locate(rng), shares(rng), uniform(rng) < 0.5};
+            uint8_t* p = begin(mpid ? AddOrderMPID::id : AddOrder::id, mpid ? AddOrderMPID::size : AddOrder::size, order.locate);
+            store_be<uint64_t>(p + 11, order.reference);
+            p[19] = order.buy ? 'B' : 'S';
+            store_be<uint32_t>(p + 20, order.shares);
+            symbol(p + 24, order.locate);
+            store_be<uint32_t>(p + 32, price(order.locate, order.buy));
+            if (mpid) std::memcpy(p + 36, "MPID", 4);
+            live.push_back(order);
+            continue;
+        }
+        const size_t k = std::uniform_int_distribution<size_t>(0, live.size() - 1)(rng);
+        if (r < 0.80) {
+            const Live order = take(k);
+            store_be<uint64_t>(begin(OrderDelete::id, OrderDelete::size, order.locate) + 11, order.reference);
+        } else if (r < 0.88) {
+            Live& order = live[k];
+            uint8_t* p = begin(OrderReplace::id, OrderReplace::size, order.locate);
+            store_be<uint64_t>(p + 11, order.reference);
+            order.reference = next_reference++;
+            order.shares = shares(rng);
+            store_be<uint64_t>(p + 19, order.reference);
+            store_be<uint32_t>(p + 27, order.shares);
+            store_be<uint32_t>(p + 31, price(order.locate, order.buy));
+        } else if (r < 0.96) {
+            Live& order = live[k];
+            const bool with_price = uniform(rng) < 0.1;
+            const uint32_t executed = std::uniform_int_distribution<uint32_t>(1, order.shares)(rng);
+            uint8_t* p = with_price ? begin(OrderExecutedWithPrice::id, OrderExecutedWithPrice::size, order.locate)
+                                    : begin(OrderExecuted::id, OrderExecuted::size, order.locate);
+            store_be<uint64_t>(p + 11, order.reference);
+            store_be<uint32_t>(p + 19, executed);
+            store_be<uint64_t>(p + 23, match++);
+            if (with_price) {
+                p[31] = 'Y';
+                store_be<uint32_t>(p + 32, mids[order.locate] * 100);
+            }
+            order.shares -= executed;
+            if (order.shares == 0) take(k);
+        } else if (r < 0.99) {
+            Live& order = live[k];
+            const uint32_t cancelled = std::uniform_int_distribution<uint32_t>(1, order.shares)(rng);
+            uint8_t* p = begin(OrderCancel::id, OrderCancel::size, order.locate);
+            store_be<uint64_t>(p + 11, order.reference);
+            store_be<uint32_t>(p + 19, cancelled);
+            order.shares -= cancelled;
+            if (order.shares == 0) take(k);
+        } else {
+            const uint16_t stock = locate(rng);
+            uint8_t* p = begin(Trade::id, Trade::size, stock);
+            store_be<uint64_t>(p + 11, 0);
+            p[19] = 'B';
+            store_be<uint32_t>(p + 20, shares(rng));
+            symbol(p + 24, stock);
+            store_be<uint32_t>(p + 32, mids[stock] * 100);
+            store_be<uint64_t>(p + 36, match++);
+        }
+    }
+    return feed;
+}
+
+}
+
+
+// Decode throughput over a 1M-message feed (about 30MB), into a handler that reads
+// every field a book builder would and folds them into a checksum. BM_DecodeChunked
+// feeds the same bytes in 64KB pieces, the way they come off a socket, carrying each
+// partial message over to the next read.
+class ItchDecodeBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        if (feed.empty()) feed = itch::generate_feed(n_messages);
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    struct Checksum : itch::Decoder<Checksum> {
+        uint64_t sum = 0;
+        size_t messages = 0;
+
+        void on_system_event(itch::SystemEvent m) { sum += m.timestamp(); ++messages; }
+        void on_add_order(itch::AddOrder m) { sum += m.order_reference() + m.shares() * m.price() + m.buy() + m.stock_locate(); ++messages; }
+        void on_add_order_mpid(itch::AddOrderMPID m) { on_add_order(m); }
+        void on_order_executed(itch::OrderExecuted m) { sum += m.order_reference() + m.executed_shares(); ++messages; }
+        void on_order_executed_with_price(itch::OrderExecutedWithPrice m) { sum += m.order_reference() + m.executed_shares() + m.execution_price(); ++messages; }
+        void on_order_cancel(itch::OrderCancel m) { sum += m.order_reference() + m.cancelled_shares(); ++messages; }
+        void on_order_delete(itch::OrderDelete m) { sum += m.order_reference(); ++messages; }
+        void on_order_replace(itch::OrderReplace m) { sum += m.original_order_reference() + m.new_order_reference() + m.shares() * m.price(); ++messages; }
+        void on_trade(itch::Trade m) { sum += m.shares() * m.price(); ++messages; }
+    };
+
+    static const size_t n_messages = 1000000;
+    static constexpr size_t chunk = 64 * 1024;
+    static inline std::vector<uint8_t> feed;
+};
+
+
+BENCHMARK_F(ItchDecodeBenchmark, BM_Decode)(benchmark::State& state) {
+    Checksum handler;
+    for (auto _ : alloc_counter::counted(state)) {
+        handler.decode(feed.data(), feed.size());
+        benchmark::DoNotOptimize(handler.sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_messages));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(feed.size()));
+}
+
+BENCHMARK_F(ItchDecodeBenchmark, BM_DecodeChunked)(benchmark::State& state) {
+    Checksum handler;
+    std::vector<uint8_t> buffer(chunk + 2 + 65535);
+    for (auto _ : alloc_counter::counted(state)) {
+        size_t pending = 0;
+        for (size_t at = 0; at < feed.size(); at += chunk) {
+            const size_t n = std::min(chunk, feed.size() - at);
+            std::memcpy(buffer.data() + pending, feed.data() + at, n);
+            const size_t available = pending + n;
+            const size_t used = handler.decode(buffer.data(), available);
+            pending = available - used;
+            std::memmove(buffer.data(), buffer.data() + used, pending);
+        }
+        benchmark::DoNotOptimize(handler.sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_messages));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(feed.size()));
+}
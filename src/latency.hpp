@@ -0,0 +1,66 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+# include <intrin.h>
+#else
+# include <immintrin.h>
+#endif
+
+
+// Per-operation latency for benchmarks whose mean hides the tail. Timestamps are raw
+// TSC reads, about 20 cycles each against a few hundred for a steady_clock pair, and
+// are converted to nanoseconds only when the percentiles are taken.
+namespace latency {
+
+inline uint64_t now() {
+    return __rdtsc();
+}
+
+// TSC ticks per nanosecond, measured once against steady_clock over 10ms.
+inline double ticks_per_ns() {
+    static const double ratio = [] {
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t ticks = now();
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(10)) {}
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(now() - ticks) / ns;
+    }();
+    return ratio;
+}
+
+class Samples {
+public:
+    explicit Samples(size_t capacity = 0) { ticks_.reserve(capacity); }
+
+    void record(uint64_t start, uint64_t end) { ticks_.push_back(end - start); }
+    void clear() { ticks_.clear(); }
+    size_t size() const { return ticks_.size(); }
+
+    // The q-quantile (0 <= q <= 1) in nanoseconds; 0 with no samples. Reorders the
+    // samples.
+    double percentile(double q) {
+        if (ticks_.empty()) return 0.0;
+        const size_t rank = std::min(ticks_.size() - 1, static_cast<size_t>(q * static_cast<double>(ticks_.size())));
+        std::nth_element(ticks_.begin(), ticks_.begin() + static_cast<std::ptrdiff_t>(rank), ticks_.end());
+        return static_cast<double>(ticks_[rank]) / ticks_per_ns();
+    }
+
+    // p50, p99 and p99.9 as benchmark counters, in nanoseconds.
+    void report(benchmark::State& state) {
+        state.counters["p50_ns"] = percentile(0.50);
+        state.counters["p99_ns"] = percentile(0.99);
+        state.counters["p999_ns"] = percentile(0.999);
+    }
+
+private:
+    std::vector<uint64_t> ticks_;
+};
+
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "aligned_buffer.hpp"
+#include "simd_dispatch.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+#include <xmmintrin.h>
+
+
+// Finding the level for an incoming price: the index of the first level >= price in
+// a book side sorted ascending (negate the prices for bids). std::lower_bound is the
+// baseline; KernelTable::lower_bound_i32 scans one vector of levels per compare, and
+// EytzingerLevels stores the levels in BFS order for a branchless binary search that
+// can prefetch.
+class EytzingerLevels {
+public:
+    explicit EytzingerLevels(const std::vector<int32_t>& sorted)
+        : keys_(sorted.size() + 1), ranks_(sorted.size() + 1), size_(sorted.size()) {
+        size_t next = 0;
+        build(sorted, next, 1);
+    }
+
+    // Walks down the implicit tree, going right whenever the key is below value, so
+    // the loop body has no branch to mispredict. The path ends past a leaf; the bits
+    // of k record every turn, and shifting out the trailing right turns plus one
+    // leaves the last node where the search went left, which is the answer.
+    size_t lower_bound(int32_t value) const {
+        const int32_t* keys = keys_.data();
+        size_t k = 1;
+        while (k <= size_) {
+            // Sixteen keys, four levels down, share one cache line.
+            _mm_prefetch(reinterpret_cast<const char*>(keys + 16 * k), _MM_HINT_T0);
+            k = 2 * k + (keys[k] < value);
+        }
+        k >>= std::countr_one(k) + 1;
+        return k == 0 ? size_ : ranks_[k];
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    // In-order walk of the implicit tree, so node k gets the next sorted key.
+    void build(const std::vector<int32_t>& sorted, size_t& next, size_t k) {
+        if (k > size_) return;
+        build(sorted, next, 2 * k);
+        keys_[k] = sorted[next];
+        ranks_[k] = static_cast<uint32_t>(next);
+        ++next;
+        build(sorted, next, 2 * k + 1);
+    }
+
+    AlignedBuffer<int32_t> keys_;     // 1-based; keys_[0] is unused
+    AlignedBuffer<uint32_t> ranks_;   // sorted index of each node
+    size_t size_;
+};
+
+
+namespace level_search {
+
+enum class Queries : int {
+    Uniform,    // anywhere in the book
+    NearTouch,  // geometric in distance from the best level, as most updates are
+};
+
+inline std::vector<int32_t> make_levels(size_t depth, std::mt19937& rng) {
+    std::uniform_int_distribution<int32_t> gap(1, 3);
+    std::vector<int32_t> levels(depth);
+    int32_t price = 100000;
+    for (auto& level : levels) {
+        price += gap(rng);
+        level = price;
+    }
+    return levels;
+}
+
+inline std::vector<int32_t> make_queries(const std::vector<int32_t>& levels, Queries kind, size_t count, std::mt19937& rng) {
+    std::vector<int32_t> queries(count);
+    if (kind == Queries::Uniform) {
+        std::uniform_int_distribution<int32_t> price(levels.front() - 2, levels.back() + 2);
+        for (auto& q : queries) q = price(rng);
+    } else {
+        std::geometric_distribution<int32_t> distance(0.2);
+        for (auto& q : queries) q = levels.front() - 1 + distance(rng);
+    }
+    return queries;
+}
+
+// (depth, queries) for every depth from 5 to 5000.
+inline void depth_args(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"depth", "queries"});
+    for (int depth : {5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000}) {
+        for (Queries kind : {Queries::Uniform, Queries::NearTouch}) {
+            b->Args({depth, static_cast<int>(kind)});
+        }
+    }
+}
+
+// (depth, queries, isa).
+inline void depth_isa_args(benchmark::internal::Benchmark* b) {
+    using simd_kernels::Isa;
+    b->ArgNames({"depth", "queries", "isa"});
+    for (int depth : {5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000}) {
+        for (Queries kind : {Queries::Uniform, Queries::NearTouch}) {
+            for (Isa isa : {Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+                if (simd_kernels::supported(isa)) {
+                    b->Args({depth, static_cast<int>(kind), static_cast<int>(isa)});
+                }
+            }
+        }
+    }
+}
+
+}
+
+
+class LevelSearchBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        std::mt19937 rng(42);
+        levels = level_search::make_levels(static_cast<size_t>(state.range(0)), rng);
+        queries = level_search::make_queries(levels, static_cast<level_search::Queries>(state.range(1)), query_count, rng);
+        eytzinger = std::make_unique<EytzingerLevels>(levels);
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+        eytzinger.reset();
+    }
+
+    static constexpr size_t query_count = 4096;
+    std::vector<int32_t> levels;
+    std::vector<int32_t> queries;
+    std::unique_ptr<EytzingerLevels> eytzinger;
+};
+
+
+BENCHMARK_DEFINE_F(LevelSearchBenchmark, BM_StdLowerBound)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        size_t sum = 0;
+        for (int32_t q : queries) {
+            sum += static_cast<size_t>(std::lower_bound(levels.begin(), levels.end(), q) - levels.begin());
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(queries.size()));
+}
+BENCHMARK_REGISTER_F(LevelSearchBenchmark, BM_StdLowerBound)->Apply(level_search::depth_args);
+
+BENCHMARK_DEFINE_F(LevelSearchBenchmark, BM_Eytzinger)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        size_t sum = 0;
+        for (int32_t q : queries) {
+            sum += eytzinger->lower_bound(q);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(queries.size()));
+}
+BENCHMARK_REGISTER_F(LevelSearchBenchmark, BM_Eytzinger)->Apply(level_search::depth_args);
+
+BENCHMARK_DEFINE_F(LevelSearchBenchmark, BM_SIMDLinear)(benchmark::State& state) {
+    const simd_kernels::KernelTable& kernels = simd_kernels::table(static_cast<simd_kernels::Isa>(state.range(2)));
+    for (auto _ : alloc_counter::counted(state)) {
+        size_t sum = 0;
+        for (int32_t q : queries) {
+            sum += kernels.lower_bound_i32(levels.data(), levels.size(), q);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(queries.size()));
+    state.SetLabel(kernels.name);
+}
+BENCHMARK_REGISTER_F(LevelSearchBenchmark, BM_SIMDLinear)->Apply(level_search::depth_isa_args);
@@ -1,16 +1,32 @@
 #include <benchmark/benchmark.h>
 #include "cache_warming.hpp"
 #include "simd_math.hpp"
+#include "simd_throughput.hpp"
 #include "prefetch.hpp"
+#include "reduction.hpp"
+#include "fix_parser.hpp"
+#include "level_search.hpp"
 #include "arena_allocator.hpp"
 #include "pool_allocator.hpp"
 #include "curiously_recurring_template_pattern.hpp"
 #include "branch_reduction.hpp"
-// #include "lock_free.hpp"
+#include "lock_free.hpp"
 // #include "michael_scott_queue.hpp"
 // #include "hazard_pointer.hpp"
 // #include "mpmc_queue.hpp"
 #include "vos_vs_sov.hpp"
+#include "streaming_indicators.hpp"
+#include "bar_file.hpp"
+#include "soa_vector.hpp"
+#include "bar_aggregator.hpp"
+#include "tick_indicators.hpp"
+#include "parallel_indicators.hpp"
+#include "order_book.hpp"
+#include "itch.hpp"
+#include "matching_engine.hpp"
+#include "pipeline.hpp"
+#include "megamorphic_dispatch.hpp"
+#include "risk_checks.hpp"
 #include "affinity.hpp"
 
 int main(int argc, char** argv) {
@@ -0,0 +1,373 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "branch_reduction.hpp"
+#include "latency.hpp"
+#include "occupancy_bitmap.hpp"
+#include "order_book.hpp"
+#include "pool_allocator.hpp"
+#include "ring_buffer.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+namespace matching {
+
+enum class OrderType : uint8_t {
+    Limit,    // matches what it can, rests the remainder
+    Market,   // matches at any price, cancels the remainder
+    IOC,      // matches up to its limit price, cancels the remainder
+};
+
+struct NewOrder {
+    uint64_t id;
+    book::Side side;
+    OrderType type;
+    int64_t price;   // ticks; ignored for Market
+    uint32_t quantity;
+};
+
+struct Fill {
+    uint64_t taker;
+    uint64_t maker;
+    int64_t price;   // the resting order's
+    uint32_t quantity;
+};
+
+enum class Status : uint8_t {
+    Rejected,    // duplicate id, zero quantity or a limit price outside the band
+    Resting,     // some or all of it is on the book
+    Filled,
+    Cancelled,   // the unfilled rest of a Market or IOC order
+};
+
+struct Result {
+    Status status;
+    uint32_t filled;
+};
+
+
+// A single-symbol exchange book with price-time priority. Resting orders live in the
+// book's Level FIFOs, allocated from a PoolAllocator and found by id for cancels
+// through an OrderIdMap. Prices are limited to a fixed band of `levels` ticks from
+// min_price, like an exchange's price collar, so a level is an array index and the
+// next best price after a level empties comes from an OccupancyBitmap.
+//
+// Most limit orders don't cross, so the cross check is marked UNLIKELY and the
+// no-cross path falls straight through to resting the order. Fills go into an
+// AtomicRingBuffer for a consumer on another thread. The matching thread never waits
+// on it: a fill that finds the ring full is dropped and counted in dropped_fills(),
+// so the consumer must keep up, and one on the same thread must drain after every
+// submit with the ring sized for the largest sweep.
+template<size_t FillCapacity>
+class MatchingEngine {
+public:
+    using FillQueue = AtomicRingBuffer<Fill, FillCapacity>;
+
+    MatchingEngine(size_t max_orders, int64_t min_price, size_t levels, FillQueue& fills)
+        : min_price_(min_price), levels_count_(static_cast<int64_t>(levels))
+        , pool_(max_orders), ids_(max_orders), fills_(fills) {
+        for (BookSide& s : sides_) {
+            s.levels.resize(levels);
+            s.occupied = OccupancyBitmap(levels);
+        }
+    }
+
+    ~MatchingEngine() {
+        clear();
+    }
+
+    MatchingEngine(const MatchingEngine&) = delete;
+    MatchingEngine& operator=(const MatchingEngine&) = delete;
+
+    Result submit(const NewOrder& order) {
+        if (UNLIKELY(order.quantity == 0 || ids_.find(order.id) != nullptr)) return {Status::Rejected, 0};
+        const bool limit = order.type != OrderType::Market;
+        if (UNLIKELY(limit && !in_band(order.price))) return {Status::Rejected, 0};
+
+        const book::Side contra = order.side == book::Side::Buy ? book::Side::Sell : book::Side::Buy;
+        const int64_t limit_price = limit ? order.price
+                                          : (order.side == book::Side::Buy ? max_price() : min_price_);
+        uint32_t remaining = order.quantity;
+        if (UNLIKELY(crosses(order.side, limit_price))) {
+            remaining = match(order.id, order.side, contra, limit_price, remaining);
+        }
+        const uint32_t filled = order.quantity - remaining;
+        if (remaining == 0) return {Status::Filled, filled};
+        if (order.type != OrderType::Limit) return {Status::Cancelled, filled};
+
+        book::Order* resting = pool_.allocate();
+        *resting = book::Order{order.id, order.price, remaining, order.side, nullptr, nullptr};
+        ids_.insert(order.id, resting);
+        rest(resting);
+        return {Status::Resting, filled};
+    }
+
+    bool cancel(uint64_t id) {
+        book::Order* order = ids_.erase(id);
+        if (UNLIKELY(order == nullptr)) return false;
+        remove(order);
+        pool_.deallocate(order);
+        return true;
+    }
+
+    book::Quote best_bid() const { return quote(book::Side::Buy); }
+    book::Quote best_ask() const { return quote(book::Side::Sell); }
+
+    int64_t min_price() const { return min_price_; }
+    int64_t max_price() const { return min_price_ + levels_count_ - 1; }
+
+    // Fills lost to a full ring since the engine was made. clear() keeps the count.
+    uint64_t dropped_fills() const { return dropped_fills_; }
+
+    // Drops every resting order, keeping the memory.
+    void clear() {
+        for (BookSide& s : sides_) {
+            for (size_t i = s.occupied.next(0); i != OccupancyBitmap::npos; i = s.occupied.next(i + 1)) {
+                book::Level& l = s.levels[i];
+                for (book::Order* order = l.head; order != nullptr;) {
+                    book::Order* next = order->next;
+                    pool_.deallocate(order);
+                    order = next;
+                }
+                l = book::Level{};
+            }
+            s.occupied.clear();
+            s.best = OccupancyBitmap::npos;
+        }
+        ids_.clear();
+    }
+
+private:
+    struct BookSide {
+        std::vector<book::Level> levels;   // price min_price_ + i at levels[i]
+        OccupancyBitmap occupied{0};
+        size_t best = OccupancyBitmap::npos;   // index of the best level
+    };
+
+    BookSide& side(book::Side s) { return sides_[static_cast<size_t>(s)]; }
+    const BookSide& side(book::Side s) const { return sides_[static_cast<size_t>(s)]; }
+
+    bool in_band(int64_t price) const {
+        return static_cast<uint64_t>(price - min_price_) < static_cast<uint64_t>(levels_count_);
+    }
+
+    int64_t price_at(size_t index) const { return min_price_ + static_cast<int64_t>(index); }
+
+    bool crosses(book::Side s, int64_t limit_price) const {
+        if (s == book::Side::Buy) {
+            const size_t ask = side(book::Side::Sell).best;
+            return ask != OccupancyBitmap::npos && price_at(ask) <= limit_price;
+        }
+        const size_t bid = side(book::Side::Buy).best;
+        return bid != OccupancyBitmap::npos && price_at(bid) >= limit_price;
+    }
+
+    // Takes from the best contra levels, oldest order first, while they cross.
+    uint32_t match(uint64_t taker, book::Side s, book::Side contra, int64_t limit_price, uint32_t remaining) {
+        BookSide& book_side = side(contra);
+        while (remaining != 0 && crosses(s, limit_price)) {
+            const size_t index = book_side.best;
+            book::Level& l = book_side.levels[index];
+            while (remaining != 0 && !l.empty()) {
+                book::Order* maker = l.head;
+                const uint32_t quantity = std::min(remaining, maker->quantity);
+                publish(Fill{taker, maker->id, maker->price, quantity});
+                remaining -= quantity;
+                if (quantity == maker->quantity) {
+                    l.remove(maker);
+                    ids_.erase(maker->id);
+                    pool_.deallocate(maker);
+                } else {
+                    maker->quantity -= quantity;
+                    l.quantity -= quantity;
+                }
+            }
+            if (l.empty()) level_emptied(contra, index);
+        }
+        return remaining;
+    }
+
+    void publish(const Fill& fill) {
+        if (UNLIKELY(!fills_.push(fill))) ++dropped_fills_;
+    }
+
+    void rest(book::Order* order) {
+        BookSide& s = side(order->side);
+        const size_t index = static_cast<size_t>(order->price - min_price_);
+        book::Level& l = s.levels[index];
+        if (l.empty()) s.occupied.set(index);
+        l.push_back(order);
+        if (s.best == OccupancyBitmap::npos ||
+            (order->side == book::Side::Buy ? index > s.best : index < s.best)) {
+            s.best = index;
+        }
+    }
+
+    void remove(book::Order* order) {
+        const size_t index = static_cast<size_t>(order->price - min_price_);
+        book::Level& l = side(order->side).levels[index];
+        l.remove(order);
+        if (l.empty()) level_emptied(order->side, index);
+    }
+
+    void level_emptied(book::Side which, size_t index) {
+        BookSide& s = side(which);
+        s.occupied.reset(index);
+        if (index != s.best) return;
+        if (which == book::Side::Buy) {
+            s.best = index == 0 ? OccupancyBitmap::npos : s.occupied.prev(index - 1);
+        } else {
+            s.best = s.occupied.next(index + 1);
+        }
+    }
+
+    book::Quote quote(book::Side which) const {
+        const BookSide& s = side(which);
+        if (s.best == OccupancyBitmap::npos) {
+            return {which == book::Side::Buy ? book::OrderBook::no_bid : book::OrderBook::no_ask, 0};
+        }
+        return {price_at(s.best), s.levels[s.best].quantity};
+    }
+
+    int64_t min_price_;
+    int64_t levels_count_;
+    BookSide sides_[2];   // indexed by book::Side
+    PoolAllocator<book::Order> pool_;
+    book::OrderIdMap ids_;
+    FillQueue& fills_;
+    uint64_t dropped_fills_ = 0;
+};
+
+}
+
+
+// One step of an order flow: a new order, or a cancel of order.id.
+struct OrderFlowEvent {
+    bool cancel;
+    matching::NewOrder order;
+};
+
+// Reproducible order flow for one symbol. The mid takes a tick random walk step every
+// 10 orders. Of the orders, 55% are limits resting 0 to 20 ticks behind the mid, 10%
+// limits priced 1 to 3 ticks through it, 8% IOCs through it, 2% market orders and 25%
+// cancels of one of the last 1000 orders sent, some of which will have filled already.
+inline std::vector<OrderFlowEvent> generateOrderFlow(size_t n, int64_t mid, uint64_t seed = 3) {
+    using matching::OrderType;
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_int_distribution<int64_t> passive(0, 20);
+    std::uniform_int_distribution<int64_t> aggressive(1, 3);
+    std::uniform_int_distribution<uint32_t> quantity(1, 300);
+
+    std::vector<OrderFlowEvent> flow;
+    flow.reserve(n);
+    uint64_t next_id = 1;
+    for (size_t i = 0; i < n; ++i) {
+        if (i % 10 == 0) mid += uniform(rng) < 0.5 ? -1 : 1;
+        const double r = uniform(rng);
+        if (r < 0.25 && next_id > 1) {
+            const uint64_t back = std::uniform_int_distribution<uint64_t>(1, std::min<uint64_t>(1000, next_id - 1))(rng);
+            flow.push_back({true, matching::NewOrder{next_id - back, book::Side::Buy, OrderType::Limit, 0, 0}});
+            continue;
+        }
+        const book::Side side = uniform(rng) < 0.5 ? book::Side::Buy : book::Side::Sell;
+        const int64_t direction = side == book::Side::Buy ? 1 : -1;
+        matching::NewOrder order{next_id++, side, OrderType::Limit, 0, quantity(rng)};
+        if (r < 0.80) {
+            order.price = mid - direction * (1 + passive(rng));
+        } else if (r < 0.90) {
+            order.price = mid + direction * aggressive(rng);
+        } else if (r < 0.98) {
+            order.type = OrderType::IOC;
+            order.price = mid + direction * aggressive(rng);
+        } else {
+            order.type = OrderType::Market;
+        }
+        flow.push_back({false, order});
+    }
+    return flow;
+}
+
+
+// 1M orders through the engine, restarted from an empty book every iteration, with
+// the fills drained on the same thread after each order. BM_Match reports orders per
+// second and fills per order; BM_MatchLatency times each order with the TSC for the
+// percentiles.
+class MatchingEngineBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        if (flow.empty()) flow = generateOrderFlow(n_orders, center);
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    using Engine = matching::MatchingEngine<4096>;
+
+    static size_t drain(Engine::FillQueue& fills) {
+        size_t count = 0;
+        matching::Fill fill;
+        while (fills.pop(fill)) {
+            benchmark::DoNotOptimize(fill);
+            ++count;
+        }
+        return count;
+    }
+
+    static void submit(Engine& engine, const OrderFlowEvent& event) {
+        if (event.cancel) engine.cancel(event.order.id);
+        else engine.submit(event.order);
+    }
+
+    static const size_t n_orders = 1000000;
+    static constexpr int64_t center = 100000;
+    static const size_t band = 1 << 16;
+    static inline std::vector<OrderFlowEvent> flow;
+};
+
+
+BENCHMARK_F(MatchingEngineBenchmark, BM_Match)(benchmark::State& state) {
+    auto fills = std::make_unique<Engine::FillQueue>();
+    Engine engine(n_orders, center - band / 2, band, *fills);
+    size_t filled = 0;
+    for (auto _ : alloc_counter::counted(state)) {
+        state.PauseTiming();
+        engine.clear();
+        filled = 0;
+        state.ResumeTiming();
+        for (const OrderFlowEvent& event : flow) {
+            submit(engine, event);
+            filled += drain(*fills);
+        }
+    }
+    if (engine.dropped_fills() != 0) state.SkipWithError("the fill ring overflowed");
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_orders));
+    state.counters["fills_per_order"] = static_cast<double>(filled) / static_cast<double>(n_orders);
+}
+
+BENCHMARK_F(MatchingEngineBenchmark, BM_MatchLatency)(benchmark::State& state) {
+    auto fills = std::make_unique<Engine::FillQueue>();
+    Engine engine(n_orders, center - band / 2, band, *fills);
+    latency::Samples samples(n_orders);
+    for (auto _ : alloc_counter::counted(state)) {
+        state.PauseTiming();
+        engine.clear();
+        samples.clear();
+        state.ResumeTiming();
+        for (const OrderFlowEvent& event : flow) {
+            const uint64_t start = latency::now();
+            submit(engine, event);
+            drain(*fills);
+            samples.record(start, latency::now());
+        }
+    }
+    if (engine.dropped_fills() != 0) state.SkipWithError("the fill ring overflowed");
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_orders));
+    samples.report(state);
+}
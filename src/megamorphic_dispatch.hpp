@@ -0,0 +1,371 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "alloc_counter.hpp"
+#include "branch_reduction.hpp"
+#include "perf_counters.hpp"
+
+
+// CRTPBenchmark/Polymorphism calls one Derived, so its indirect branch has a single
+// target and never mispredicts. A feed handler dispatches over tens of message types
+// in whatever order they arrive. Here each of up to 64 types does its own arithmetic
+// on a payload, and the same stream is dispatched six ways: a virtual call, a switch
+// on a type tag, a table of function pointers, std::visit over a std::variant,
+// virtual calls after bucketing the stream by type, and CRTP over storage that is
+// kept per type from the start. Only the first `types` kinds occur in the stream, so
+// the code being dispatched is the same for every type count and only the
+// predictability of the targets changes.
+namespace dispatch {
+
+constexpr size_t max_types = 64;
+
+// Distinct constants per type, so identical-code folding cannot merge the targets.
+template<size_t K>
+struct Op {
+    static int64_t apply(int64_t value, int64_t acc) {
+        return acc + value * static_cast<int64_t>(2 * K + 1) + static_cast<int64_t>(K);
+    }
+};
+
+template<size_t... K>
+int64_t applyReference(uint8_t type, int64_t value, int64_t acc, std::index_sequence<K...>) {
+    ((type == K ? (acc = Op<K>::apply(value, acc), true) : false) || ...);
+    return acc;
+}
+
+// Slow and obviously correct, for checking the other strategies.
+inline int64_t applyReference(uint8_t type, int64_t value, int64_t acc) {
+    return applyReference(type, value, acc, std::make_index_sequence<max_types>{});
+}
+
+
+enum class Order {
+    Random,  // every message picks a type uniformly
+    Sorted,  // all messages of type 0, then all of type 1, ...
+    Bursty   // runs of one type with geometric lengths, mean 16
+};
+
+inline std::vector<uint8_t> generateTypes(size_t n, size_t types, Order order, uint32_t seed = 11) {
+    if (types == 0 || types > max_types) throw std::invalid_argument("generateTypes: types must be in [1, 64]");
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> type(0, static_cast<int>(types) - 1);
+    std::vector<uint8_t> out(n);
+    if (order == Order::Bursty) {
+        std::geometric_distribution<size_t> extra(1.0 / 16);
+        for (size_t i = 0; i < n;) {
+            const auto t = static_cast<uint8_t>(type(rng));
+            for (size_t run = std::min(n - i, extra(rng) + 1); run > 0; --run) out[i++] = t;
+        }
+        return out;
+    }
+    for (auto& t : out) t = static_cast<uint8_t>(type(rng));
+    if (order == Order::Sorted) std::sort(out.begin(), out.end());
+    return out;
+}
+
+
+// Virtual call.
+struct Message {
+    Message(uint8_t type, int64_t value) : type(type), value(value) {}
+    virtual ~Message() = default;
+    virtual int64_t apply(int64_t acc) const = 0;
+
+    uint8_t type;
+    int64_t value;
+};
+
+template<size_t K>
+struct TypedMessage final : Message {
+    explicit TypedMessage(int64_t value) : Message(K, value) {}
+    int64_t apply(int64_t acc) const override { return Op<K>::apply(value, acc); }
+};
+
+template<size_t K>
+std::unique_ptr<Message> makeTyped(int64_t value) {
+    return std::make_unique<TypedMessage<K>>(value);
+}
+
+template<size_t... K>
+constexpr auto messageFactories(std::index_sequence<K...>) {
+    return std::array<std::unique_ptr<Message> (*)(int64_t), sizeof...(K)>{&makeTyped<K>...};
+}
+
+inline std::unique_ptr<Message> makeMessage(uint8_t type, int64_t value) {
+    static constexpr auto factories = messageFactories(std::make_index_sequence<max_types>{});
+    return factories[type](value);
+}
+
+
+// Switch on a tag, and a table of function pointers indexed by the same tag.
+struct Tagged {
+    uint8_t type;
+    int64_t value;
+};
+
+#define DISPATCH_CASE(k) case (k): return Op<(k)>::apply(m.value, acc);
+#define DISPATCH_CASES_8(b) \
+    DISPATCH_CASE(b) DISPATCH_CASE(b + 1) DISPATCH_CASE(b + 2) DISPATCH_CASE(b + 3) \
+    DISPATCH_CASE(b + 4) DISPATCH_CASE(b + 5) DISPATCH_CASE(b + 6) DISPATCH_CASE(b + 7)
+
+// Tags are produced only by this file, so there is no default and no bounds check:
+// the switch compiles to a bare jump table, the same shape std::visit generates.
+inline int64_t applySwitch(const Tagged& m, int64_t acc) {
+    static_assert(max_types == 64);
+    switch (m.type) {
+        DISPATCH_CASES_8(0) DISPATCH_CASES_8(8) DISPATCH_CASES_8(16) DISPATCH_CASES_8(24)
+        DISPATCH_CASES_8(32) DISPATCH_CASES_8(40) DISPATCH_CASES_8(48) DISPATCH_CASES_8(56)
+    }
+    UNREACHABLE();
+}
+
+#undef DISPATCH_CASES_8
+#undef DISPATCH_CASE
+
+using OpFunction = int64_t (*)(int64_t, int64_t);
+
+template<size_t... K>
+constexpr std::array<OpFunction, sizeof...(K)> opTable(std::index_sequence<K...>) {
+    return {&Op<K>::apply...};
+}
+
+inline constexpr auto op_table = opTable(std::make_index_sequence<max_types>{});
+
+
+// std::variant with one alternative per type; std::visit recovers K from the
+// alternative's type.
+template<size_t K>
+struct Alternative {
+    static constexpr size_t index = K;
+    int64_t value;
+};
+
+template<size_t... K>
+std::variant<Alternative<K>...> variantOf(std::index_sequence<K...>);
+
+using Variant = decltype(variantOf(std::make_index_sequence<max_types>{}));
+
+template<size_t K>
+Variant makeAlternative(int64_t value) {
+    return Variant(std::in_place_index<K>, Alternative<K>{value});
+}
+
+template<size_t... K>
+constexpr auto variantFactories(std::index_sequence<K...>) {
+    return std::array<Variant (*)(int64_t), sizeof...(K)>{&makeAlternative<K>...};
+}
+
+inline Variant makeVariant(uint8_t type, int64_t value) {
+    static constexpr auto factories = variantFactories(std::make_index_sequence<max_types>{});
+    return factories[type](value);
+}
+
+inline int64_t applyVariant(const Variant& m, int64_t acc) {
+    return std::visit([acc](const auto& alternative) {
+        return Op<std::decay_t<decltype(alternative)>::index>::apply(alternative.value, acc);
+    }, m);
+}
+
+
+// CRTP needs the concrete type at compile time, which a mixed stream does not
+// give it. It fits when messages are stored per type as they arrive, one vector
+// each, and the handler loops over the vectors: no dispatch at all, but arrival
+// order across types is lost.
+template<typename Derived>
+struct Handler {
+    int64_t apply(int64_t acc) const { return static_cast<const Derived*>(this)->applyImpl(acc); }
+};
+
+template<size_t K>
+struct StaticMessage : Handler<StaticMessage<K>> {
+    explicit StaticMessage(int64_t value) : value(value) {}
+    int64_t applyImpl(int64_t acc) const { return Op<K>::apply(value, acc); }
+
+    int64_t value;
+};
+
+template<size_t... K>
+std::tuple<std::vector<StaticMessage<K>>...> storeOf(std::index_sequence<K...>);
+
+using TypedStore = decltype(storeOf(std::make_index_sequence<max_types>{}));
+
+template<size_t... K>
+void storeMessage(TypedStore& store, uint8_t type, int64_t value, std::index_sequence<K...>) {
+    ((type == K ? (std::get<K>(store).emplace_back(value), true) : false) || ...);
+}
+
+inline void storeMessage(TypedStore& store, uint8_t type, int64_t value) {
+    storeMessage(store, type, value, std::make_index_sequence<max_types>{});
+}
+
+template<typename Derived>
+int64_t applyAll(const std::vector<Derived>& messages, int64_t acc) {
+    for (const Handler<Derived>& m : messages) acc = m.apply(acc);
+    return acc;
+}
+
+inline int64_t applyStore(const TypedStore& store, int64_t acc) {
+    std::apply([&acc](const auto&... messages) { ((acc = applyAll(messages, acc)), ...); }, store);
+    return acc;
+}
+
+
+// Type sorting: bucket the stream by type with a counting sort, then make the same
+// virtual calls, which now hit one target many times in a row. The sort is part of
+// the cost.
+class TypeSorter {
+public:
+    explicit TypeSorter(size_t capacity) : sorted_(capacity) {}
+
+    const std::vector<const Message*>& sort(const std::vector<const Message*>& messages) {
+        counts_.fill(0);
+        for (const Message* m : messages) ++counts_[m->type];
+        size_t offset = 0;
+        for (size_t& count : counts_) {
+            const size_t c = count;
+            count = offset;
+            offset += c;
+        }
+        for (const Message* m : messages) sorted_[counts_[m->type]++] = m;
+        return sorted_;
+    }
+
+private:
+    std::array<size_t, max_types> counts_{};
+    std::vector<const Message*> sorted_;
+};
+
+}
+
+
+class DispatchBenchmark : public AllocCountingFixture {
+public:
+    static constexpr size_t n_messages = 1 << 14;
+
+    void SetUp(const ::benchmark::State& state) override {
+        const auto types = dispatch::generateTypes(
+            n_messages, static_cast<size_t>(state.range(0)), static_cast<dispatch::Order>(state.range(1)));
+        std::mt19937_64 rng(7);
+        std::uniform_int_distribution<int64_t> value(-1000, 1000);
+
+        owned.clear();
+        pointers.clear();
+        tagged.clear();
+        variants.clear();
+        store = {};
+        expected = 0;
+        for (const uint8_t t : types) {
+            const int64_t v = value(rng);
+            owned.push_back(dispatch::makeMessage(t, v));
+            pointers.push_back(owned.back().get());
+            tagged.push_back({t, v});
+            variants.push_back(dispatch::makeVariant(t, v));
+            dispatch::storeMessage(store, t, v);
+            expected = dispatch::applyReference(t, v, expected);
+        }
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    // Runs body(acc) -> acc once per iteration over all n_messages, checks the sum
+    // against the reference and reports time and branch misses per dispatched call.
+    template<typename Body>
+    void run(benchmark::State& state, Body&& body) {
+        PerfCounter branch_misses = PerfCounter::branch_misses();
+        int64_t acc = 0;
+        branch_misses.start();
+        for (auto _ : alloc_counter::counted(state)) {
+            acc = body();
+            benchmark::DoNotOptimize(acc);
+        }
+        const uint64_t misses = branch_misses.stop();
+        if (acc != expected) state.SkipWithError("dispatch result does not match the reference");
+
+        const double calls = static_cast<double>(state.iterations()) * n_messages;
+        state.counters["time_per_call"] = benchmark::Counter(
+            static_cast<double>(n_messages), benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+        if (branch_misses.available()) {
+            state.counters["branch_misses_per_call"] = static_cast<double>(misses) / calls;
+        }
+    }
+
+    std::vector<std::unique_ptr<dispatch::Message>> owned;  // allocated in arrival order
+    std::vector<const dispatch::Message*> pointers;
+    std::vector<dispatch::Tagged> tagged;
+    std::vector<dispatch::Variant> variants;
+    dispatch::TypedStore store;
+    int64_t expected = 0;
+};
+
+
+BENCHMARK_DEFINE_F(DispatchBenchmark, BM_Virtual)(benchmark::State& state) {
+    run(state, [&] {
+        int64_t acc = 0;
+        for (const dispatch::Message* m : pointers) acc = m->apply(acc);
+        return acc;
+    });
+}
+
+BENCHMARK_DEFINE_F(DispatchBenchmark, BM_Switch)(benchmark::State& state) {
+    run(state, [&] {
+        int64_t acc = 0;
+        for (const dispatch::Tagged& m : tagged) acc = dispatch::applySwitch(m, acc);
+        return acc;
+    });
+}
+
+BENCHMARK_DEFINE_F(DispatchBenchmark, BM_FunctionTable)(benchmark::State& state) {
+    run(state, [&] {
+        int64_t acc = 0;
+        for (const dispatch::Tagged& m : tagged) acc = dispatch::op_table[m.type](m.value, acc);
+        return acc;
+    });
+}
+
+BENCHMARK_DEFINE_F(DispatchBenchmark, BM_Variant)(benchmark::State& state) {
+    run(state, [&] {
+        int64_t acc = 0;
+        for (const dispatch::Variant& m : variants) acc = dispatch::applyVariant(m, acc);
+        return acc;
+    });
+}
+
+BENCHMARK_DEFINE_F(DispatchBenchmark, BM_TypeSorted)(benchmark::State& state) {
+    dispatch::TypeSorter sorter(n_messages);
+    run(state, [&] {
+        int64_t acc = 0;
+        for (const dispatch::Message* m : sorter.sort(pointers)) acc = m->apply(acc);
+        return acc;
+    });
+}
+
+BENCHMARK_DEFINE_F(DispatchBenchmark, BM_CRTPStore)(benchmark::State& state) {
+    run(state, [&] { return dispatch::applyStore(store, 0); });
+}
+
+static void dispatchArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"types", "order"})
+     ->ArgsProduct({{1, 4, 16, 64},
+                    {static_cast<int>(dispatch::Order::Random),
+                     static_cast<int>(dispatch::Order::Sorted),
+                     static_cast<int>(dispatch::Order::Bursty)}});
+}
+
+BENCHMARK_REGISTER_F(DispatchBenchmark, BM_Virtual)->Apply(dispatchArgs);
+BENCHMARK_REGISTER_F(DispatchBenchmark, BM_Switch)->Apply(dispatchArgs);
+BENCHMARK_REGISTER_F(DispatchBenchmark, BM_FunctionTable)->Apply(dispatchArgs);
+BENCHMARK_REGISTER_F(DispatchBenchmark, BM_Variant)->Apply(dispatchArgs);
+BENCHMARK_REGISTER_F(DispatchBenchmark, BM_TypeSorted)->Apply(dispatchArgs);
+BENCHMARK_REGISTER_F(DispatchBenchmark, BM_CRTPStore)->Apply(dispatchArgs);
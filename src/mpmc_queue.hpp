@@ -5,6 +5,7 @@
 #include <queue>
 #include <thread>
 #include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
 
 
 template <typename T>
@@ -202,7 +203,7 @@ private:
 };
 
 
-class QueueBenchmark : public benchmark::Fixture {
+class QueueBenchmark : public AllocCountingFixture {
 public:
     void SetUp(const ::benchmark::State&) override {
 
@@ -240,7 +241,7 @@ BENCHMARK_F(QueueBenchmark, LockingQueue)(benchmark::State& state)
         }
     };
 
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         std::vector<std::thread> producers;
         std::vector<std::thread> consumers;
         terminate_flag.store(false, std::memory_order_relaxed);
@@ -280,7 +281,7 @@ BENCHMARK_F(QueueBenchmark, NonLockingQueue)(benchmark::State& state)
         }
     };
 
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         std::vector<std::thread> producers;
         std::vector<std::thread> consumers;
         terminate_flag.store(false, std::memory_order_relaxed);
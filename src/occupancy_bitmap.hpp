@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+
+// One bit per price level, set while the level has orders, with two summary tiers
+// above it: bit w of summary_ says words_[w] is non-zero, and bit s of top_ says
+// summary_[s] is. The nearest occupied level on either side of a position is then a
+// masked word plus at most two more, each resolved with one tzcnt or lzcnt, however
+// many empty levels lie in between. Covers up to 64^3 = 262144 levels.
+class OccupancyBitmap {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    static constexpr size_t max_size = size_t(64) * 64 * 64;
+
+    explicit OccupancyBitmap(size_t size)
+        : size_(size), words_((size + 63) / 64), summary_((words_.size() + 63) / 64) {
+        if (size > max_size) throw std::length_error("OccupancyBitmap: more than 64^3 levels");
+    }
+
+    size_t size() const { return size_; }
+
+    bool test(size_t i) const { return (words_[i >> 6] >> (i & 63)) & 1; }
+
+    void set(size_t i) {
+        const size_t w = i >> 6;
+        words_[w] |= uint64_t(1) << (i & 63);
+        summary_[w >> 6] |= uint64_t(1) << (w & 63);
+        top_ |= uint64_t(1) << (w >> 6);
+    }
+
+    void reset(size_t i) {
+        const size_t w = i >> 6;
+        words_[w] &= ~(uint64_t(1) << (i & 63));
+        if (words_[w] != 0) return;
+        summary_[w >> 6] &= ~(uint64_t(1) << (w & 63));
+        if (summary_[w >> 6] != 0) return;
+        top_ &= ~(uint64_t(1) << (w >> 6));
+    }
+
+    void clear() {
+        std::fill(words_.begin(), words_.end(), 0);
+        std::fill(summary_.begin(), summary_.end(), 0);
+        top_ = 0;
+    }
+
+    // Lowest set position >= i, or npos.
+    size_t next(size_t i) const {
+        if (i >= size_) return npos;
+        size_t w = i >> 6;
+        const uint64_t bits = words_[w] & (~uint64_t(0) << (i & 63));
+        if (bits) return (w << 6) | std::countr_zero(bits);
+        if (++w == words_.size()) return npos;
+
+        size_t s = w >> 6;
+        uint64_t summary = summary_[s] & (~uint64_t(0) << (w & 63));
+        if (!summary) {
+            if (++s == summary_.size()) return npos;
+            const uint64_t top = top_ & (~uint64_t(0) << s);
+            if (!top) return npos;
+            s = std::countr_zero(top);
+            summary = summary_[s];
+        }
+        w = (s << 6) | std::countr_zero(summary);
+        return (w << 6) | std::countr_zero(words_[w]);
+    }
+
+    // Highest set position <= i, or npos. Any i >= size() searches from the end.
+    size_t prev(size_t i) const {
+        if (size_ == 0) return npos;
+        if (i >= size_) i = size_ - 1;
+        size_t w = i >> 6;
+        const uint64_t bits = words_[w] & (~uint64_t(0) >> (63 - (i & 63)));
+        if (bits) return (w << 6) | (63 - std::countl_zero(bits));
+        if (w-- == 0) return npos;
+
+        size_t s = w >> 6;
+        uint64_t summary = summary_[s] & (~uint64_t(0) >> (63 - (w & 63)));
+        if (!summary) {
+            if (s-- == 0) return npos;
+            const uint64_t top = top_ & (~uint64_t(0) >> (63 - s));
+            if (!top) return npos;
+            s = 63 - std::countl_zero(top);
+            summary = summary_[s];
+        }
+        w = (s << 6) | (63 - std::countl_zero(summary));
+        return (w << 6) | (63 - std::countl_zero(words_[w]));
+    }
+
+private:
+    size_t size_;
+    std::vector<uint64_t> words_;
+    std::vector<uint64_t> summary_;
+    uint64_t top_ = 0;
+};
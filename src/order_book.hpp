@@ -0,0 +1,723 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "branch_reduction.hpp"
+#include "latency.hpp"
+#include "occupancy_bitmap.hpp"
+#include "pool_allocator.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <random>
+#include <vector>
+
+
+namespace book {
+
+enum class Side : uint8_t { Buy, Sell };
+
+struct Order {
+    uint64_t id;
+    int64_t price;   // ticks
+    uint32_t quantity;
+    Side side;
+    Order* prev;     // towards the front of the level's queue
+    Order* next;
+};
+
+// The orders resting at one price, in time priority: an intrusive doubly linked list
+// through Order::prev/next, so cancelling from the middle is O(1).
+struct Level {
+    Order* head = nullptr;
+    Order* tail = nullptr;
+    uint64_t quantity = 0;
+    uint32_t orders = 0;
+
+    bool empty() const { return head == nullptr; }
+
+    void push_back(Order* order) {
+        order->prev = tail;
+        order->next = nullptr;
+        if (tail) tail->next = order; else head = order;
+        tail = order;
+        quantity += order->quantity;
+        ++orders;
+    }
+
+    void remove(Order* order) {
+        if (order->prev) order->prev->next = order->next; else head = order->next;
+        if (order->next) order->next->prev = order->prev; else tail = order->prev;
+        quantity -= order->quantity;
+        --orders;
+    }
+};
+
+struct Quote {
+    int64_t price;
+    uint64_t quantity;   // 0 when the side is empty
+};
+
+
+// Order id -> Order*, open addressing with linear probing at most half full. Erase
+// shifts the rest of the probe run back instead of leaving tombstones, so lookups
+// never slow down as orders come and go.
+class OrderIdMap {
+public:
+    explicit OrderIdMap(size_t max_orders) {
+        size_t capacity = 16;
+        while (capacity < 2 * max_orders) capacity *= 2;
+        entries_.resize(capacity);
+        mask_ = capacity - 1;
+        shift_ = 64 - std::countr_zero(capacity);
+    }
+
+    Order* find(uint64_t id) const {
+        for (size_t i = home(id);; i = (i + 1) & mask_) {
+            const Entry& entry = entries_[i];
+            if (entry.order == nullptr || entry.id == id) return entry.order;
+        }
+    }
+
+    // False if the id is already present.
+    bool insert(uint64_t id, Order* order) {
+        size_t i = home(id);
+        for (; entries_[i].order != nullptr; i = (i + 1) & mask_) {
+            if (entries_[i].id == id) return false;
+        }
+        entries_[i] = Entry{id, order};
+        return true;
+    }
+
+    // The order that was stored under id, or nullptr.
+    Order* erase(uint64_t id) {
+        size_t hole = home(id);
+        for (; entries_[hole].id != id; hole = (hole + 1) & mask_) {
+            if (entries_[hole].order == nullptr) return nullptr;
+        }
+        Order* order = entries_[hole].order;
+        if (order == nullptr) return nullptr;
+
+        // Move back any later entry of the run whose home is not between the hole and
+        // itself, so it stays reachable.
+        for (size_t j = (hole + 1) & mask_; entries_[j].order != nullptr; j = (j + 1) & mask_) {
+            const size_t k = home(entries_[j].id);
+            const bool reachable = hole <= j ? (hole < k && k <= j) : (hole < k || k <= j);
+            if (!reachable) {
+                entries_[hole] = entries_[j];
+                hole = j;
+            }
+        }
+        entries_[hole] = Entry{};
+        return order;
+    }
+
+    void clear() {
+        std::fill(entries_.begin(), entries_.end(), Entry{});
+    }
+
+private:
+    struct Entry {
+        uint64_t id = 0;
+        Order* order = nullptr;   // nullptr marks a free slot
+    };
+
+    // Fibonacci hashing: sequential exchange ids spread over the whole table.
+    size_t home(uint64_t id) const { return static_cast<size_t>((id * 0x9E3779B97F4A7C15ull) >> shift_); }
+
+    std::vector<Entry> entries_;
+    size_t mask_ = 0;
+    int shift_ = 0;
+};
+
+
+// Price-level book for a market data feed: add, modify, cancel and execute by order
+// id, best bid and ask. It does not match; a crossed feed is stored as given.
+//
+// Each side keeps a dense array of levels covering a window of `window` ticks, so the
+// level for a price is one subtraction away. Prices outside the window go into a
+// std::map per side. When an order lands outside the window and the mid has moved a
+// quarter of the window or more, the window recenters on the mid, swapping levels
+// between the array and the maps. Orders come from a PoolAllocator sized for
+// max_orders, and are found by id through an OrderIdMap.
+//
+// An OccupancyBitmap per side tracks which levels of the window have orders. When
+// the best level empties, the next best price comes from the bitmap in a few bit scans
+// instead of a walk over the empty levels between.
+class OrderBook {
+public:
+    static constexpr int64_t no_bid = std::numeric_limits<int64_t>::min();
+    static constexpr int64_t no_ask = std::numeric_limits<int64_t>::max();
+
+    OrderBook(size_t max_orders, int64_t center, size_t window = 4096)
+        : window_(static_cast<int64_t>(window)), base_(center - static_cast<int64_t>(window) / 2)
+        , pool_(max_orders), ids_(max_orders), scratch_(window) {
+        for (BookSide& s : sides_) {
+            s.levels.resize(window);
+            s.occupied = OccupancyBitmap(window);
+        }
+        sides_[0].best = no_bid;
+        sides_[1].best = no_ask;
+    }
+
+    ~OrderBook() {
+        clear();
+    }
+
+    OrderBook(const OrderBook&) = delete;
+    OrderBook& operator=(const OrderBook&) = delete;
+
+    // False if the id is already live. Throws std::bad_alloc past max_orders.
+    bool add(uint64_t id, Side side, int64_t price, uint32_t quantity) {
+        if (UNLIKELY(ids_.find(id) != nullptr)) return false;
+        Order* order = pool_.allocate();
+        *order = Order{id, price, quantity, side, nullptr, nullptr};
+        ids_.insert(id, order);
+        link(order);
+        ++orders_;
+        return true;
+    }
+
+    // A smaller quantity at the same price keeps the order's place in the queue;
+    // anything else sends it to the back of its new level.
+    bool modify(uint64_t id, int64_t price, uint32_t quantity) {
+        Order* order = ids_.find(id);
+        if (UNLIKELY(order == nullptr)) return false;
+        if (quantity == 0) return cancel(id);
+        if (price == order->price && quantity <= order->quantity) {
+            level(order->side, price).quantity -= order->quantity - quantity;
+            order->quantity = quantity;
+            return true;
+        }
+        unlink(order);
+        order->price = price;
+        order->quantity = quantity;
+        link(order);
+        return true;
+    }
+
+    bool cancel(uint64_t id) {
+        Order* order = ids_.erase(id);
+        if (UNLIKELY(order == nullptr)) return false;
+        unlink(order);
+        pool_.deallocate(order);
+        --orders_;
+        return true;
+    }
+
+    // Fills up to quantity of the order; it leaves the book once nothing is left.
+    bool execute(uint64_t id, uint32_t quantity) {
+        Order* order = ids_.find(id);
+        if (UNLIKELY(order == nullptr)) return false;
+        const uint32_t filled = std::min(quantity, order->quantity);
+        if (filled == order->quantity) return cancel(id);
+        level(order->side, order->price).quantity -= filled;
+        order->quantity -= filled;
+        return true;
+    }
+
+    Quote best_bid() const { return best(Side::Buy); }
+    Quote best_ask() const { return best(Side::Sell); }
+
+    uint64_t quantity_at(Side side, int64_t price) const {
+        const Level* l = find_level(side, price);
+        return l ? l->quantity : 0;
+    }
+
+    const Order* find(uint64_t id) const { return ids_.find(id); }
+    size_t orders() const { return orders_; }
+    int64_t window_low() const { return base_; }
+    int64_t window_high() const { return base_ + window_ - 1; }
+
+    // Removes every order, keeping the memory and the window.
+    void clear() {
+        for (BookSide& s : sides_) {
+            for (Level& l : s.levels) release(l);
+            for (auto& [price, l] : s.overflow) release(l);
+            s.overflow.clear();
+            s.occupied.clear();
+        }
+        sides_[0].best = no_bid;
+        sides_[1].best = no_ask;
+        ids_.clear();
+        orders_ = 0;
+    }
+
+private:
+    struct BookSide {
+        std::vector<Level> levels;           // price base_ + i at levels[i]
+        std::map<int64_t, Level> overflow;   // outside the window; never holds empty levels
+        OccupancyBitmap occupied{0};         // bit i set while levels[i] has orders
+        int64_t best;
+    };
+
+    static bool better(Side side, int64_t a, int64_t b) {
+        return side == Side::Buy ? a > b : a < b;
+    }
+
+    bool in_window(int64_t price) const {
+        return static_cast<uint64_t>(price - base_) < static_cast<uint64_t>(window_);
+    }
+
+    Level& level(Side side, int64_t price) {
+        BookSide& s = sides_[static_cast<size_t>(side)];
+        if (LIKELY(in_window(price))) return s.levels[static_cast<size_t>(price - base_)];
+        return s.overflow[price];
+    }
+
+    const Level* find_level(Side side, int64_t price) const {
+        const BookSide& s = sides_[static_cast<size_t>(side)];
+        if (in_window(price)) return &s.levels[static_cast<size_t>(price - base_)];
+        auto it = s.overflow.find(price);
+        return it == s.overflow.end() ? nullptr : &it->second;
+    }
+
+    Quote best(Side side) const {
+        const BookSide& s = sides_[static_cast<size_t>(side)];
+        const Level* l = s.best == (side == Side::Buy ? no_bid : no_ask) ? nullptr : find_level(side, s.best);
+        return Quote{s.best, l ? l->quantity : 0};
+    }
+
+    void link(Order* order) {
+        if (UNLIKELY(!in_window(order->price))) recenter();
+        BookSide& s = sides_[static_cast<size_t>(order->side)];
+        Level& l = level(order->side, order->price);
+        if (l.empty() && LIKELY(in_window(order->price))) s.occupied.set(static_cast<size_t>(order->price - base_));
+        l.push_back(order);
+        if (better(order->side, order->price, s.best)) s.best = order->price;
+    }
+
+    void unlink(Order* order) {
+        const Side side = order->side;
+        const int64_t price = order->price;
+        BookSide& s = sides_[static_cast<size_t>(side)];
+        Level& l = level(side, price);
+        l.remove(order);
+        if (!l.empty()) return;
+        if (LIKELY(in_window(price))) s.occupied.reset(static_cast<size_t>(price - base_));
+        else s.overflow.erase(price);
+        if (price == s.best) s.best = next_best(side, price);
+    }
+
+    // The best non-empty price strictly behind `from`, or the side's empty marker.
+    int64_t next_best(Side side, int64_t from) const {
+        const BookSide& s = sides_[static_cast<size_t>(side)];
+        if (side == Side::Buy) {
+            auto it = s.overflow.lower_bound(from);
+            const int64_t outside = it == s.overflow.begin() ? no_bid : std::prev(it)->first;
+            if (outside > window_high() || from <= base_) return outside;
+            const size_t i = s.occupied.prev(static_cast<size_t>(std::min(from - 1, window_high()) - base_));
+            return i == OccupancyBitmap::npos ? outside : base_ + static_cast<int64_t>(i);
+        }
+        auto it = s.overflow.upper_bound(from);
+        const int64_t outside = it == s.overflow.end() ? no_ask : it->first;
+        if (outside < base_ || from >= window_high()) return outside;
+        const size_t i = s.occupied.next(static_cast<size_t>(std::max(from + 1, base_) - base_));
+        return i == OccupancyBitmap::npos ? outside : base_ + static_cast<int64_t>(i);
+    }
+
+    // Moves the window to center on the mid (or on whichever side has a best price),
+    // unless that is within a quarter window of where it is now.
+    void recenter() {
+        const int64_t bid = sides_[0].best, ask = sides_[1].best;
+        int64_t center;
+        if (bid != no_bid && ask != no_ask) center = bid + (ask - bid) / 2;
+        else if (bid != no_bid) center = bid;
+        else if (ask != no_ask) center = ask;
+        else return;
+        const int64_t base = center - window_ / 2;
+        if (std::abs(base - base_) < window_ / 4) return;
+
+        for (BookSide& s : sides_) {
+            std::fill(scratch_.begin(), scratch_.end(), Level{});
+            s.occupied.clear();
+            for (int64_t i = 0; i < window_; ++i) {
+                Level& l = s.levels[static_cast<size_t>(i)];
+                if (l.empty()) continue;
+                const int64_t price = base_ + i;
+                if (static_cast<uint64_t>(price - base) < static_cast<uint64_t>(window_)) {
+                    scratch_[static_cast<size_t>(price - base)] = l;
+                    s.occupied.set(static_cast<size_t>(price - base));
+                } else {
+                    s.overflow.emplace(price, l);
+                }
+                l = Level{};
+            }
+            for (auto it = s.overflow.lower_bound(base); it != s.overflow.end() && it->first < base + window_;) {
+                scratch_[static_cast<size_t>(it->first - base)] = it->second;
+                s.occupied.set(static_cast<size_t>(it->first - base));
+                it = s.overflow.erase(it);
+            }
+            s.levels.swap(scratch_);
+        }
+        base_ = base;
+    }
+
+    void release(Level& l) {
+        for (Order* order = l.head; order != nullptr;) {
+            Order* next = order->next;
+            pool_.deallocate(order);
+            order = next;
+        }
+        l = Level{};
+    }
+
+    int64_t window_;
+    int64_t base_;
+    BookSide sides_[2];   // indexed by Side
+    PoolAllocator<Order> pool_;
+    OrderIdMap ids_;
+    std::vector<Level> scratch_;
+    size_t orders_ = 0;
+};
+
+
+// The same book over a std::map of levels per side: the usual first implementation,
+// kept as the baseline. Every new price allocates a node and every lookup walks the
+// tree; the best price is the first or last node.
+class MapOrderBook {
+public:
+    explicit MapOrderBook(size_t max_orders)
+        : pool_(max_orders), ids_(max_orders) {}
+
+    ~MapOrderBook() {
+        clear();
+    }
+
+    MapOrderBook(const MapOrderBook&) = delete;
+    MapOrderBook& operator=(const MapOrderBook&) = delete;
+
+    bool add(uint64_t id, Side side, int64_t price, uint32_t quantity) {
+        if (UNLIKELY(ids_.find(id) != nullptr)) return false;
+        Order* order = pool_.allocate();
+        *order = Order{id, price, quantity, side, nullptr, nullptr};
+        ids_.insert(id, order);
+        levels(side)[price].push_back(order);
+        ++orders_;
+        return true;
+    }
+
+    bool modify(uint64_t id, int64_t price, uint32_t quantity) {
+        Order* order = ids_.find(id);
+        if (UNLIKELY(order == nullptr)) return false;
+        if (quantity == 0) return cancel(id);
+        if (price == order->price && quantity <= order->quantity) {
+            levels(order->side)[price].quantity -= order->quantity - quantity;
+            order->quantity = quantity;
+            return true;
+        }
+        unlink(order);
+        order->price = price;
+        order->quantity = quantity;
+        levels(order->side)[price].push_back(order);
+        return true;
+    }
+
+    bool cancel(uint64_t id) {
+        Order* order = ids_.erase(id);
+        if (UNLIKELY(order == nullptr)) return false;
+        unlink(order);
+        pool_.deallocate(order);
+        --orders_;
+        return true;
+    }
+
+    bool execute(uint64_t id, uint32_t quantity) {
+        Order* order = ids_.find(id);
+        if (UNLIKELY(order == nullptr)) return false;
+        const uint32_t filled = std::min(quantity, order->quantity);
+        if (filled == order->quantity) return cancel(id);
+        levels(order->side)[order->price].quantity -= filled;
+        order->quantity -= filled;
+        return true;
+    }
+
+    Quote best_bid() const {
+        if (bids_.empty()) return Quote{OrderBook::no_bid, 0};
+        return Quote{bids_.rbegin()->first, bids_.rbegin()->second.quantity};
+    }
+
+    Quote best_ask() const {
+        if (asks_.empty()) return Quote{OrderBook::no_ask, 0};
+        return Quote{asks_.begin()->first, asks_.begin()->second.quantity};
+    }
+
+    size_t orders() const { return orders_; }
+
+    void clear() {
+        for (auto* side : {&bids_, &asks_}) {
+            for (auto& [price, l] : *side) {
+                for (Order* order = l.head; order != nullptr;) {
+                    Order* next = order->next;
+                    pool_.deallocate(order);
+                    order = next;
+                }
+            }
+            side->clear();
+        }
+        ids_.clear();
+        orders_ = 0;
+    }
+
+private:
+    std::map<int64_t, Level>& levels(Side side) { return side == Side::Buy ? bids_ : asks_; }
+
+    void unlink(Order* order) {
+        std::map<int64_t, Level>& side = levels(order->side);
+        auto it = side.find(order->price);
+        it->second.remove(order);
+        if (it->second.empty()) side.erase(it);
+    }
+
+    std::map<int64_t, Level> bids_;
+    std::map<int64_t, Level> asks_;
+    PoolAllocator<Order> pool_;
+    OrderIdMap ids_;
+    size_t orders_ = 0;
+};
+
+}
+
+
+// A feed message for the book benchmarks. Prices are ticks.
+struct BookMessage {
+    enum Type : uint8_t { Add, Modify, Cancel, Execute };
+    Type type;
+    book::Side side;
+    uint32_t quantity;
+    uint64_t id;
+    int64_t price;
+};
+
+enum class MessageMix : int {
+    AddCancel,   // quoting: nearly every add is cancelled, few trades
+    Trading,     // a busy session: a fifth of the messages are executions
+};
+
+// A replayable stream for one instrument. The mid takes a tick random walk step every
+// 20 messages; orders rest a few ticks behind it (exponential, mean 8), with 1% far
+// out stub quotes. Cancels, modifies and executions pick a random live order, and the
+// book is held near live_target orders.
+inline std::vector<BookMessage> generateBookMessages(size_t n, MessageMix mix, int64_t mid, size_t live_target = 20000) {
+    const double add = mix == MessageMix::AddCancel ? 0.49 : 0.45;
+    const double cancel = add + (mix == MessageMix::AddCancel ? 0.45 : 0.30);
+    const double modify = cancel + (mix == MessageMix::AddCancel ? 0.03 : 0.05);
+
+    std::mt19937_64 rng(11);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::exponential_distribution<double> depth(1.0 / 8.0);
+    std::uniform_int_distribution<int64_t> stub(2000, 10000);
+    std::uniform_int_distribution<uint32_t> quantity(1, 500);
+
+    struct Live { uint64_t id; book::Side side; int64_t price; uint32_t quantity; };
+    std::vector<Live> live;
+    std::vector<BookMessage> messages;
+    messages.reserve(n);
+    uint64_t next_id = 1;
+
+    auto price_for = [&](book::Side side) {
+        const int64_t offset = 1 + (uniform(rng) < 0.01 ? stub(rng) : static_cast<int64_t>(depth(rng)));
+        return side == book::Side::Buy ? mid - offset : mid + offset;
+    };
+
+    for (size_t i = 0; i < n; ++i) {
+        if (i % 20 == 0) mid += uniform(rng) < 0.5 ? -1 : 1;
+        const double r = uniform(rng);
+        if (live.empty() || (r < add && live.size() < live_target)) {
+            const book::Side side = uniform(rng) < 0.5 ? book::Side::Buy : book::Side::Sell;
+            const Live order{next_id++, side, price_for(side), quantity(rng)};
+            live.push_back(order);
+            messages.push_back({BookMessage::Add, side, order.quantity, order.id, order.price});
+            continue;
+        }
+        const size_t k = std::uniform_int_distribution<size_t>(0, live.size() - 1)(rng);
+        Live& order = live[k];
+        if (r < cancel || r < add) {
+            messages.push_back({BookMessage::Cancel, order.side, 0, order.id, order.price});
+            order = live.back();
+            live.pop_back();
+        } else if (r < modify) {
+            if (uniform(rng) < 0.5) {
+                order.quantity = std::max<uint32_t>(1, order.quantity / 2);
+            } else {
+                order.price = price_for(order.side);
+                order.quantity = quantity(rng);
+            }
+            messages.push_back({BookMessage::Modify, order.side, order.quantity, order.id, order.price});
+        } else {
+            const uint32_t filled = uniform(rng) < 0.5 ? order.quantity : std::uniform_int_distribution<uint32_t>(1, order.quantity)(rng);
+            messages.push_back({BookMessage::Execute, order.side, filled, order.id, order.price});
+            order.quantity -= filled;
+            if (order.quantity == 0) {
+                order = live.back();
+                live.pop_back();
+            }
+        }
+    }
+    return messages;
+}
+
+template<typename Book>
+void apply(Book& book, const BookMessage& m) {
+    switch (m.type) {
+    case BookMessage::Add:     book.add(m.id, m.side, m.price, m.quantity); break;
+    case BookMessage::Modify:  book.modify(m.id, m.price, m.quantity); break;
+    case BookMessage::Cancel:  book.cancel(m.id); break;
+    case BookMessage::Execute: book.execute(m.id, m.quantity); break;
+    }
+}
+
+
+// Replays 1M messages of each mix into an OrderBook, cleared between iterations.
+// time_per_message is the mean. BM_MessageLatency times every message on its own with
+// the TSC for p50, p99 and p99.9; the reads slow the loop down (a lot under some
+// hypervisors), so take its throughput from BM_Replay.
+class OrderBookBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        messages = generateBookMessages(n_messages, static_cast<MessageMix>(state.range(0)), center);
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+        messages.clear();
+    }
+
+    static const size_t n_messages = 1000000;
+    static constexpr int64_t center = 1000000;
+    std::vector<BookMessage> messages;
+};
+
+
+BENCHMARK_DEFINE_F(OrderBookBenchmark, BM_Replay)(benchmark::State& state) {
+    book::OrderBook book(n_messages, center);
+    for (auto _ : alloc_counter::counted(state)) {
+        state.PauseTiming();
+        book.clear();
+        state.ResumeTiming();
+        for (const BookMessage& m : messages) apply(book, m);
+        benchmark::DoNotOptimize(book.best_bid());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_messages));
+    state.counters["time_per_message"] = benchmark::Counter(
+        static_cast<double>(n_messages), benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+BENCHMARK_REGISTER_F(OrderBookBenchmark, BM_Replay)
+    ->ArgName("mix")
+    ->Arg(static_cast<int>(MessageMix::AddCancel))
+    ->Arg(static_cast<int>(MessageMix::Trading))
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(OrderBookBenchmark, BM_MessageLatency)(benchmark::State& state) {
+    book::OrderBook book(n_messages, center);
+    latency::Samples samples(n_messages);
+    for (auto _ : alloc_counter::counted(state)) {
+        state.PauseTiming();
+        book.clear();
+        samples.clear();
+        state.ResumeTiming();
+        for (const BookMessage& m : messages) {
+            const uint64_t start = latency::now();
+            apply(book, m);
+            samples.record(start, latency::now());
+        }
+        benchmark::DoNotOptimize(book.best_bid());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_messages));
+    samples.report(state);
+}
+BENCHMARK_REGISTER_F(OrderBookBenchmark, BM_MessageLatency)
+    ->ArgName("mix")
+    ->Arg(static_cast<int>(MessageMix::AddCancel))
+    ->Arg(static_cast<int>(MessageMix::Trading))
+    ->Unit(benchmark::kMillisecond);
+
+
+// Worst cases for finding the next best price, on a wide-tick book: levels `gap` ticks
+// apart, 512 a side with one order each, in a 2^16 tick window. BM_Sweep executes the
+// asks from the touch outwards, as a large buy would, so every execution empties the
+// best level. BM_CancelStorm pulls the top 64 bids one after another and puts them
+// back, as a quoter repricing on a signal would. items_per_second counts messages.
+class BookSweepBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        gap = state.range(0);
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    // Asks get ids 1 .. depth from the touch outwards, bids depth + 1 .. 2 * depth.
+    template<typename Book>
+    void fill(Book& book) const {
+        for (int64_t k = 0; k < depth; ++k) {
+            book.add(static_cast<uint64_t>(1 + k), book::Side::Sell, center + 1 + k * gap, 100);
+            book.add(static_cast<uint64_t>(1 + depth + k), book::Side::Buy, center - 1 - k * gap, 100);
+        }
+    }
+
+    template<typename Book>
+    void sweep(Book& book, benchmark::State& state) const {
+        for (auto _ : alloc_counter::counted(state)) {
+            state.PauseTiming();
+            book.clear();
+            fill(book);
+            state.ResumeTiming();
+            for (int64_t k = 0; k < depth; ++k) {
+                book.execute(static_cast<uint64_t>(1 + k), 100);
+                benchmark::DoNotOptimize(book.best_ask());
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * depth);
+    }
+
+    template<typename Book>
+    void cancel_storm(Book& book, benchmark::State& state) const {
+        fill(book);
+        for (auto _ : alloc_counter::counted(state)) {
+            for (int64_t k = 0; k < storm; ++k) {
+                book.cancel(static_cast<uint64_t>(1 + depth + k));
+                benchmark::DoNotOptimize(book.best_bid());
+            }
+            for (int64_t k = storm - 1; k >= 0; --k) {
+                book.add(static_cast<uint64_t>(1 + depth + k), book::Side::Buy, center - 1 - k * gap, 100);
+                benchmark::DoNotOptimize(book.best_bid());
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * 2 * storm);
+    }
+
+    static const int64_t depth = 512;
+    static const int64_t storm = 64;
+    static constexpr int64_t center = 1000000;
+    static const size_t window = size_t(1) << 16;
+    int64_t gap = 1;
+};
+
+
+BENCHMARK_DEFINE_F(BookSweepBenchmark, BM_SweepArray)(benchmark::State& state) {
+    book::OrderBook book(2 * depth, center, window);
+    sweep(book, state);
+}
+BENCHMARK_REGISTER_F(BookSweepBenchmark, BM_SweepArray)->ArgName("gap")->RangeMultiplier(8)->Range(1, 64);
+
+BENCHMARK_DEFINE_F(BookSweepBenchmark, BM_SweepMap)(benchmark::State& state) {
+    book::MapOrderBook book(2 * depth);
+    sweep(book, state);
+}
+BENCHMARK_REGISTER_F(BookSweepBenchmark, BM_SweepMap)->ArgName("gap")->RangeMultiplier(8)->Range(1, 64);
+
+BENCHMARK_DEFINE_F(BookSweepBenchmark, BM_CancelStormArray)(benchmark::State& state) {
+    book::OrderBook book(2 * depth, center, window);
+    cancel_storm(book, state);
+}
+BENCHMARK_REGISTER_F(BookSweepBenchmark, BM_CancelStormArray)->ArgName("gap")->RangeMultiplier(8)->Range(1, 64);
+
+BENCHMARK_DEFINE_F(BookSweepBenchmark, BM_CancelStormMap)(benchmark::State& state) {
+    book::MapOrderBook book(2 * depth);
+    cancel_storm(book, state);
+}
+BENCHMARK_REGISTER_F(BookSweepBenchmark, BM_CancelStormMap)->ArgName("gap")->RangeMultiplier(8)->Range(1, 64);
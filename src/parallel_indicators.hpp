@@ -0,0 +1,184 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "vos_vs_sov.hpp"
+#include "worker_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+
+namespace parallel {
+
+// SOV::ADX for every symbol of a universe, spread over a WorkerPool.
+//
+// load() cuts the universe into one shard per worker, contiguous runs of symbols with
+// about the same number of bars each, and has each worker copy its own shard. Linux
+// places a page on the NUMA node of the thread that first touches it, so every shard
+// ends up local to the worker that mostly reads it.
+//
+// compute() hands out symbols in chunks from a cursor per shard. A worker drains its
+// own shard first and then steals chunks from the others, so a slow core or an
+// uneven shard doesn't leave the rest idle at the end.
+class ADXBatch {
+public:
+    explicit ADXBatch(WorkerPool& pool, size_t chunk = 16)
+        : pool_(pool), chunk_(std::max<size_t>(chunk, 1)) {}
+
+    // universe[k] is anything that converts to an SOV::OpenHighLowClosesView; only
+    // highs, lows and closes are copied.
+    template<typename Universe>
+    void load(const Universe& universe) {
+        const size_t count = std::size(universe);
+        size_ = count;
+        shards_.clear();
+        size_t total_bars = 0;
+        for (size_t k = 0; k < count; ++k) {
+            total_bars += SOV::OpenHighLowClosesView(universe[k]).closes.size();
+        }
+
+        const size_t workers = pool_.size();
+        size_t first = 0, bars = 0;
+        for (size_t w = 0; w < workers; ++w) {
+            auto shard = std::make_unique<Shard>();
+            shard->first = first;
+            const size_t target = total_bars * (w + 1) / workers;
+            while (first < count && (bars < target || w + 1 == workers)) {
+                bars += SOV::OpenHighLowClosesView(universe[first]).closes.size();
+                ++first;
+            }
+            shard->count = first - shard->first;
+            shards_.push_back(std::move(shard));
+        }
+
+        auto copy = [&](size_t worker) {
+            Shard& shard = *shards_[worker];
+            shard.offsets.assign(1, 0);
+            for (size_t k = 0; k < shard.count; ++k) {
+                shard.offsets.push_back(shard.offsets.back() + SOV::OpenHighLowClosesView(universe[shard.first + k]).closes.size());
+            }
+            shard.highs.resize(shard.offsets.back());
+            shard.lows.resize(shard.offsets.back());
+            shard.closes.resize(shard.offsets.back());
+            for (size_t k = 0; k < shard.count; ++k) {
+                const SOV::OpenHighLowClosesView symbol(universe[shard.first + k]);
+                std::copy(symbol.highs.begin(), symbol.highs.end(), shard.highs.begin() + shard.offsets[k]);
+                std::copy(symbol.lows.begin(), symbol.lows.end(), shard.lows.begin() + shard.offsets[k]);
+                std::copy(symbol.closes.begin(), symbol.closes.end(), shard.closes.begin() + shard.offsets[k]);
+            }
+        };
+        pool_.run(copy);
+    }
+
+    // out[k] is the ADX of universe[k]; out needs room for size().
+    void compute(float* out, size_t period = 14) {
+        for (auto& shard : shards_) shard->next.store(0, std::memory_order_relaxed);
+        auto task = [&](size_t worker) {
+            for (size_t s = 0; s < shards_.size(); ++s) {
+                Shard& shard = *shards_[(worker + s) % shards_.size()];
+                for (;;) {
+                    const size_t begin = shard.next.fetch_add(chunk_, std::memory_order_relaxed);
+                    if (begin >= shard.count) break;
+                    const size_t end = std::min(begin + chunk_, shard.count);
+                    for (size_t k = begin; k < end; ++k) {
+                        out[shard.first + k] = SOV::ADX(shard.view(k), period);
+                    }
+                }
+            }
+        };
+        pool_.run(task);
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    // Aligned so the cursors of neighbouring shards don't share a cache line.
+    struct alignas(64) Shard {
+        std::atomic<size_t> next{0};
+        size_t first = 0;   // universe index of the shard's first symbol
+        size_t count = 0;
+        std::vector<size_t> offsets;   // symbol k is bars [offsets[k], offsets[k + 1])
+        std::vector<float> highs;
+        std::vector<float> lows;
+        std::vector<float> closes;
+
+        SOV::OpenHighLowClosesView view(size_t k) const {
+            const size_t offset = offsets[k], bars = offsets[k + 1] - offsets[k];
+            return {{}, std::span(highs).subspan(offset, bars), std::span(lows).subspan(offset, bars),
+                    std::span(closes).subspan(offset, bars), {}};
+        }
+    };
+
+    WorkerPool& pool_;
+    size_t chunk_;
+    size_t size_ = 0;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}
+
+
+// End-of-day ADX over a universe, from one thread up to every core. The universe is
+// 2000 symbols x 5000 bars (a 10000 x 50000 run needs 6GB for the three columns alone);
+// per-symbol work is the same, so the scaling carries over. items_per_second counts
+// symbols and efficiency is the speedup over the single-thread run divided by the
+// thread count, reported once that run has happened.
+class ParallelADXBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        if (universe.size() == n_symbols) return;
+        for (size_t k = 0; k < n_symbols; ++k) {
+            SOV::OpenHighLowCloses symbol = generateSOVData(n_bars);
+            symbol.opens = {};
+            universe.push_back(std::move(symbol));
+        }
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    static void thread_counts(benchmark::internal::Benchmark* benchmark) {
+        const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for (int threads = 1; threads < cores; threads *= 2) benchmark->Arg(threads);
+        benchmark->Arg(cores);
+    }
+
+    static const size_t n_symbols = 2000;
+    static const size_t n_bars = 5000;
+    static inline std::vector<SOV::OpenHighLowCloses> universe;
+    static inline double single_thread_seconds = 0.0;
+};
+
+
+BENCHMARK_DEFINE_F(ParallelADXBenchmark, BM_ADXBatch)(benchmark::State& state) {
+    const auto threads = static_cast<size_t>(state.range(0));
+    WorkerPool pool(threads);
+    parallel::ADXBatch batch(pool);
+    batch.load(universe);
+    std::vector<float> out(batch.size());
+
+    const auto start = std::chrono::steady_clock::now();
+    for (auto _ : alloc_counter::counted(state)) {
+        batch.compute(out.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+                         / static_cast<double>(state.iterations());
+
+    state.SetItemsProcessed(state.iterations() * n_symbols);
+    if (threads == 1) single_thread_seconds = seconds;
+    if (single_thread_seconds > 0.0) {
+        state.counters["efficiency"] = single_thread_seconds / (seconds * static_cast<double>(threads));
+    }
+}
+BENCHMARK_REGISTER_F(ParallelADXBenchmark, BM_ADXBatch)
+    ->ArgName("threads")
+    ->Apply(ParallelADXBenchmark::thread_counts)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
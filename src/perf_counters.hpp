@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+// One hardware counter for the calling thread, user space only, read through
+// perf_event_open. Containers and kernels with perf_event_paranoid > 2 usually refuse
+// the syscall; available() is then false and stop() returns 0, so benchmarks report the
+// counter only when it exists instead of failing.
+class PerfCounter {
+public:
+#if defined(__linux__)
+    PerfCounter(uint32_t type, uint64_t config) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    static PerfCounter branch_misses() { return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}; }
+
+    ~PerfCounter() { if (fd_ >= 0) close(fd_); }
+
+    void start() {
+        if (fd_ < 0) return;
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    uint64_t stop() {
+        if (fd_ < 0) return 0;
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t count = 0;
+        if (read(fd_, &count, sizeof(count)) != sizeof(count)) return 0;
+        return count;
+    }
+#else
+    static PerfCounter branch_misses() { return {}; }
+    void start() {}
+    uint64_t stop() { return 0; }
+#endif
+
+    PerfCounter(PerfCounter&& other) noexcept : fd_(other.fd_) { other.fd_ = -1; }
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+    PerfCounter& operator=(PerfCounter&&) = delete;
+
+    bool available() const { return fd_ >= 0; }
+
+private:
+#if !defined(__linux__)
+    PerfCounter() = default;
+#endif
+    int fd_ = -1;
+};
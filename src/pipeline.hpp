@@ -0,0 +1,422 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "itch.hpp"
+#include "order_book.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+// Chaining processing stages at compile time. A stage derives from Stage<Self> and
+// defines process(event, next), calling next(event) zero or more times to pass events
+// on. Pipeline<A, B, C> hands every pushed event to A with a `next` that is B, whose
+// `next` is C: the whole chain is known to the compiler, so it inlines into one
+// function with no indirect calls. Optional<false, S> removes S from the chain
+// altogether; it isn't even stored.
+namespace pipeline {
+
+template<typename Derived>
+struct Stage {
+    template<typename Event, typename Next>
+    void operator()(Event& event, Next& next) {
+        static_cast<Derived&>(*this).process(event, next);
+    }
+};
+
+struct Disabled {};
+
+template<bool Enabled, typename S>
+using Optional = std::conditional_t<Enabled, S, Disabled>;
+
+template<typename... Stages>
+class Chain {
+public:
+    template<typename Event>
+    void push(Event& event) {
+        run<0>(event);
+    }
+
+    template<size_t I>
+    auto& stage() { return std::get<I>(stages_); }
+
+    static constexpr size_t size() { return sizeof...(Stages); }
+
+private:
+    static_assert((std::is_base_of_v<Stage<Stages>, Stages> && ...), "pipeline stages derive from Stage<Self>");
+
+    // The continuation stage I - 1 calls: stage I, or nothing past the end.
+    template<size_t I>
+    struct Next {
+        Chain& chain;
+        template<typename Event>
+        void operator()(Event& event) { chain.template run<I>(event); }
+    };
+
+    template<size_t I, typename Event>
+    void run(Event& event) {
+        if constexpr (I < sizeof...(Stages)) {
+            Next<I + 1> next{*this};
+            auto& stage = std::get<I>(stages_);
+            static_cast<Stage<std::remove_reference_t<decltype(stage)>>&>(stage)(event, next);
+        }
+    }
+
+    std::tuple<Stages...> stages_;
+};
+
+namespace detail {
+
+template<typename... Ts>
+struct type_list {};
+
+template<typename Kept, typename... Rest>
+struct strip_disabled;
+
+template<typename... Kept>
+struct strip_disabled<type_list<Kept...>> {
+    using type = Chain<Kept...>;
+};
+
+template<typename... Kept, typename S, typename... Rest>
+struct strip_disabled<type_list<Kept...>, S, Rest...>
+    : strip_disabled<std::conditional_t<std::is_same_v<S, Disabled>, type_list<Kept...>, type_list<Kept..., S>>, Rest...> {};
+
+}
+
+template<typename... Stages>
+using Pipeline = typename detail::strip_disabled<detail::type_list<>, Stages...>::type;
+
+}
+
+
+// A feed handler as a pipeline: ITCH bytes in, a top-of-book signal out. Every stage
+// reads and fills in the same FeedEvent.
+namespace feed {
+
+struct FeedEvent {
+    enum Kind : uint8_t { None, Add, Execute, Cancel, Delete, Replace };
+
+    const uint8_t* message = nullptr;   // one ITCH message, without its length prefix
+    size_t length = 0;
+    Kind kind = None;
+    book::Side side = book::Side::Buy;
+    uint16_t instrument = 0;
+    uint64_t id = 0;
+    uint64_t new_id = 0;     // Replace only
+    int64_t price = 0;       // ITCH units (4 decimals) until Normalize, then ticks
+    uint32_t quantity = 0;
+    book::Quote bid{};       // filled in by BookUpdate when the top of book changes
+    book::Quote ask{};
+};
+
+// The order-book messages into FeedEvents; everything else stops here, as do messages
+// shorter than their type's size (see itch::Decoder).
+struct Decode : pipeline::Stage<Decode> {
+    template<typename Next>
+    void process(FeedEvent& e, Next& next) {
+        if (UNLIKELY(e.length == 0)) return;
+        switch (itch::Message{e.message}.type()) {
+        case itch::AddOrder::id:
+        case itch::AddOrderMPID::id: {
+            if (UNLIKELY(e.length < itch::AddOrder::size)) return;
+            const itch::AddOrder add{e.message};
+            e.kind = FeedEvent::Add;
+            e.id = add.order_reference();
+            e.side = add.buy() ? book::Side::Buy : book::Side::Sell;
+            e.price = add.price();
+            e.quantity = add.shares();
+            break;
+        }
+        case itch::OrderExecuted::id:
+        case itch::OrderExecutedWithPrice::id: {
+            if (UNLIKELY(e.length < itch::OrderExecuted::size)) return;
+            const itch::OrderExecuted executed{e.message};
+            e.kind = FeedEvent::Execute;
+            e.id = executed.order_reference();
+            e.quantity = executed.executed_shares();
+            break;
+        }
+        case itch::OrderCancel::id: {
+            if (UNLIKELY(e.length < itch::OrderCancel::size)) return;
+            const itch::OrderCancel cancel{e.message};
+            e.kind = FeedEvent::Cancel;
+            e.id = cancel.order_reference();
+            e.quantity = cancel.cancelled_shares();
+            break;
+        }
+        case itch::OrderDelete::id:
+            if (UNLIKELY(e.length < itch::OrderDelete::size)) return;
+            e.kind = FeedEvent::Delete;
+            e.id = itch::OrderDelete{e.message}.order_reference();
+            break;
+        case itch::OrderReplace::id: {
+            if (UNLIKELY(e.length < itch::OrderReplace::size)) return;
+            const itch::OrderReplace replace{e.message};
+            e.kind = FeedEvent::Replace;
+            e.id = replace.original_order_reference();
+            e.new_id = replace.new_order_reference();
+            e.price = replace.price();
+            e.quantity = replace.shares();
+            break;
+        }
+        default:
+            return;
+        }
+        e.instrument = itch::Message{e.message}.stock_locate();
+        next(e);
+    }
+};
+
+// Drops instruments we don't trade: all but stock locates first .. first + count - 1.
+struct Subscribe : pipeline::Stage<Subscribe> {
+    static constexpr uint16_t first = 1;
+    static constexpr uint16_t count = 2;
+
+    template<typename Next>
+    void process(FeedEvent& e, Next& next) {
+        if (static_cast<uint16_t>(e.instrument - first) < count) next(e);
+    }
+};
+
+// Stock locates to our instrument index and ITCH prices to ticks of a cent.
+struct Normalize : pipeline::Stage<Normalize> {
+    template<typename Next>
+    void process(FeedEvent& e, Next& next) {
+        e.instrument -= Subscribe::first;
+        e.price /= 100;
+        next(e);
+    }
+};
+
+// Applies the event to the instrument's book and passes it on only if the best bid
+// or ask changed.
+struct BookUpdate : pipeline::Stage<BookUpdate> {
+    static constexpr size_t max_orders = 100000;
+
+    BookUpdate() {
+        // $0 to $655.35 in cents, so the generated prices never leave the window.
+        for (auto& b : books) b = std::make_unique<book::OrderBook>(max_orders, 32768, 65536);
+    }
+
+    void clear() {
+        for (auto& b : books) b->clear();
+    }
+
+    template<typename Next>
+    void process(FeedEvent& e, Next& next) {
+        book::OrderBook& b = *books[e.instrument];
+        const book::Quote bid = b.best_bid(), ask = b.best_ask();
+        switch (e.kind) {
+        case FeedEvent::Add:
+            b.add(e.id, e.side, e.price, e.quantity);
+            break;
+        case FeedEvent::Execute:
+            b.execute(e.id, e.quantity);
+            break;
+        case FeedEvent::Cancel:
+            if (const book::Order* o = b.find(e.id)) {
+                b.modify(e.id, o->price, o->quantity > e.quantity ? o->quantity - e.quantity : 0);
+            }
+            break;
+        case FeedEvent::Delete:
+            b.cancel(e.id);
+            break;
+        case FeedEvent::Replace:
+            if (const book::Order* o = b.find(e.id)) {
+                const book::Side side = o->side;
+                b.cancel(e.id);
+                b.add(e.new_id, side, e.price, e.quantity);
+            }
+            break;
+        default:
+            break;
+        }
+        e.bid = b.best_bid();
+        e.ask = b.best_ask();
+        if (e.bid.price != bid.price || e.bid.quantity != bid.quantity ||
+            e.ask.price != ask.price || e.ask.quantity != ask.quantity) {
+            next(e);
+        }
+    }
+
+    std::unique_ptr<book::OrderBook> books[Subscribe::count];
+};
+
+// Top-of-book imbalance, (bid size - ask size) / (bid size + ask size), summed over
+// every change.
+struct Signal : pipeline::Stage<Signal> {
+    double imbalance = 0.0;
+    uint64_t updates = 0;
+
+    template<typename Next>
+    void process(FeedEvent& e, Next& next) {
+        const double total = static_cast<double>(e.bid.quantity + e.ask.quantity);
+        if (total > 0.0) {
+            imbalance += (static_cast<double>(e.bid.quantity) - static_cast<double>(e.ask.quantity)) / total;
+        }
+        ++updates;
+        next(e);
+    }
+};
+
+// Event counts by kind, for debugging a feed; compiled out unless enabled.
+struct Audit : pipeline::Stage<Audit> {
+    uint64_t counts[6] = {};
+
+    template<typename Next>
+    void process(FeedEvent& e, Next& next) {
+        ++counts[e.kind];
+        next(e);
+    }
+};
+
+template<bool Audited>
+using Handler = pipeline::Pipeline<Decode, pipeline::Optional<Audited, Audit>, Subscribe, Normalize, BookUpdate, Signal>;
+
+static_assert(Handler<false>::size() == 5);
+static_assert(Handler<true>::size() == 6);
+
+
+// The same stages joined the usual way: each behind a virtual interface, holding a
+// pointer to the next.
+struct VirtualStage {
+    virtual ~VirtualStage() = default;
+    virtual void process(FeedEvent& e) = 0;
+    VirtualStage* next = nullptr;
+};
+
+template<typename S>
+struct VirtualAdapter final : VirtualStage {
+    S stage;
+
+    void process(FeedEvent& e) override {
+        auto forward = [this](FeedEvent& x) { if (next) next->process(x); };
+        stage.process(e, forward);
+    }
+};
+
+// And with each stage's successor in a std::function.
+template<typename S>
+std::function<void(FeedEvent&)> bind(S& stage, std::function<void(FeedEvent&)> next) {
+    return [&stage, next = std::move(next)](FeedEvent& e) {
+        auto forward = [&next](FeedEvent& x) { next(x); };
+        stage.process(e, forward);
+    };
+}
+
+// Splits the feed into messages and pushes each through `push`. Stops at a message
+// that runs past the end of bytes, and returns the bytes consumed, which fall short
+// of bytes.size() when the feed was cut off or malformed.
+template<typename Push>
+size_t replay(const std::vector<uint8_t>& bytes, Push&& push) {
+    size_t offset = 0;
+    while (offset + 2 <= bytes.size()) {
+        const size_t length = itch::load_be<uint16_t>(bytes.data() + offset);
+        if (UNLIKELY(offset + 2 + length > bytes.size())) break;
+        FeedEvent e;
+        e.message = bytes.data() + offset + 2;
+        e.length = length;
+        push(e);
+        offset += 2 + length;
+    }
+    return offset;
+}
+
+}
+
+
+// The five-stage feed handler (decode, subscribe, normalize, book update, signal) over
+// 1M ITCH messages on 4 instruments, two of them subscribed: composed at compile time,
+// as a chain of virtual calls, and as a chain of std::functions. BM_Pipeline_Audited
+// adds a sixth stage that the others compile out. items_per_second counts messages.
+class PipelineBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        if (bytes.empty()) bytes = itch::generate_feed(n_messages, 4);
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    static const size_t n_messages = 1000000;
+    static inline std::vector<uint8_t> bytes;
+};
+
+
+template<bool Audited>
+static void run_compile_time_pipeline(const std::vector<uint8_t>& bytes, benchmark::State& state) {
+    auto handler = std::make_unique<feed::Handler<Audited>>();
+    auto& books = handler->template stage<Audited ? 4 : 3>();
+    auto& signal = handler->template stage<Audited ? 5 : 4>();
+    size_t consumed = 0;
+    for (auto _ : alloc_counter::counted(state)) {
+        state.PauseTiming();
+        books.clear();
+        state.ResumeTiming();
+        consumed = feed::replay(bytes, [&](feed::FeedEvent& e) { handler->push(e); });
+        benchmark::DoNotOptimize(signal.imbalance);
+    }
+    if (consumed != bytes.size()) state.SkipWithError("the feed ends in a cut-off message");
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(PipelineBenchmark::n_messages));
+    state.counters["signals"] = static_cast<double>(signal.updates) / static_cast<double>(state.iterations());
+}
+
+BENCHMARK_F(PipelineBenchmark, BM_Pipeline)(benchmark::State& state) {
+    run_compile_time_pipeline<false>(bytes, state);
+}
+
+BENCHMARK_F(PipelineBenchmark, BM_Pipeline_Audited)(benchmark::State& state) {
+    run_compile_time_pipeline<true>(bytes, state);
+}
+
+BENCHMARK_F(PipelineBenchmark, BM_Virtual)(benchmark::State& state) {
+    auto decode = std::make_unique<feed::VirtualAdapter<feed::Decode>>();
+    auto subscribe = std::make_unique<feed::VirtualAdapter<feed::Subscribe>>();
+    auto normalize = std::make_unique<feed::VirtualAdapter<feed::Normalize>>();
+    auto books = std::make_unique<feed::VirtualAdapter<feed::BookUpdate>>();
+    auto signal = std::make_unique<feed::VirtualAdapter<feed::Signal>>();
+    std::vector<feed::VirtualStage*> chain{decode.get(), subscribe.get(), normalize.get(), books.get(), signal.get()};
+    for (size_t k = 0; k + 1 < chain.size(); ++k) chain[k]->next = chain[k + 1];
+    feed::VirtualStage* head = chain.front();
+
+    size_t consumed = 0;
+    for (auto _ : alloc_counter::counted(state)) {
+        state.PauseTiming();
+        books->stage.clear();
+        state.ResumeTiming();
+        consumed = feed::replay(bytes, [&](feed::FeedEvent& e) { head->process(e); });
+        benchmark::DoNotOptimize(signal->stage.imbalance);
+    }
+    if (consumed != bytes.size()) state.SkipWithError("the feed ends in a cut-off message");
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_messages));
+    state.counters["signals"] = static_cast<double>(signal->stage.updates) / static_cast<double>(state.iterations());
+}
+
+BENCHMARK_F(PipelineBenchmark, BM_StdFunction)(benchmark::State& state) {
+    feed::Decode decode;
+    feed::Subscribe subscribe;
+    feed::Normalize normalize;
+    auto books = std::make_unique<feed::BookUpdate>();
+    feed::Signal signal;
+    std::function<void(feed::FeedEvent&)> head =
+        feed::bind(decode, feed::bind(subscribe, feed::bind(normalize, feed::bind(*books, feed::bind(signal,
+            [](feed::FeedEvent&) {})))));
+
+    size_t consumed = 0;
+    for (auto _ : alloc_counter::counted(state)) {
+        state.PauseTiming();
+        books->clear();
+        state.ResumeTiming();
+        consumed = feed::replay(bytes, [&](feed::FeedEvent& e) { head(e); });
+        benchmark::DoNotOptimize(signal.imbalance);
+    }
+    if (consumed != bytes.size()) state.SkipWithError("the feed ends in a cut-off message");
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_messages));
+    state.counters["signals"] = static_cast<double>(signal.updates) / static_cast<double>(state.iterations());
+}
@@ -1,16 +1,37 @@
 #pragma once
 #include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "allocator_stats.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 template <typename T>
 class PoolAllocator {
+    struct FreeNode {
+        FreeNode* next;
+    };
 public:
+    // Each slot must also be able to hold a free list link.
+    static constexpr size_t slot_alignment = alignof(T) > alignof(FreeNode) ? alignof(T) : alignof(FreeNode);
+    static constexpr size_t slot_size =
+        ((sizeof(T) > sizeof(FreeNode) ? sizeof(T) : sizeof(FreeNode)) + slot_alignment - 1) & ~(slot_alignment - 1);
+
     explicit PoolAllocator(size_t capacity)
         : capacity_(capacity)
-        , pool_(static_cast<char*>(::operator new(capacity * sizeof(T))))
+        , pool_(static_cast<char*>(::operator new(capacity * slot_size)))
         , free_list_(nullptr)
+        , stats_(capacity * slot_size)
     {
         for (size_t i=0; i<capacity_; ++i) {
-            void* ptr = pool_ + i * sizeof(T);
+            void* ptr = pool_ + i * slot_size;
             FreeNode* node = static_cast<FreeNode*>(ptr);
             node->next = free_list_;
             free_list_ = node;
@@ -23,10 +44,12 @@ public:
 
     T* allocate() {
         if (!free_list_) {
+            stats_.on_failed_allocation();
             throw std::bad_alloc();
         }
         FreeNode* node = free_list_;
         free_list_ = node->next;
+        stats_.on_allocate(sizeof(T), slot_size - sizeof(T));
         return reinterpret_cast<T*>(node);
     }
 
@@ -34,14 +57,172 @@ public:
         FreeNode* node = reinterpret_cast<FreeNode*>(ptr);
         node->next = free_list_;
         free_list_ = node;
+        stats_.on_deallocate(sizeof(T), slot_size - sizeof(T));
+    }
+
+    AllocatorStatsSnapshot stats() const {
+        return stats_.snapshot();
     }
 private:
-    struct FreeNode {
-        FreeNode* next;
-    };
     size_t capacity_;
     char* pool_;
     FreeNode* free_list_;
+    AllocatorStats stats_;
+};
+
+// 32-bit handle into a SlotMap: the low bits index the slot array, the high bits hold
+// the generation the slot had when the handle was issued. Generation 0 is never
+// issued, so a default constructed handle is always invalid.
+//
+// The generation has 12 bits, and freed slots are reused LIFO, so a hot slot can
+// cycle through all 4095 generations quickly. A stale handle becomes valid again once
+// its slot has been reused 4095 times; handles must not be kept that long after an
+// erase.
+struct SlotHandle {
+    static constexpr uint32_t index_bits = 20;
+    static constexpr uint32_t index_mask = (1u << index_bits) - 1;
+    static constexpr uint32_t generation_mask = (1u << (32 - index_bits)) - 1;
+
+    uint32_t value = 0;
+
+    uint32_t index() const { return value & index_mask; }
+    uint32_t generation() const { return value >> index_bits; }
+
+    static SlotHandle make(uint32_t index, uint32_t generation) {
+        return SlotHandle{(generation << index_bits) | index};
+    }
+
+    bool operator==(const SlotHandle&) const = default;
+};
+
+static_assert(sizeof(SlotHandle) == 4);
+
+
+// Fixed capacity object store that hands out SlotHandles instead of pointers.
+// Like PoolAllocator, all storage is reserved up front and free slots are kept on an
+// intrusive free list; unlike it, live objects are kept densely packed (erase moves the
+// last object into the hole) so iteration is a linear walk. Resolving a handle is one
+// lookup in the slot array followed by the dense access.
+template <typename T>
+class SlotMap {
+public:
+    explicit SlotMap(size_t capacity)
+        : capacity_(static_cast<uint32_t>(capacity))
+        , size_(0)
+        , values_(static_cast<T*>(::operator new(capacity * sizeof(T), std::align_val_t(alignof(T)))))
+        , slots_(capacity)
+        , dense_to_slot_(capacity)
+        , free_head_(0)
+    {
+        if (capacity > SlotHandle::index_mask) {
+            ::operator delete(values_, std::align_val_t(alignof(T)));
+            throw std::length_error("SlotMap capacity exceeds handle index range");
+        }
+        for (uint32_t i = 0; i < capacity_; ++i) {
+            slots_[i].next_free_or_dense = i + 1;
+            slots_[i].generation = 1;
+        }
+    }
+
+    ~SlotMap() {
+        clear();
+        ::operator delete(values_, std::align_val_t(alignof(T)));
+    }
+
+    SlotMap(const SlotMap&) = delete;
+    SlotMap& operator=(const SlotMap&) = delete;
+
+    template <typename... Args>
+    SlotHandle emplace(Args&&... args) {
+        if (free_head_ == capacity_) {
+            throw std::bad_alloc();
+        }
+        const uint32_t slot_index = free_head_;
+        Slot& slot = slots_[slot_index];
+        free_head_ = slot.next_free_or_dense;
+
+        new (values_ + size_) T(std::forward<Args>(args)...);
+        slot.next_free_or_dense = size_;
+        dense_to_slot_[size_] = slot_index;
+        ++size_;
+        return SlotHandle::make(slot_index, slot.generation);
+    }
+
+    SlotHandle insert(const T& value) { return emplace(value); }
+
+    // Returns nullptr if the handle is stale or was never issued.
+    T* get(SlotHandle handle) {
+        const uint32_t index = handle.index();
+        if (index >= capacity_) return nullptr;
+        const Slot& slot = slots_[index];
+        if (slot.generation != handle.generation()) return nullptr;
+        return values_ + slot.next_free_or_dense;
+    }
+
+    const T* get(SlotHandle handle) const {
+        return const_cast<SlotMap*>(this)->get(handle);
+    }
+
+    bool contains(SlotHandle handle) const { return get(handle) != nullptr; }
+
+    bool erase(SlotHandle handle) {
+        const uint32_t slot_index = handle.index();
+        if (slot_index >= capacity_) return false;
+        Slot& slot = slots_[slot_index];
+        if (slot.generation != handle.generation()) return false;
+
+        const uint32_t hole = slot.next_free_or_dense;
+        const uint32_t last = size_ - 1;
+        if (hole != last) {
+            values_[hole] = std::move(values_[last]);
+            const uint32_t moved_slot = dense_to_slot_[last];
+            slots_[moved_slot].next_free_or_dense = hole;
+            dense_to_slot_[hole] = moved_slot;
+        }
+        values_[last].~T();
+        --size_;
+
+        // Bump the generation so outstanding handles go stale, skipping 0 on wrap.
+        slot.generation = (slot.generation + 1) & SlotHandle::generation_mask;
+        if (slot.generation == 0) slot.generation = 1;
+        slot.next_free_or_dense = free_head_;
+        free_head_ = slot_index;
+        return true;
+    }
+
+    void clear() {
+        while (size_ != 0) {
+            erase(SlotHandle::make(dense_to_slot_[size_ - 1], slots_[dense_to_slot_[size_ - 1]].generation));
+        }
+    }
+
+    // Handle of the object at a dense position, for use while iterating.
+    SlotHandle handle_at(size_t dense_index) const {
+        const uint32_t slot_index = dense_to_slot_[dense_index];
+        return SlotHandle::make(slot_index, slots_[slot_index].generation);
+    }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    T* begin() { return values_; }
+    T* end() { return values_ + size_; }
+    const T* begin() const { return values_; }
+    const T* end() const { return values_ + size_; }
+
+private:
+    struct Slot {
+        uint32_t next_free_or_dense;  // dense index while live, next free slot otherwise
+        uint32_t generation;
+    };
+
+    uint32_t capacity_;
+    uint32_t size_;
+    T* values_;
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> dense_to_slot_;
+    uint32_t free_head_;
 };
 
 
@@ -50,7 +231,7 @@ struct MyPoolObject {
 };
 
 
-class PoolBenchmark : public benchmark::Fixture {
+class PoolBenchmark : public AllocCountingFixture {
 public:
     static constexpr size_t object_count = 10000;
     void SetUp(const benchmark::State& state) override {
@@ -66,7 +247,7 @@ public:
 
 
 BENCHMARK_F(PoolBenchmark, NormalAllocation)(benchmark::State& state) {
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         std::vector<MyPoolObject*> objects;
         objects.reserve(object_count);
         for (int i = 0; i < object_count; ++i) {
@@ -80,9 +261,10 @@ BENCHMARK_F(PoolBenchmark, NormalAllocation)(benchmark::State& state) {
 }
 
 BENCHMARK_F(PoolBenchmark, PoolAllocation)(benchmark::State& state) {
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         std::vector<MyPoolObject*> objects;
         objects.reserve(object_count);
+        alloc_counter::NoAllocScope no_alloc;
         for (size_t i = 0; i < object_count; ++i) {
             objects.push_back(new (pool->allocate()) MyPoolObject{1, 2, 3, 4});
         }
@@ -94,4 +276,134 @@ BENCHMARK_F(PoolBenchmark, PoolAllocation)(benchmark::State& state) {
             pool->deallocate(ptr);
         }
     }
-}
\ No newline at end of file
+    report_allocator_stats(state, pool->stats());
+}
+
+
+// Sibling links as 4-byte handles keep this at 32 bytes; with 8-byte pointers it is 48.
+struct SlotMapOrder {
+    uint64_t id;
+    int64_t price;
+    int32_t quantity;
+    SlotHandle prev;
+    SlotHandle next;
+    uint32_t flags;
+};
+
+static_assert(sizeof(SlotMapOrder) == 32);
+
+
+class SlotMapBenchmark : public AllocCountingFixture {
+public:
+    static constexpr size_t order_count = 100000;
+
+    void SetUp(const benchmark::State& state) override {
+        slot_map = std::make_unique<SlotMap<SlotMapOrder>>(order_count);
+        order_pool = std::make_unique<PoolAllocator<SlotMapOrder>>(order_count);
+        order_map.reserve(order_count);
+        handles.clear();
+        ids.clear();
+
+        for (uint64_t id = 0; id < order_count; ++id) {
+            SlotMapOrder order{id, static_cast<int64_t>(1000 + id % 100), static_cast<int32_t>(id % 7 + 1), {}, {}, 0};
+            handles.push_back(slot_map->insert(order));
+            order_map.emplace(id, new (order_pool->allocate()) SlotMapOrder(order));
+            ids.push_back(id);
+        }
+
+        // Look orders up in a random order, as a feed handler would.
+        std::mt19937 rng(42);
+        std::vector<size_t> permutation(order_count);
+        std::iota(permutation.begin(), permutation.end(), size_t{0});
+        std::shuffle(permutation.begin(), permutation.end(), rng);
+        for (size_t i = 0; i < order_count; ++i) {
+            std::swap(handles[i], handles[permutation[i]]);
+            std::swap(ids[i], ids[permutation[i]]);
+        }
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        slot_map.reset();
+        order_map.clear();
+        order_pool.reset();
+    }
+
+    std::unique_ptr<SlotMap<SlotMapOrder>> slot_map;
+    std::unique_ptr<PoolAllocator<SlotMapOrder>> order_pool;
+    std::unordered_map<uint64_t, SlotMapOrder*> order_map;
+    std::vector<SlotHandle> handles;
+    std::vector<uint64_t> ids;
+};
+
+
+BENCHMARK_F(SlotMapBenchmark, SlotMapLookup)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        int64_t total = 0;
+        for (SlotHandle handle : handles) {
+            total += slot_map->get(handle)->quantity;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * order_count);
+}
+
+BENCHMARK_F(SlotMapBenchmark, UnorderedMapLookup)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        int64_t total = 0;
+        for (uint64_t id : ids) {
+            total += order_map.find(id)->second->quantity;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * order_count);
+}
+
+BENCHMARK_F(SlotMapBenchmark, SlotMapIteration)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        int64_t total = 0;
+        for (const SlotMapOrder& order : *slot_map) {
+            total += order.quantity;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * order_count);
+}
+
+BENCHMARK_F(SlotMapBenchmark, UnorderedMapIteration)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        int64_t total = 0;
+        for (const auto& entry : order_map) {
+            total += entry.second->quantity;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * order_count);
+}
+
+BENCHMARK_F(SlotMapBenchmark, SlotMapChurn)(benchmark::State& state) {
+    uint64_t next_id = order_count;
+    size_t cursor = 0;
+    for (auto _ : alloc_counter::counted(state)) {
+        alloc_counter::NoAllocScope no_alloc;
+        SlotHandle& handle = handles[cursor];
+        slot_map->erase(handle);
+        handle = slot_map->insert(SlotMapOrder{next_id++, 1000, 1, {}, {}, 0});
+        cursor = (cursor + 1) % order_count;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_F(SlotMapBenchmark, UnorderedMapChurn)(benchmark::State& state) {
+    uint64_t next_id = order_count;
+    size_t cursor = 0;
+    for (auto _ : alloc_counter::counted(state)) {
+        uint64_t& id = ids[cursor];
+        auto it = order_map.find(id);
+        order_pool->deallocate(it->second);
+        order_map.erase(it);
+        id = next_id++;
+        order_map.emplace(id, new (order_pool->allocate()) SlotMapOrder{id, 1000, 1, {}, {}, 0});
+        cursor = (cursor + 1) % order_count;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "simd_dispatch.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+
+// The reduction library (KernelTable::reduce_*) against the obvious std:: calls, for
+// every element type. Each run streams 8MB, so bytes_per_second is a memory number
+// once the kernel keeps up.
+namespace reduction {
+
+enum class Type : int { I32, I64, F32, F64, Count };
+enum class Op : int { Sum, SumSquares, Min, Max, ArgMin, ArgMax, Count };
+
+inline const char* type_name(Type type) {
+    switch (type) {
+    case Type::I32: return "i32";
+    case Type::I64: return "i64";
+    case Type::F32: return "f32";
+    case Type::F64: return "f64";
+    case Type::Count: break;
+    }
+    return "?";
+}
+
+inline const char* op_name(Op op) {
+    switch (op) {
+    case Op::Sum: return "sum";
+    case Op::SumSquares: return "sum_squares";
+    case Op::Min: return "min";
+    case Op::Max: return "max";
+    case Op::ArgMin: return "argmin";
+    case Op::ArgMax: return "argmax";
+    case Op::Count: break;
+    }
+    return "?";
+}
+
+template <typename T, typename Acc>
+double run(const simd_kernels::ReductionKernels<T, Acc>& kernels, Op op, const std::vector<T>& data) {
+    switch (op) {
+    case Op::Sum: return static_cast<double>(kernels.sum(data.data(), data.size()));
+    case Op::SumSquares: return static_cast<double>(kernels.sum_squares(data.data(), data.size()));
+    case Op::Min: return static_cast<double>(kernels.min(data.data(), data.size()));
+    case Op::Max: return static_cast<double>(kernels.max(data.data(), data.size()));
+    case Op::ArgMin: return static_cast<double>(kernels.argmin(data.data(), data.size()));
+    case Op::ArgMax: return static_cast<double>(kernels.argmax(data.data(), data.size()));
+    case Op::Count: break;
+    }
+    return 0.0;
+}
+
+template <typename T, typename Acc>
+double run_std(Op op, const std::vector<T>& data) {
+    switch (op) {
+    case Op::Sum: return static_cast<double>(std::accumulate(data.begin(), data.end(), Acc{}));
+    case Op::SumSquares:
+        return static_cast<double>(std::accumulate(data.begin(), data.end(), Acc{},
+                                                   [](Acc r, T x) { return r + static_cast<Acc>(x) * static_cast<Acc>(x); }));
+    case Op::Min: return static_cast<double>(*std::min_element(data.begin(), data.end()));
+    case Op::Max: return static_cast<double>(*std::max_element(data.begin(), data.end()));
+    case Op::ArgMin: return static_cast<double>(std::min_element(data.begin(), data.end()) - data.begin());
+    case Op::ArgMax: return static_cast<double>(std::max_element(data.begin(), data.end()) - data.begin());
+    case Op::Count: break;
+    }
+    return 0.0;
+}
+
+// (type, op, isa) for the library, or (type, op) for the std:: baseline.
+inline void type_op_isa_args(benchmark::internal::Benchmark* b) {
+    using simd_kernels::Isa;
+    b->ArgNames({"type", "op", "isa"});
+    for (int type = 0; type < static_cast<int>(Type::Count); ++type) {
+        for (int op = 0; op < static_cast<int>(Op::Count); ++op) {
+            for (Isa isa : {Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+                if (simd_kernels::supported(isa)) {
+                    b->Args({type, op, static_cast<int>(isa)});
+                }
+            }
+        }
+    }
+}
+
+inline void type_op_args(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"type", "op"});
+    for (int type = 0; type < static_cast<int>(Type::Count); ++type) {
+        for (int op = 0; op < static_cast<int>(Op::Count); ++op) {
+            b->Args({type, op});
+        }
+    }
+}
+
+}
+
+
+class ReductionBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int32_t> value(-1000000, 1000000);
+        i32.resize(bytes / sizeof(int32_t));
+        i64.resize(bytes / sizeof(int64_t));
+        f32.resize(bytes / sizeof(float));
+        f64.resize(bytes / sizeof(double));
+        for (auto& x : i32) x = value(rng);
+        for (auto& x : i64) x = static_cast<int64_t>(value(rng)) << 20;
+        for (auto& x : f32) x = static_cast<float>(value(rng)) * 1e-3f;
+        for (auto& x : f64) x = static_cast<double>(value(rng)) * 1e-3;
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    static constexpr size_t bytes = 8 << 20;
+    std::vector<int32_t> i32;
+    std::vector<int64_t> i64;
+    std::vector<float> f32;
+    std::vector<double> f64;
+};
+
+
+BENCHMARK_DEFINE_F(ReductionBenchmark, BM_Reduce)(benchmark::State& state) {
+    using reduction::Type;
+    const auto type = static_cast<Type>(state.range(0));
+    const auto op = static_cast<reduction::Op>(state.range(1));
+    const simd_kernels::KernelTable& kernels = simd_kernels::table(static_cast<simd_kernels::Isa>(state.range(2)));
+
+    for (auto _ : alloc_counter::counted(state)) {
+        double result = 0.0;
+        switch (type) {
+        case Type::I32: result = reduction::run(kernels.reduce_i32, op, i32); break;
+        case Type::I64: result = reduction::run(kernels.reduce_i64, op, i64); break;
+        case Type::F32: result = reduction::run(kernels.reduce_f32, op, f32); break;
+        case Type::F64: result = reduction::run(kernels.reduce_f64, op, f64); break;
+        case Type::Count: break;
+        }
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+    state.SetLabel(std::string(reduction::type_name(type)) + "/" + reduction::op_name(op) + "/" + kernels.name);
+}
+BENCHMARK_REGISTER_F(ReductionBenchmark, BM_Reduce)->Apply(reduction::type_op_isa_args);
+
+BENCHMARK_DEFINE_F(ReductionBenchmark, BM_ReduceStd)(benchmark::State& state) {
+    using reduction::Type;
+    const auto type = static_cast<Type>(state.range(0));
+    const auto op = static_cast<reduction::Op>(state.range(1));
+
+    for (auto _ : alloc_counter::counted(state)) {
+        double result = 0.0;
+        switch (type) {
+        case Type::I32: result = reduction::run_std<int32_t, int64_t>(op, i32); break;
+        case Type::I64: result = reduction::run_std<int64_t, int64_t>(op, i64); break;
+        case Type::F32: result = reduction::run_std<float, float>(op, f32); break;
+        case Type::F64: result = reduction::run_std<double, double>(op, f64); break;
+        case Type::Count: break;
+        }
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+    state.SetLabel(std::string(reduction::type_name(type)) + "/" + reduction::op_name(op) + "/std");
+}
+BENCHMARK_REGISTER_F(ReductionBenchmark, BM_ReduceStd)->Apply(reduction::type_op_args);
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "alloc_counter.hpp"
+#include "branch_reduction.hpp"
+#include "simd_dispatch.hpp"
+
+
+// Pre-trade risk checks on outgoing orders: quantity, price band, notional, position
+// and message rate limits. branchreduction::doFn shows the idea on three hardcoded
+// checks; here every limit is evaluated into a RiskErrorFlags byte per order, with no
+// branch on the result, and KernelTable::risk_check does it for a whole vector of
+// orders at a time. The sender then takes one LIKELY branch per batch when nothing
+// failed. checkBatchIfChain is the usual code, returning at the first failed check.
+namespace risk {
+
+using simd_kernels::RiskErrorFlags;
+using simd_kernels::RiskLimits;
+using simd_kernels::RiskState;
+
+// price * size > max_notional, without the product: for positive integers it is the
+// same as size > max_notional / price.
+inline bool aboveNotional(int64_t price, int64_t size, const RiskLimits& limits) {
+    return price > 0 && size > limits.max_notional / price;
+}
+
+// The flags of one order, branch-free. new_position is the position if the order is
+// accepted, and order_number counts it (1-based within the window).
+inline uint8_t checkOrder(int64_t price, int64_t quantity, int64_t new_position, int64_t order_number,
+                          const RiskLimits& limits) {
+    const int64_t size = quantity < 0 ? -quantity : quantity;
+    const int64_t offset = price - limits.reference_price;
+    const int64_t position = new_position < 0 ? -new_position : new_position;
+    const unsigned flags =
+        ((size == 0) | (size > limits.max_quantity)) * simd_kernels::QuantityError
+      | ((offset < 0 ? -offset : offset) > limits.price_band) * simd_kernels::PriceBandError
+      | aboveNotional(price, size, limits) * simd_kernels::NotionalError
+      | (position > limits.max_position) * simd_kernels::PositionError
+      | (order_number > limits.max_orders) * simd_kernels::RateError;
+    return static_cast<uint8_t>(flags & limits.enabled);
+}
+
+// Scalar KernelTable::risk_check, with the same contract and results.
+inline uint8_t checkBatch(const int64_t* prices, const int64_t* quantities, size_t n,
+                          const RiskLimits& limits, RiskState& state, uint8_t* errors) {
+    int64_t position = state.position;
+    uint8_t seen = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const int64_t new_position = position + quantities[i];
+        errors[i] = checkOrder(prices[i], quantities[i], new_position, state.orders_sent + static_cast<int64_t>(i) + 1, limits);
+        position = errors[i] == 0 ? new_position : position;
+        seen |= errors[i];
+    }
+    state.position = position;
+    state.orders_sent += static_cast<int64_t>(n);
+    return seen;
+}
+
+// The if-chain: checks in order, stopping at the first one that fails, so errors[i]
+// holds a single flag. Orders pass or fail exactly as in checkBatch.
+inline uint8_t checkBatchIfChain(const int64_t* prices, const int64_t* quantities, size_t n,
+                                 const RiskLimits& limits, RiskState& state, uint8_t* errors) {
+    uint8_t seen = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const int64_t price = prices[i];
+        const int64_t quantity = quantities[i];
+        const int64_t size = quantity < 0 ? -quantity : quantity;
+        const int64_t new_position = state.position + quantity;
+        uint8_t error = simd_kernels::NoRiskError;
+        if ((limits.enabled & simd_kernels::QuantityError) && (size == 0 || size > limits.max_quantity)) {
+            error = simd_kernels::QuantityError;
+        }
+        else if ((limits.enabled & simd_kernels::PriceBandError) &&
+                 (price > limits.reference_price + limits.price_band || price < limits.reference_price - limits.price_band)) {
+            error = simd_kernels::PriceBandError;
+        }
+        else if ((limits.enabled & simd_kernels::NotionalError) && aboveNotional(price, size, limits)) {
+            error = simd_kernels::NotionalError;
+        }
+        else if ((limits.enabled & simd_kernels::PositionError) && (new_position > limits.max_position || new_position < -limits.max_position)) {
+            error = simd_kernels::PositionError;
+        }
+        else if ((limits.enabled & simd_kernels::RateError) && state.orders_sent + static_cast<int64_t>(i) + 1 > limits.max_orders) {
+            error = simd_kernels::RateError;
+        }
+        else {
+            state.position = new_position;
+        }
+        errors[i] = error;
+        seen |= error;
+    }
+    state.orders_sent += static_cast<int64_t>(n);
+    return seen;
+}
+
+
+// Holds the limits and the running state for one account, and checks batches with
+// the widest kernel the host supports unless given another check with the same
+// contract, such as checkBatch.
+class RiskEngine {
+public:
+    using Check = uint8_t (*)(const int64_t* prices, const int64_t* quantities, size_t n,
+                              const RiskLimits& limits, RiskState& state, uint8_t* errors);
+
+    explicit RiskEngine(const RiskLimits& limits, Check check = simd_kernels::active().risk_check)
+        : limits_(limits), check_(check) {}
+
+    // See KernelTable::risk_check. Returns the OR of the flags of all n orders.
+    uint8_t check(const int64_t* prices, const int64_t* quantities, size_t n, uint8_t* errors) {
+        return check_(prices, quantities, n, limits_, state_, errors);
+    }
+
+    void startWindow() { state_.orders_sent = 0; }
+    void reset(int64_t position = 0) { state_ = {position, 0}; }
+
+    const RiskState& state() const { return state_; }
+    const RiskLimits& limits() const { return limits_; }
+    void setLimits(const RiskLimits& limits) { limits_ = limits; }
+
+private:
+    RiskLimits limits_;
+    RiskState state_{};
+    Check check_;
+};
+
+
+// Orders around a reference of 1,000,000 ticks, 1-500 lots each side, inside every
+// limit of benchmarkLimits() except for errors_per_mille / 1000 of them, which break
+// the quantity, price band or notional limit.
+struct Orders {
+    std::vector<int64_t> prices;
+    std::vector<int64_t> quantities;
+};
+
+inline RiskLimits benchmarkLimits(size_t orders) {
+    return {1000, 1000000, 5000, 600000000, 1000000, static_cast<int64_t>(orders), simd_kernels::AllRiskErrors};
+}
+
+inline Orders generateOrders(size_t n, int errors_per_mille, uint32_t seed = 17) {
+    const RiskLimits limits = benchmarkLimits(n);
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int64_t> offset(-limits.price_band, limits.price_band);
+    std::uniform_int_distribution<int64_t> size(1, 500);
+    std::uniform_int_distribution<int> coin(0, 1);
+    std::uniform_int_distribution<int> per_mille(0, 999);
+    std::uniform_int_distribution<int> kind(0, 2);
+
+    Orders orders;
+    orders.prices.resize(n);
+    orders.quantities.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        int64_t price = limits.reference_price + offset(rng);
+        int64_t quantity = size(rng);
+        if (per_mille(rng) < errors_per_mille) {
+            switch (kind(rng)) {
+            case 0: quantity = coin(rng) ? 0 : std::uniform_int_distribution<int64_t>(1001, 5000)(rng); break;
+            case 1: price += (coin(rng) ? 1 : -1) * std::uniform_int_distribution<int64_t>(5001, 20000)(rng); break;
+            case 2: quantity = std::uniform_int_distribution<int64_t>(700, 1000)(rng); break;
+            }
+        }
+        orders.prices[i] = price;
+        orders.quantities[i] = coin(rng) ? quantity : -quantity;
+    }
+    return orders;
+}
+
+// Checks orders one at a time and in batches of batch, through checkBatch, the
+// if-chain and every supported kernel, under the benchmark limits and under limits
+// tight enough that the position and rate checks fail too. Every run must reject the
+// orders that checkBatch rejects over the whole array in one call, with the same
+// flags (the if-chain only reports the first), and end in the same state. Returns
+// the first run that does not, or an empty string.
+inline std::string findMismatch(const Orders& orders, size_t batch) {
+    const size_t n = orders.prices.size();
+    RiskLimits tight = benchmarkLimits(n);
+    tight.max_position = 2000;
+    tight.max_orders = static_cast<int64_t>(n - n / 8);
+
+    std::vector<std::pair<std::string, RiskEngine::Check>> checks = {
+        {"checkBatch", checkBatch}, {"checkBatchIfChain", checkBatchIfChain}};
+    for (simd_kernels::Isa isa : {simd_kernels::Isa::SSE2, simd_kernels::Isa::AVX2, simd_kernels::Isa::AVX512}) {
+        if (simd_kernels::supported(isa)) checks.emplace_back(simd_kernels::table(isa).name, simd_kernels::table(isa).risk_check);
+    }
+
+    std::vector<uint8_t> expected(n), errors(n);
+    for (const RiskLimits& limits : {benchmarkLimits(n), tight}) {
+        RiskState reference{};
+        checkBatch(orders.prices.data(), orders.quantities.data(), n, limits, reference, expected.data());
+        for (const auto& [name, check] : checks) {
+            const bool first_only = check == checkBatchIfChain;
+            for (size_t size : {size_t(1), batch}) {
+                RiskEngine engine(limits, check);
+                for (size_t i = 0; i < n; i += size) {
+                    engine.check(orders.prices.data() + i, orders.quantities.data() + i, std::min(size, n - i), errors.data() + i);
+                }
+                bool same = engine.state().position == reference.position && engine.state().orders_sent == reference.orders_sent;
+                for (size_t i = 0; i < n; ++i) {
+                    same &= first_only ? (errors[i] != 0) == (expected[i] != 0) : errors[i] == expected[i];
+                }
+                if (!same) return name + " in batches of " + std::to_string(size) + " disagrees with checkBatch";
+            }
+        }
+    }
+    return {};
+}
+
+// (errors_per_mille) and (errors_per_mille, isa).
+inline void error_rate_args(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"errors_per_mille"});
+    for (int rate : {0, 1, 10, 100}) {
+        b->Args({rate});
+    }
+}
+
+inline void error_rate_isa_args(benchmark::internal::Benchmark* b) {
+    using simd_kernels::Isa;
+    b->ArgNames({"errors_per_mille", "isa"});
+    for (int rate : {0, 1, 10, 100}) {
+        for (Isa isa : {Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+            if (simd_kernels::supported(isa)) {
+                b->Args({rate, static_cast<int>(isa)});
+            }
+        }
+    }
+}
+
+}
+
+
+// Orders are checked in batches of 32, as a strategy would send them on one market
+// data update, through a RiskEngine with each check. An accepted order is "sent" by
+// adding it to a checksum; a rejected one is counted. The whole batch is sent on the
+// LIKELY path and individual flags are only looked at when the batch's OR is non-zero.
+class RiskCheckBenchmark : public AllocCountingFixture {
+public:
+    static constexpr size_t n_orders = 1 << 14;
+    static constexpr size_t batch = 32;
+
+    void SetUp(const ::benchmark::State& state) override {
+        orders = risk::generateOrders(n_orders, static_cast<int>(state.range(0)));
+        errors.assign(n_orders, 0);
+        risk::RiskState reference{};
+        risk::checkBatch(orders.prices.data(), orders.quantities.data(), n_orders,
+                         risk::benchmarkLimits(n_orders), reference, errors.data());
+        expected_rejected = 0;
+        for (uint8_t e : errors) expected_rejected += e != 0;
+        mismatch = risk::findMismatch(orders, batch);
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    void run(benchmark::State& state, risk::RiskEngine::Check check) {
+        if (!mismatch.empty()) {
+            state.SkipWithError(mismatch.c_str());
+            return;
+        }
+        risk::RiskEngine engine(risk::benchmarkLimits(n_orders), check);
+        size_t rejected = 0;
+        for (auto _ : alloc_counter::counted(state)) {
+            engine.reset();
+            int64_t sent = 0;
+            rejected = 0;
+            for (size_t i = 0; i < n_orders; i += batch) {
+                const int64_t* prices = orders.prices.data() + i;
+                const int64_t* quantities = orders.quantities.data() + i;
+                uint8_t* flags = errors.data() + i;
+                if (LIKELY(engine.check(prices, quantities, batch, flags) == simd_kernels::NoRiskError)) {
+                    for (size_t j = 0; j < batch; ++j) sent += prices[j] ^ quantities[j];
+                }
+                else {
+                    for (size_t j = 0; j < batch; ++j) {
+                        if (flags[j] == simd_kernels::NoRiskError) sent += prices[j] ^ quantities[j];
+                        else ++rejected;
+                    }
+                }
+            }
+            benchmark::DoNotOptimize(sent);
+        }
+        if (rejected != expected_rejected) state.SkipWithError("rejected a different set of orders");
+
+        state.counters["rejected"] = static_cast<double>(rejected);
+        state.counters["time_per_order"] = benchmark::Counter(
+            static_cast<double>(n_orders), benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    }
+
+    risk::Orders orders;
+    std::vector<uint8_t> errors;
+    size_t expected_rejected = 0;
+    std::string mismatch;
+};
+
+
+BENCHMARK_DEFINE_F(RiskCheckBenchmark, BM_IfChain)(benchmark::State& state) {
+    run(state, risk::checkBatchIfChain);
+}
+BENCHMARK_REGISTER_F(RiskCheckBenchmark, BM_IfChain)->Apply(risk::error_rate_args);
+
+BENCHMARK_DEFINE_F(RiskCheckBenchmark, BM_Branchless)(benchmark::State& state) {
+    run(state, risk::checkBatch);
+}
+BENCHMARK_REGISTER_F(RiskCheckBenchmark, BM_Branchless)->Apply(risk::error_rate_args);
+
+BENCHMARK_DEFINE_F(RiskCheckBenchmark, BM_SIMD)(benchmark::State& state) {
+    const simd_kernels::KernelTable& kernels = simd_kernels::table(static_cast<simd_kernels::Isa>(state.range(1)));
+    run(state, kernels.risk_check);
+    state.SetLabel(kernels.name);
+}
+BENCHMARK_REGISTER_F(RiskCheckBenchmark, BM_SIMD)->Apply(risk::error_rate_isa_args);
@@ -26,12 +26,19 @@
 # include <pmmintrin.h>
 #endif
 
+#ifdef __SSSE3__
+# include <tmmintrin.h>
+#endif
+
 #ifdef __SSE4_1__
 # include <smmintrin.h>
 #endif
 
+// The wrappers are always inlined: this header is included from translation units
+// built with different -m flags (see simd_kernels_*.cpp), and an out-of-line copy
+// compiled for AVX-512 must never be picked by the linker for the SSE2 build.
 #if (__GNUC__ >= 4)
-# define AL_DLL_HIDDEN  __attribute__ ((visibility ("hidden")))
+# define AL_DLL_HIDDEN  __attribute__ ((visibility ("hidden"), always_inline))
 #else
 # define AL_DLL_HIDDEN
 #endif
@@ -44,6 +51,19 @@
 # define ENABLE_SOME_AVX_ROUTINES 1
 #endif
 
+#if defined(_MSC_VER)
+# include <intrin.h>
+AL_DLL_HIDDEN inline int popcount32(const uint32_t x) { return static_cast<int>(__popcnt(x)); }
+/// \brief  index of the lowest set bit; x must not be zero.
+AL_DLL_HIDDEN inline int ctz32(const uint32_t x) { unsigned long index; _BitScanForward(&index, x); return static_cast<int>(index); }
+AL_DLL_HIDDEN inline int ctz64(const uint64_t x) { unsigned long index; _BitScanForward64(&index, x); return static_cast<int>(index); }
+#else
+AL_DLL_HIDDEN inline int popcount32(const uint32_t x) { return __builtin_popcount(x); }
+/// \brief  index of the lowest set bit; x must not be zero.
+AL_DLL_HIDDEN inline int ctz32(const uint32_t x) { return __builtin_ctz(x); }
+AL_DLL_HIDDEN inline int ctz64(const uint64_t x) { return __builtin_ctzll(x); }
+#endif
+
 
 #if defined(__SSE__)
 typedef __m128 f128;
@@ -81,6 +101,20 @@ AL_DLL_HIDDEN inline i128 cmpeq4i(const i128 a, const i128 b) { return _mm_cmpeq
 AL_DLL_HIDDEN inline i128 cmpeq16i8(const i128 a, const i128 b) { return _mm_cmpeq_epi8(a, b); }
 AL_DLL_HIDDEN inline i128 cmplt16i8(const i128 a, const i128 b) { return _mm_cmplt_epi8(a, b); }
 AL_DLL_HIDDEN inline i128 cmpgt16i8(const i128 a, const i128 b) { return _mm_cmpgt_epi8(a, b); }
+AL_DLL_HIDDEN inline i128 splat16i8(const int8_t x) { return _mm_set1_epi8(x); }
+AL_DLL_HIDDEN inline i128 add16i8(const i128 a, const i128 b) { return _mm_add_epi8(a, b); }
+AL_DLL_HIDDEN inline i128 sub16i8(const i128 a, const i128 b) { return _mm_sub_epi8(a, b); }
+AL_DLL_HIDDEN inline i128 min16u8(const i128 a, const i128 b) { return _mm_min_epu8(a, b); }
+AL_DLL_HIDDEN inline i128 unpacklo16i8(const i128 a, const i128 b) { return _mm_unpacklo_epi8(a, b); }
+AL_DLL_HIDDEN inline i128 unpackhi16i8(const i128 a, const i128 b) { return _mm_unpackhi_epi8(a, b); }
+/// \brief  multiplies int16 lanes and adds adjacent pairs of the products into int32 lanes.
+AL_DLL_HIDDEN inline i128 madd8i16(const i128 a, const i128 b) { return _mm_madd_epi16(a, b); }
+/// \brief  narrows the int32 lanes of a then b to int16, saturating.
+AL_DLL_HIDDEN inline i128 packs4i(const i128 a, const i128 b) { return _mm_packs_epi32(a, b); }
+# if defined(__SSSE3__)
+/// \brief  byte i of the result is a[indices[i] & 15], or zero where indices[i] is negative.
+AL_DLL_HIDDEN inline i128 shuffle16i8(const i128 a, const i128 indices) { return _mm_shuffle_epi8(a, indices); }
+# endif
 
 AL_DLL_HIDDEN inline f128 cmpgt4f(const f128 a, const f128 b) { return _mm_cmpgt_ps(a, b); }
 AL_DLL_HIDDEN inline d128 cmpgt2d(const d128 a, const d128 b) { return _mm_cmpgt_pd(a, b); }
@@ -145,6 +179,70 @@ AL_DLL_HIDDEN inline i128 sub4i(const i128 a, const i128 b) { return _mm_sub_epi
 AL_DLL_HIDDEN inline d128 sub2d(const d128 a, const d128 b) { return _mm_sub_pd(a, b); }
 AL_DLL_HIDDEN inline i128 sub2i64(const i128 a, const i128 b) { return _mm_sub_epi64(a, b); }
 
+AL_DLL_HIDDEN inline f128 div4f(const f128 a, const f128 b) { return _mm_div_ps(a, b); }
+AL_DLL_HIDDEN inline d128 div2d(const d128 a, const d128 b) { return _mm_div_pd(a, b); }
+
+AL_DLL_HIDDEN inline f128 sqrt4f(const f128 a) { return _mm_sqrt_ps(a); }
+AL_DLL_HIDDEN inline d128 sqrt2d(const d128 a) { return _mm_sqrt_pd(a); }
+
+# if defined(__FMA__)
+AL_DLL_HIDDEN inline f128 fmadd4f(const f128 a, const f128 b, const f128 c) { return _mm_fmadd_ps(a, b, c); }
+AL_DLL_HIDDEN inline f128 fmsub4f(const f128 a, const f128 b, const f128 c) { return _mm_fmsub_ps(a, b, c); }
+AL_DLL_HIDDEN inline f128 fnmadd4f(const f128 a, const f128 b, const f128 c) { return _mm_fnmadd_ps(a, b, c); }
+AL_DLL_HIDDEN inline d128 fmadd2d(const d128 a, const d128 b, const d128 c) { return _mm_fmadd_pd(a, b, c); }
+AL_DLL_HIDDEN inline d128 fmsub2d(const d128 a, const d128 b, const d128 c) { return _mm_fmsub_pd(a, b, c); }
+AL_DLL_HIDDEN inline d128 fnmadd2d(const d128 a, const d128 b, const d128 c) { return _mm_fnmadd_pd(a, b, c); }
+# else
+/// \brief  a * b + c, a * b - c and c - a * b. Without FMA these round twice, so the
+///         result can differ from the fused version in the last bit.
+AL_DLL_HIDDEN inline f128 fmadd4f(const f128 a, const f128 b, const f128 c) { return add4f(mul4f(a, b), c); }
+AL_DLL_HIDDEN inline f128 fmsub4f(const f128 a, const f128 b, const f128 c) { return sub4f(mul4f(a, b), c); }
+AL_DLL_HIDDEN inline f128 fnmadd4f(const f128 a, const f128 b, const f128 c) { return sub4f(c, mul4f(a, b)); }
+AL_DLL_HIDDEN inline d128 fmadd2d(const d128 a, const d128 b, const d128 c) { return add2d(mul2d(a, b), c); }
+AL_DLL_HIDDEN inline d128 fmsub2d(const d128 a, const d128 b, const d128 c) { return sub2d(mul2d(a, b), c); }
+AL_DLL_HIDDEN inline d128 fnmadd2d(const d128 a, const d128 b, const d128 c) { return sub2d(c, mul2d(a, b)); }
+# endif
+
+AL_DLL_HIDDEN inline f128 min4f(const f128 a, const f128 b) { return _mm_min_ps(a, b); }
+AL_DLL_HIDDEN inline f128 max4f(const f128 a, const f128 b) { return _mm_max_ps(a, b); }
+AL_DLL_HIDDEN inline d128 min2d(const d128 a, const d128 b) { return _mm_min_pd(a, b); }
+AL_DLL_HIDDEN inline d128 max2d(const d128 a, const d128 b) { return _mm_max_pd(a, b); }
+
+AL_DLL_HIDDEN inline f128 cmpeq4f(const f128 a, const f128 b) { return _mm_cmpeq_ps(a, b); }
+AL_DLL_HIDDEN inline f128 cmpge4f(const f128 a, const f128 b) { return _mm_cmpge_ps(a, b); }
+AL_DLL_HIDDEN inline d128 cmpeq2d(const d128 a, const d128 b) { return _mm_cmpeq_pd(a, b); }
+AL_DLL_HIDDEN inline d128 cmpge2d(const d128 a, const d128 b) { return _mm_cmpge_pd(a, b); }
+AL_DLL_HIDDEN inline i128 cmpgt4i(const i128 a, const i128 b) { return _mm_cmpgt_epi32(a, b); }
+/// \brief  index of the first of the 4 sorted (ascending) lanes of levels that is >= value, or 4
+///         if none is. One compare, a movemask and a tzcnt; the bit above the lanes stops
+///         the count when every lane is below value.
+AL_DLL_HIDDEN inline int lower_bound4i(const i128 levels, const int32_t value) { return ctz32((static_cast<uint32_t>(movemask4i(cmpgt4i(_mm_set1_epi32(value), levels))) ^ 0xfu) | 0x10u); }
+
+AL_DLL_HIDDEN inline d128 and2d(const d128 a, const d128 b) { return _mm_and_pd(a, b); }
+AL_DLL_HIDDEN inline d128 andnot2d(const d128 a, const d128 b) { return _mm_andnot_pd(a, b); }
+AL_DLL_HIDDEN inline i128 xor4i(const i128 a, const i128 b) { return _mm_xor_si128(a, b); }
+
+AL_DLL_HIDDEN inline d128 select2d(const d128 falseResult, const d128 trueResult, const d128 cmp) { return or2d(and2d(cmp, trueResult), andnot2d(cmp, falseResult)); }
+AL_DLL_HIDDEN inline i128 select4i(const i128 falseResult, const i128 trueResult, const i128 cmp) { return or4i(and4i(cmp, trueResult), andnot4i(cmp, falseResult)); }
+
+AL_DLL_HIDDEN inline i128 min4i(const i128 a, const i128 b) { return select4i(a, b, cmpgt4i(a, b)); }
+AL_DLL_HIDDEN inline i128 max4i(const i128 a, const i128 b) { return select4i(b, a, cmpgt4i(a, b)); }
+
+AL_DLL_HIDDEN inline float first4f(const f128 reg) { return _mm_cvtss_f32(reg); }
+AL_DLL_HIDDEN inline double first2d(const d128 reg) { return _mm_cvtsd_f64(reg); }
+AL_DLL_HIDDEN inline int32_t first4i(const i128 reg) { return _mm_cvtsi128_si32(reg); }
+
+/// \brief  horizontal reductions, the result is in lane 0.
+AL_DLL_HIDDEN inline f128 hadd4f(const f128 v) { const f128 t = add4f(v, movehl4f(v, v)); return add4f(t, shuffle4f(t, t, 1, 1, 1, 1)); }
+AL_DLL_HIDDEN inline f128 hmin4f(const f128 v) { const f128 t = min4f(v, movehl4f(v, v)); return min4f(t, shuffle4f(t, t, 1, 1, 1, 1)); }
+AL_DLL_HIDDEN inline f128 hmax4f(const f128 v) { const f128 t = max4f(v, movehl4f(v, v)); return max4f(t, shuffle4f(t, t, 1, 1, 1, 1)); }
+AL_DLL_HIDDEN inline d128 hadd2d(const d128 v) { return add2d(v, _mm_unpackhi_pd(v, v)); }
+AL_DLL_HIDDEN inline d128 hmin2d(const d128 v) { return min2d(v, _mm_unpackhi_pd(v, v)); }
+AL_DLL_HIDDEN inline d128 hmax2d(const d128 v) { return max2d(v, _mm_unpackhi_pd(v, v)); }
+AL_DLL_HIDDEN inline i128 hadd4i(const i128 v) { const i128 t = add4i(v, movehl4i(v, v)); return add4i(t, shiftBytesRight(t, 4)); }
+AL_DLL_HIDDEN inline i128 hmin4i(const i128 v) { const i128 t = min4i(v, movehl4i(v, v)); return min4i(t, shiftBytesRight(t, 4)); }
+AL_DLL_HIDDEN inline i128 hmax4i(const i128 v) { const i128 t = max4i(v, movehl4i(v, v)); return max4i(t, shiftBytesRight(t, 4)); }
+
 AL_DLL_HIDDEN inline f128 splat4f(float f) { return _mm_set1_ps(f); }
 AL_DLL_HIDDEN inline d128 splat2d(double f) { return _mm_set1_pd(f); }
 AL_DLL_HIDDEN inline i128 splat4i(int32_t f) { return _mm_set1_epi32(f); }
@@ -173,12 +271,57 @@ AL_DLL_HIDDEN inline f128 select4f(const f128 falseResult, const f128 trueResult
 
 # if defined(__SSE4_1__)
 AL_DLL_HIDDEN inline i128 cmpeq2i64(const i128 a, const i128 b) { return _mm_cmpeq_epi64(a, b); }
+# else
+AL_DLL_HIDDEN inline i128 cmpeq2i64(const i128 a, const i128 b)
+{
+  const i128 eq = cmpeq4i(a, b);
+  return and4i(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+}
 # endif
 
+# if defined(__SSE4_2__)
+AL_DLL_HIDDEN inline i128 cmpgt2i64(const i128 a, const i128 b) { return _mm_cmpgt_epi64(a, b); }
+# else
+AL_DLL_HIDDEN inline i128 cmpgt2i64(const i128 a, const i128 b)
+{
+  // The high halves decide, unless they are equal; then b - a borrows into the high
+  // half exactly when the low half of a is bigger (unsigned).
+  const i128 r = or4i(and4i(cmpeq4i(a, b), sub2i64(b, a)), cmpgt4i(a, b));
+  return _mm_shuffle_epi32(r, _MM_SHUFFLE(3, 3, 1, 1));
+}
+# endif
+
+AL_DLL_HIDDEN inline i128 min2i64(const i128 a, const i128 b) { return select4i(a, b, cmpgt2i64(a, b)); }
+AL_DLL_HIDDEN inline i128 max2i64(const i128 a, const i128 b) { return select4i(b, a, cmpgt2i64(a, b)); }
+
+/// \brief  unsigned 32 x 32 -> 64 bit products of the even lanes (0 and 2).
+AL_DLL_HIDDEN inline i128 mul_even4u32(const i128 a, const i128 b) { return _mm_mul_epu32(a, b); }
+
+/// \brief  low 64 bits of a * b, from three 32-bit multiplies.
+AL_DLL_HIDDEN inline i128 mullo2i64(const i128 a, const i128 b)
+{
+  const i128 cross = add2i64(mul_even4u32(shiftBitsRight2i64(a, 32), b), mul_even4u32(a, shiftBitsRight2i64(b, 32)));
+  return add2i64(mul_even4u32(a, b), shiftBitsLeft2i64(cross, 32));
+}
+
+/// \brief  sign-extends the low (or high) two int32 lanes to int64.
+AL_DLL_HIDDEN inline i128 widenlo4i32_to_2i64(const i128 reg) { return _mm_unpacklo_epi32(reg, _mm_srai_epi32(reg, 31)); }
+AL_DLL_HIDDEN inline i128 widenhi4i32_to_2i64(const i128 reg) { return _mm_unpackhi_epi32(reg, _mm_srai_epi32(reg, 31)); }
+
+AL_DLL_HIDDEN inline int64_t first2i64(const i128 reg) { return _mm_cvtsi128_si64(reg); }
+AL_DLL_HIDDEN inline i128 hadd2i64(const i128 v) { return add2i64(v, _mm_unpackhi_epi64(v, v)); }
+AL_DLL_HIDDEN inline i128 hmin2i64(const i128 v) { return min2i64(v, _mm_unpackhi_epi64(v, v)); }
+AL_DLL_HIDDEN inline i128 hmax2i64(const i128 v) { return max2i64(v, _mm_unpackhi_epi64(v, v)); }
+
 # define extract128i64(reg, index) _mm_extract_epi64(reg, index)
 
-inline f128 abs4f(const f128 v) { return _mm_andnot_ps(splat4f(-0.0f), v); }
-inline d128 abs2d(const d128 v) { return _mm_andnot_pd(splat2d(-0.0), v); }
+AL_DLL_HIDDEN inline f128 abs4f(const f128 v) { return _mm_andnot_ps(splat4f(-0.0f), v); }
+AL_DLL_HIDDEN inline d128 abs2d(const d128 v) { return _mm_andnot_pd(splat2d(-0.0), v); }
+
+/// \brief  int64 <-> double for lanes in [0, 2^52), by placing the integer in the
+///         mantissa of 2^52. The conversion to int64 rounds to nearest.
+AL_DLL_HIDDEN inline d128 cvtu52_2i64_to_2d(const i128 reg) { return sub2d(cast2d(or4i(reg, splat2i64(0x4330000000000000))), splat2d(0x1p52)); }
+AL_DLL_HIDDEN inline i128 cvt2d_to_u52_2i64(const d128 reg) { return xor4i(cast4i(add2d(reg, splat2d(0x1p52))), splat2i64(0x4330000000000000)); }
 
 #endif
 
@@ -271,7 +414,57 @@ AL_DLL_HIDDEN inline i256 sub8i(const i256 a, const i256 b) { return _mm256_sub_
 AL_DLL_HIDDEN inline d256 sub4d(const d256 a, const d256 b) { return _mm256_sub_pd(a, b); }
 AL_DLL_HIDDEN inline i256 sub4i64(const i256 a, const i256 b) { return _mm256_sub_epi64(a, b); }
 
+AL_DLL_HIDDEN inline f256 div8f(const f256 a, const f256 b) { return _mm256_div_ps(a, b); }
+AL_DLL_HIDDEN inline d256 div4d(const d256 a, const d256 b) { return _mm256_div_pd(a, b); }
+
+AL_DLL_HIDDEN inline f256 sqrt8f(const f256 a) { return _mm256_sqrt_ps(a); }
+AL_DLL_HIDDEN inline d256 sqrt4d(const d256 a) { return _mm256_sqrt_pd(a); }
+
+# if defined(__FMA__)
+AL_DLL_HIDDEN inline f256 fmadd8f(const f256 a, const f256 b, const f256 c) { return _mm256_fmadd_ps(a, b, c); }
+AL_DLL_HIDDEN inline f256 fmsub8f(const f256 a, const f256 b, const f256 c) { return _mm256_fmsub_ps(a, b, c); }
+AL_DLL_HIDDEN inline f256 fnmadd8f(const f256 a, const f256 b, const f256 c) { return _mm256_fnmadd_ps(a, b, c); }
+AL_DLL_HIDDEN inline d256 fmadd4d(const d256 a, const d256 b, const d256 c) { return _mm256_fmadd_pd(a, b, c); }
+AL_DLL_HIDDEN inline d256 fmsub4d(const d256 a, const d256 b, const d256 c) { return _mm256_fmsub_pd(a, b, c); }
+AL_DLL_HIDDEN inline d256 fnmadd4d(const d256 a, const d256 b, const d256 c) { return _mm256_fnmadd_pd(a, b, c); }
+# else
+AL_DLL_HIDDEN inline f256 fmadd8f(const f256 a, const f256 b, const f256 c) { return add8f(mul8f(a, b), c); }
+AL_DLL_HIDDEN inline f256 fmsub8f(const f256 a, const f256 b, const f256 c) { return sub8f(mul8f(a, b), c); }
+AL_DLL_HIDDEN inline f256 fnmadd8f(const f256 a, const f256 b, const f256 c) { return sub8f(c, mul8f(a, b)); }
+AL_DLL_HIDDEN inline d256 fmadd4d(const d256 a, const d256 b, const d256 c) { return add4d(mul4d(a, b), c); }
+AL_DLL_HIDDEN inline d256 fmsub4d(const d256 a, const d256 b, const d256 c) { return sub4d(mul4d(a, b), c); }
+AL_DLL_HIDDEN inline d256 fnmadd4d(const d256 a, const d256 b, const d256 c) { return sub4d(c, mul4d(a, b)); }
+# endif
+
+AL_DLL_HIDDEN inline i256 mullo8i(const i256 a, const i256 b) { return _mm256_mullo_epi32(a, b); }
+
+/// \brief  unsigned 32 x 32 -> 64 bit products of the even lanes.
+AL_DLL_HIDDEN inline i256 mul_even8u32(const i256 a, const i256 b) { return _mm256_mul_epu32(a, b); }
+
+/// \brief  low 64 bits of a * b, from three 32-bit multiplies.
+AL_DLL_HIDDEN inline i256 mullo4i64(const i256 a, const i256 b)
+{
+  const i256 cross = _mm256_add_epi64(mul_even8u32(_mm256_srli_epi64(a, 32), b), mul_even8u32(a, _mm256_srli_epi64(b, 32)));
+  return _mm256_add_epi64(mul_even8u32(a, b), _mm256_slli_epi64(cross, 32));
+}
+
+AL_DLL_HIDDEN inline f256 cvt8i_to_8f(const i256 reg) { return _mm256_cvtepi32_ps(reg); }
+AL_DLL_HIDDEN inline i256 cvtt8f_to_8i(const f256 reg) { return _mm256_cvttps_epi32(reg); }
+
+AL_DLL_HIDDEN inline f256 min8f(const f256 a, const f256 b) { return _mm256_min_ps(a, b); }
+AL_DLL_HIDDEN inline f256 max8f(const f256 a, const f256 b) { return _mm256_max_ps(a, b); }
+AL_DLL_HIDDEN inline d256 min4d(const d256 a, const d256 b) { return _mm256_min_pd(a, b); }
+AL_DLL_HIDDEN inline d256 max4d(const d256 a, const d256 b) { return _mm256_max_pd(a, b); }
+AL_DLL_HIDDEN inline i256 min8i(const i256 a, const i256 b) { return _mm256_min_epi32(a, b); }
+AL_DLL_HIDDEN inline i256 max8i(const i256 a, const i256 b) { return _mm256_max_epi32(a, b); }
+
+AL_DLL_HIDDEN inline d256 and4d(const d256 a, const d256 b) { return _mm256_and_pd(a, b); }
+AL_DLL_HIDDEN inline d256 andnot4d(const d256 a, const d256 b) { return _mm256_andnot_pd(a, b); }
+AL_DLL_HIDDEN inline i256 xor8i(const i256 a, const i256 b) { return _mm256_xor_si256(a, b); }
+
 AL_DLL_HIDDEN inline f256 select8f(const f256 falseResult, const f256 trueResult, const f256 cmp) { return _mm256_blendv_ps(falseResult, trueResult, cmp); }
+AL_DLL_HIDDEN inline d256 select4d(const d256 falseResult, const d256 trueResult, const d256 cmp) { return _mm256_blendv_pd(falseResult, trueResult, cmp); }
+AL_DLL_HIDDEN inline i256 select8i(const i256 falseResult, const i256 trueResult, const i256 cmp) { return _mm256_blendv_epi8(falseResult, trueResult, cmp); }
 
 AL_DLL_HIDDEN inline f256 permutevar8x32f(const f256 a, const i256 b) { return _mm256_permutevar8x32_ps(a, b); }
 
@@ -280,6 +473,11 @@ AL_DLL_HIDDEN inline f256 unpackhi8f(const f256 a, const f256 b) { return _mm256
 
 # define extract4f(reg, index) _mm256_extractf128_ps(reg, index)
 # define extract256i64(reg, index) _mm256_extract_epi64(reg, index)
+# define extract2d(reg, index) _mm256_extractf128_pd(reg, index)
+# define extract4i(reg, index) _mm256_extracti128_si256(reg, index)
+
+AL_DLL_HIDDEN inline d128 cast2d(const d256 reg) { return _mm256_castpd256_pd128(reg); }
+AL_DLL_HIDDEN inline i128 cast4i(const i256 reg) { return _mm256_castsi256_si128(reg); }
 
 AL_DLL_HIDDEN inline f256 splat8f(const float f) { return _mm256_set1_ps(f); }
 AL_DLL_HIDDEN inline d256 splat4d(const double f) { return _mm256_set1_pd(f); }
@@ -290,6 +488,15 @@ AL_DLL_HIDDEN inline f128 i32gather4f(const float* const ptr, const i128 indices
 AL_DLL_HIDDEN inline f256 i32gather8f(const float* const ptr, const i256 indices) { return _mm256_i32gather_ps(ptr, indices, 4); }
 AL_DLL_HIDDEN inline i128 i32gather4i(const int32_t* const ptr, const i128 indices) { return _mm_i32gather_epi32(ptr, indices, 4); }
 AL_DLL_HIDDEN inline i256 i32gather8i(const int32_t* const ptr, const i256 indices) { return _mm256_i32gather_epi32(ptr, indices, 4); }
+AL_DLL_HIDDEN inline d256 i32gather4d(const double* const ptr, const i128 indices) { return _mm256_i32gather_pd(ptr, indices, 8); }
+AL_DLL_HIDDEN inline d256 i64gather4d(const double* const ptr, const i256 indices) { return _mm256_i64gather_pd(ptr, indices, 8); }
+AL_DLL_HIDDEN inline i256 i64gather4i64(const int64_t* const ptr, const i256 indices) { return _mm256_i64gather_epi64((const long long*)ptr, indices, 8); }
+
+/// \brief  only the lanes whose mask sign bit is set are read; the others are taken from src.
+AL_DLL_HIDDEN inline f256 mask_i32gather8f(const f256 src, const float* const ptr, const i256 indices, const f256 mask)
+  { return _mm256_mask_i32gather_ps(src, ptr, indices, mask, 4); }
+AL_DLL_HIDDEN inline i256 mask_i32gather8i(const i256 src, const int32_t* const ptr, const i256 indices, const i256 mask)
+  { return _mm256_mask_i32gather_epi32(src, ptr, indices, mask, 4); }
 
 AL_DLL_HIDDEN inline f256 set2f128(const f128 lo, const f128 hi) { return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1); }
 
@@ -300,19 +507,88 @@ AL_DLL_HIDDEN inline f256 set2f128(const f128 lo, const f128 hi) { return _mm256
 # define shiftBitsLeft4i64(reg, count) _mm256_slli_epi64(reg, count)
 # define shiftBitsRight4i64(reg, count) _mm256_srli_epi64(reg, count)
 
-inline f256 cmpgt8f(const f256 a, const f256 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
-inline d256 cmpgt4d(const d256 a, const d256 b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
-inline f256 cmpne8f(const f256 a, const f256 b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_OQ); }
-inline d256 cmpne4d(const d256 a, const d256 b) { return _mm256_cmp_pd(a, b, _CMP_NEQ_OQ); }
-inline i256 cmpeq4i64(const i256 a, const i256 b) { return _mm256_cmpeq_epi64(a, b); }
-inline i256 cmpeq16i16(const i256 a, const i256 b) { return _mm256_cmpeq_epi16(a, b); }
-inline i256 cmpeq32i8(const i256 a, const i256 b) { return _mm256_cmpeq_epi8(a, b); }
+AL_DLL_HIDDEN inline f256 cmpgt8f(const f256 a, const f256 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+AL_DLL_HIDDEN inline d256 cmpgt4d(const d256 a, const d256 b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+AL_DLL_HIDDEN inline f256 cmpne8f(const f256 a, const f256 b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_OQ); }
+AL_DLL_HIDDEN inline d256 cmpne4d(const d256 a, const d256 b) { return _mm256_cmp_pd(a, b, _CMP_NEQ_OQ); }
+AL_DLL_HIDDEN inline i256 cmpeq4i64(const i256 a, const i256 b) { return _mm256_cmpeq_epi64(a, b); }
+AL_DLL_HIDDEN inline i256 cmpgt4i64(const i256 a, const i256 b) { return _mm256_cmpgt_epi64(a, b); }
+AL_DLL_HIDDEN inline i256 cmpeq16i16(const i256 a, const i256 b) { return _mm256_cmpeq_epi16(a, b); }
+AL_DLL_HIDDEN inline i256 cmpeq32i8(const i256 a, const i256 b) { return _mm256_cmpeq_epi8(a, b); }
+AL_DLL_HIDDEN inline i256 splat32i8(const int8_t x) { return _mm256_set1_epi8(x); }
+AL_DLL_HIDDEN inline f256 cmpeq8f(const f256 a, const f256 b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+AL_DLL_HIDDEN inline f256 cmpge8f(const f256 a, const f256 b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+AL_DLL_HIDDEN inline d256 cmpeq4d(const d256 a, const d256 b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+AL_DLL_HIDDEN inline d256 cmpge4d(const d256 a, const d256 b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+AL_DLL_HIDDEN inline i256 cmpgt8i(const i256 a, const i256 b) { return _mm256_cmpgt_epi32(a, b); }
+/// \brief  as lower_bound4i, for 8 lanes.
+AL_DLL_HIDDEN inline int lower_bound8i(const i256 levels, const int32_t value) { return ctz32((static_cast<uint32_t>(movemask8i(cmpgt8i(_mm256_set1_epi32(value), levels))) ^ 0xffu) | 0x100u); }
+
+AL_DLL_HIDDEN inline f256 abs8f(const f256 v) { return _mm256_andnot_ps(splat8f(-0.0f), v); }
+AL_DLL_HIDDEN inline d256 abs4d(const d256 v) { return _mm256_andnot_pd(splat4d(-0.0), v); }
+
+/// \brief  as cvtu52_2i64_to_2d and cvt2d_to_u52_2i64, for 4 lanes.
+AL_DLL_HIDDEN inline d256 cvtu52_4i64_to_4d(const i256 reg) { return sub4d(cast4d(or8i(reg, splat4i64(0x4330000000000000))), splat4d(0x1p52)); }
+AL_DLL_HIDDEN inline i256 cvt4d_to_u52_4i64(const d256 reg) { return xor8i(cast8i(add4d(reg, splat4d(0x1p52))), splat4i64(0x4330000000000000)); }
+
+/// \brief  horizontal reductions across every lane.
+AL_DLL_HIDDEN inline float hadd8f(const f256 v) { return first4f(hadd4f(add4f(cast4f(v), extract4f(v, 1)))); }
+AL_DLL_HIDDEN inline float hmin8f(const f256 v) { return first4f(hmin4f(min4f(cast4f(v), extract4f(v, 1)))); }
+AL_DLL_HIDDEN inline float hmax8f(const f256 v) { return first4f(hmax4f(max4f(cast4f(v), extract4f(v, 1)))); }
+AL_DLL_HIDDEN inline double hadd4d(const d256 v) { return first2d(hadd2d(add2d(cast2d(v), extract2d(v, 1)))); }
+AL_DLL_HIDDEN inline double hmin4d(const d256 v) { return first2d(hmin2d(min2d(cast2d(v), extract2d(v, 1)))); }
+AL_DLL_HIDDEN inline double hmax4d(const d256 v) { return first2d(hmax2d(max2d(cast2d(v), extract2d(v, 1)))); }
+AL_DLL_HIDDEN inline int32_t hadd8i(const i256 v) { return first4i(hadd4i(add4i(cast4i(v), extract4i(v, 1)))); }
+AL_DLL_HIDDEN inline int32_t hmin8i(const i256 v) { return first4i(hmin4i(_mm_min_epi32(cast4i(v), extract4i(v, 1)))); }
+AL_DLL_HIDDEN inline int32_t hmax8i(const i256 v) { return first4i(hmax4i(_mm_max_epi32(cast4i(v), extract4i(v, 1)))); }
+
+AL_DLL_HIDDEN inline i256 min4i64(const i256 a, const i256 b) { return select8i(a, b, cmpgt4i64(a, b)); }
+AL_DLL_HIDDEN inline i256 max4i64(const i256 a, const i256 b) { return select8i(b, a, cmpgt4i64(a, b)); }
+AL_DLL_HIDDEN inline int64_t hadd4i64(const i256 v) { return first2i64(hadd2i64(add2i64(cast4i(v), extract4i(v, 1)))); }
+AL_DLL_HIDDEN inline int64_t hmin4i64(const i256 v) { return first2i64(hmin2i64(min2i64(cast4i(v), extract4i(v, 1)))); }
+AL_DLL_HIDDEN inline int64_t hmax4i64(const i256 v) { return first2i64(hmax2i64(max2i64(cast4i(v), extract4i(v, 1)))); }
+
+# if defined(__BMI2__)
+/// \brief  packs the lanes whose bit is set in mask (bit i is lane i, as movemask8f
+///         returns it) into the low lanes, keeping their order. The remaining lanes
+///         are unspecified. pdep/pext are microcoded on AMD before Zen 3, where this
+///         is a lot slower.
+AL_DLL_HIDDEN inline f256 compress8f(const f256 v, const uint32_t mask)
+{
+  // Widen each mask bit to a byte, then use that to pull the selected lane numbers
+  // out of 0..7 (one per byte). The packed bytes become the permute indices.
+  const uint64_t expanded = _pdep_u64(mask, 0x0101010101010101ull) * 0xff;
+  const uint64_t lanes = _pext_u64(0x0706050403020100ull, expanded);
+  return permutevar8x32f(v, _mm256_cvtepu8_epi32(_mm_cvtsi64_si128((long long)lanes)));
+}
+AL_DLL_HIDDEN inline i256 compress8i(const i256 v, const uint32_t mask) { return cast8i(compress8f(cast8f(v), mask)); }
+/// \brief  as compress8f, with one mask bit per double (movemask4d).
+AL_DLL_HIDDEN inline d256 compress4d(const d256 v, const uint32_t mask) { return cast4d(compress8f(cast8f(v), _pdep_u32(mask, 0x55) * 3)); }
+# endif
 
-inline f256 abs8f(const f256 v) { return _mm256_andnot_ps(splat8f(-0.0f), v); }
-inline d256 abs4d(const d256 v) { return _mm256_andnot_pd(splat4d(-0.0), v); }
+/// \brief  writes the lanes whose mask sign bit is set, and leaves the rest of memory alone.
+AL_DLL_HIDDEN inline void maskstore8f(void* const ptr, const i256 mask, const f256 reg) { _mm256_maskstore_ps((float*)ptr, mask, reg); }
+AL_DLL_HIDDEN inline void maskstore8i(void* const ptr, const i256 mask, const i256 reg) { _mm256_maskstore_epi32((int*)ptr, mask, reg); }
+AL_DLL_HIDDEN inline void maskstore4d(void* const ptr, const i256 mask, const d256 reg) { _mm256_maskstore_pd((double*)ptr, mask, reg); }
+/// \brief  loads the lanes whose mask sign bit is set, and zeroes the rest. Masked-off lanes are
+///         never read, so they may lie past the end of an allocation.
+AL_DLL_HIDDEN inline f256 maskload8f(const void* const ptr, const i256 mask) { return _mm256_maskload_ps((const float*)ptr, mask); }
+AL_DLL_HIDDEN inline i256 maskload8i(const void* const ptr, const i256 mask) { return _mm256_maskload_epi32((const int*)ptr, mask); }
+AL_DLL_HIDDEN inline d256 maskload4d(const void* const ptr, const i256 mask) { return _mm256_maskload_pd((const double*)ptr, mask); }
+/// \brief  a maskload/maskstore mask selecting the first count lanes (all of them when count >= 8 / 4).
+AL_DLL_HIDDEN inline i256 firstn8i(const size_t count)
+{
+  const int32_t n = static_cast<int32_t>(count < 8 ? count : 8);
+  return _mm256_cmpgt_epi32(_mm256_set1_epi32(n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+AL_DLL_HIDDEN inline i256 firstn4i64(const size_t count)
+{
+  const int64_t n = static_cast<int64_t>(count < 4 ? count : 4);
+  return _mm256_cmpgt_epi64(_mm256_set1_epi64x(n), _mm256_setr_epi64x(0, 1, 2, 3));
+}
 
 /// \brief  loads up to 7 floating point values from ptr, and sets the other elements to zero.
-inline f256 loadmask7f(const void* const ptr, const size_t count)
+AL_DLL_HIDDEN inline f256 loadmask7f(const void* const ptr, const size_t count)
 {
   // mask_offset = 7 - (count % 8)
   //
@@ -330,12 +606,12 @@ inline f256 loadmask7f(const void* const ptr, const size_t count)
 }
 
 /// \brief  loads up to 7 integer values from ptr, and sets the other elements to zero.
-inline i256 loadmask7i(const void* const ptr, const size_t count)
+AL_DLL_HIDDEN inline i256 loadmask7i(const void* const ptr, const size_t count)
 {
     return cast8i(loadmask7f(ptr, count));
 }
 
-inline d256 loadmask3d(const void* const ptr, const size_t count)
+AL_DLL_HIDDEN inline d256 loadmask3d(const void* const ptr, const size_t count)
 {
   // mask_offset = 3 - (count % 3)
   //
@@ -349,26 +625,225 @@ inline d256 loadmask3d(const void* const ptr, const size_t count)
   const i256 loadmask = loadu8i(masks + mask_offset);
   return _mm256_maskload_pd((const double*)ptr, loadmask);
 }
-inline i256 loadmask3i64(const void* const ptr, const size_t count)
+AL_DLL_HIDDEN inline i256 loadmask3i64(const void* const ptr, const size_t count)
 {
   return cast8i(loadmask3d(ptr, count));
 }
 #endif
 
+#if defined(__AVX512F__)
+typedef __m512 f512;
+typedef __m512i i512;
+typedef __m512d d512;
+typedef __mmask16 mask16;
+typedef __mmask8 mask8;
+
+AL_DLL_HIDDEN inline f512 zero16f() { return _mm512_setzero_ps(); }
+AL_DLL_HIDDEN inline i512 zero16i() { return _mm512_setzero_si512(); }
+AL_DLL_HIDDEN inline d512 zero8d() { return _mm512_setzero_pd(); }
+
+AL_DLL_HIDDEN inline f512 splat16f(const float f) { return _mm512_set1_ps(f); }
+AL_DLL_HIDDEN inline d512 splat8d(const double f) { return _mm512_set1_pd(f); }
+AL_DLL_HIDDEN inline i512 splat16i(const int32_t f) { return _mm512_set1_epi32(f); }
+
+AL_DLL_HIDDEN inline f512 loadu16f(const void* const ptr) { return _mm512_loadu_ps(ptr); }
+AL_DLL_HIDDEN inline i512 loadu16i(const void* const ptr) { return _mm512_loadu_si512(ptr); }
+AL_DLL_HIDDEN inline d512 loadu8d(const void* const ptr) { return _mm512_loadu_pd(ptr); }
+
+AL_DLL_HIDDEN inline f512 load16f(const void* const ptr) { return _mm512_load_ps(ptr); }
+AL_DLL_HIDDEN inline i512 load16i(const void* const ptr) { return _mm512_load_si512(ptr); }
+AL_DLL_HIDDEN inline d512 load8d(const void* const ptr) { return _mm512_load_pd(ptr); }
+
+AL_DLL_HIDDEN inline void storeu16f(void* const ptr, const f512 reg) { _mm512_storeu_ps(ptr, reg); }
+AL_DLL_HIDDEN inline void storeu16i(void* const ptr, const i512 reg) { _mm512_storeu_si512(ptr, reg); }
+AL_DLL_HIDDEN inline void storeu8d(void* const ptr, const d512 reg) { _mm512_storeu_pd(ptr, reg); }
+
+AL_DLL_HIDDEN inline void store16f(void* const ptr, const f512 reg) { _mm512_store_ps(ptr, reg); }
+AL_DLL_HIDDEN inline void store16i(void* const ptr, const i512 reg) { _mm512_store_si512(ptr, reg); }
+AL_DLL_HIDDEN inline void store8d(void* const ptr, const d512 reg) { _mm512_store_pd(ptr, reg); }
+
+AL_DLL_HIDDEN inline f512 add16f(const f512 a, const f512 b) { return _mm512_add_ps(a, b); }
+AL_DLL_HIDDEN inline i512 add16i(const i512 a, const i512 b) { return _mm512_add_epi32(a, b); }
+AL_DLL_HIDDEN inline d512 add8d(const d512 a, const d512 b) { return _mm512_add_pd(a, b); }
+
+AL_DLL_HIDDEN inline f512 sub16f(const f512 a, const f512 b) { return _mm512_sub_ps(a, b); }
+AL_DLL_HIDDEN inline i512 sub16i(const i512 a, const i512 b) { return _mm512_sub_epi32(a, b); }
+AL_DLL_HIDDEN inline d512 sub8d(const d512 a, const d512 b) { return _mm512_sub_pd(a, b); }
+
+AL_DLL_HIDDEN inline f512 mul16f(const f512 a, const f512 b) { return _mm512_mul_ps(a, b); }
+AL_DLL_HIDDEN inline d512 mul8d(const d512 a, const d512 b) { return _mm512_mul_pd(a, b); }
+
+AL_DLL_HIDDEN inline f512 div16f(const f512 a, const f512 b) { return _mm512_div_ps(a, b); }
+AL_DLL_HIDDEN inline d512 div8d(const d512 a, const d512 b) { return _mm512_div_pd(a, b); }
+
+AL_DLL_HIDDEN inline f512 sqrt16f(const f512 a) { return _mm512_sqrt_ps(a); }
+AL_DLL_HIDDEN inline d512 sqrt8d(const d512 a) { return _mm512_sqrt_pd(a); }
+
+AL_DLL_HIDDEN inline f512 fmadd16f(const f512 a, const f512 b, const f512 c) { return _mm512_fmadd_ps(a, b, c); }
+AL_DLL_HIDDEN inline f512 fmsub16f(const f512 a, const f512 b, const f512 c) { return _mm512_fmsub_ps(a, b, c); }
+AL_DLL_HIDDEN inline f512 fnmadd16f(const f512 a, const f512 b, const f512 c) { return _mm512_fnmadd_ps(a, b, c); }
+AL_DLL_HIDDEN inline d512 fmadd8d(const d512 a, const d512 b, const d512 c) { return _mm512_fmadd_pd(a, b, c); }
+AL_DLL_HIDDEN inline d512 fmsub8d(const d512 a, const d512 b, const d512 c) { return _mm512_fmsub_pd(a, b, c); }
+AL_DLL_HIDDEN inline d512 fnmadd8d(const d512 a, const d512 b, const d512 c) { return _mm512_fnmadd_pd(a, b, c); }
+
+AL_DLL_HIDDEN inline i512 mullo16i(const i512 a, const i512 b) { return _mm512_mullo_epi32(a, b); }
+
+AL_DLL_HIDDEN inline i512 and16i(const i512 a, const i512 b) { return _mm512_and_si512(a, b); }
+AL_DLL_HIDDEN inline i512 or16i(const i512 a, const i512 b) { return _mm512_or_si512(a, b); }
+AL_DLL_HIDDEN inline i512 xor16i(const i512 a, const i512 b) { return _mm512_xor_si512(a, b); }
+AL_DLL_HIDDEN inline i512 andnot16i(const i512 a, const i512 b) { return _mm512_andnot_si512(a, b); }
+
+AL_DLL_HIDDEN inline f512 abs16f(const f512 v) { return _mm512_abs_ps(v); }
+AL_DLL_HIDDEN inline d512 abs8d(const d512 v) { return _mm512_abs_pd(v); }
+
+AL_DLL_HIDDEN inline f512 cvt16i_to_16f(const i512 reg) { return _mm512_cvtepi32_ps(reg); }
+AL_DLL_HIDDEN inline i512 cvtt16f_to_16i(const f512 reg) { return _mm512_cvttps_epi32(reg); }
+
+AL_DLL_HIDDEN inline i512 splat8i64(const int64_t f) { return _mm512_set1_epi64(f); }
+AL_DLL_HIDDEN inline i512 add8i64(const i512 a, const i512 b) { return _mm512_add_epi64(a, b); }
+AL_DLL_HIDDEN inline i512 sub8i64(const i512 a, const i512 b) { return _mm512_sub_epi64(a, b); }
+AL_DLL_HIDDEN inline i512 min8i64(const i512 a, const i512 b) { return _mm512_min_epi64(a, b); }
+AL_DLL_HIDDEN inline i512 max8i64(const i512 a, const i512 b) { return _mm512_max_epi64(a, b); }
+# if defined(__AVX512DQ__)
+AL_DLL_HIDDEN inline i512 mullo8i64(const i512 a, const i512 b) { return _mm512_mullo_epi64(a, b); }
+# else
+AL_DLL_HIDDEN inline i512 mullo8i64(const i512 a, const i512 b)
+{
+  const i512 cross = add8i64(_mm512_mul_epu32(_mm512_srli_epi64(a, 32), b), _mm512_mul_epu32(a, _mm512_srli_epi64(b, 32)));
+  return add8i64(_mm512_mul_epu32(a, b), _mm512_slli_epi64(cross, 32));
+}
+# endif
+
+AL_DLL_HIDDEN inline i256 cast8i(const i512 reg) { return _mm512_castsi512_si256(reg); }
+# define extract8i(reg, index) _mm512_extracti64x4_epi64(reg, index)
+AL_DLL_HIDDEN inline i512 cvt8i32_to_8i64(const i256 reg) { return _mm512_cvtepi32_epi64(reg); }
+
+AL_DLL_HIDDEN inline f512 permutexvar16f(const i512 indices, const f512 a) { return _mm512_permutexvar_ps(indices, a); }
+
+AL_DLL_HIDDEN inline f512 i32gather16f(const float* const ptr, const i512 indices) { return _mm512_i32gather_ps(indices, ptr, 4); }
+AL_DLL_HIDDEN inline i512 i32gather16i(const int32_t* const ptr, const i512 indices) { return _mm512_i32gather_epi32(indices, ptr, 4); }
+AL_DLL_HIDDEN inline d512 i32gather8d(const double* const ptr, const i256 indices) { return _mm512_i32gather_pd(indices, ptr, 8); }
+AL_DLL_HIDDEN inline d512 i64gather8d(const double* const ptr, const i512 indices) { return _mm512_i64gather_pd(indices, ptr, 8); }
+AL_DLL_HIDDEN inline i512 i64gather8i64(const int64_t* const ptr, const i512 indices) { return _mm512_i64gather_epi64(indices, ptr, 8); }
+
+AL_DLL_HIDDEN inline f512 min16f(const f512 a, const f512 b) { return _mm512_min_ps(a, b); }
+AL_DLL_HIDDEN inline f512 max16f(const f512 a, const f512 b) { return _mm512_max_ps(a, b); }
+AL_DLL_HIDDEN inline d512 min8d(const d512 a, const d512 b) { return _mm512_min_pd(a, b); }
+AL_DLL_HIDDEN inline d512 max8d(const d512 a, const d512 b) { return _mm512_max_pd(a, b); }
+AL_DLL_HIDDEN inline i512 min16i(const i512 a, const i512 b) { return _mm512_min_epi32(a, b); }
+AL_DLL_HIDDEN inline i512 max16i(const i512 a, const i512 b) { return _mm512_max_epi32(a, b); }
+
+/// \brief  comparisons produce a mask register with one bit per lane.
+AL_DLL_HIDDEN inline mask16 cmpeq16f(const f512 a, const f512 b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+AL_DLL_HIDDEN inline mask16 cmpne16f(const f512 a, const f512 b) { return _mm512_cmp_ps_mask(a, b, _CMP_NEQ_OQ); }
+AL_DLL_HIDDEN inline mask16 cmpgt16f(const f512 a, const f512 b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+AL_DLL_HIDDEN inline mask16 cmpge16f(const f512 a, const f512 b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+AL_DLL_HIDDEN inline mask8 cmpeq8d(const d512 a, const d512 b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+AL_DLL_HIDDEN inline mask8 cmpne8d(const d512 a, const d512 b) { return _mm512_cmp_pd_mask(a, b, _CMP_NEQ_OQ); }
+AL_DLL_HIDDEN inline mask8 cmpgt8d(const d512 a, const d512 b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+AL_DLL_HIDDEN inline mask8 cmpge8d(const d512 a, const d512 b) { return _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ); }
+AL_DLL_HIDDEN inline mask16 cmpeq16i(const i512 a, const i512 b) { return _mm512_cmpeq_epi32_mask(a, b); }
+AL_DLL_HIDDEN inline mask16 cmpgt16i(const i512 a, const i512 b) { return _mm512_cmpgt_epi32_mask(a, b); }
+/// \brief  as lower_bound4i, for 16 lanes; the compare writes the >= mask directly.
+AL_DLL_HIDDEN inline int lower_bound16i(const i512 levels, const int32_t value) { return ctz32(static_cast<uint32_t>(_mm512_cmpge_epi32_mask(levels, _mm512_set1_epi32(value))) | 0x10000u); }
+AL_DLL_HIDDEN inline mask8 cmpeq8i64(const i512 a, const i512 b) { return _mm512_cmpeq_epi64_mask(a, b); }
+AL_DLL_HIDDEN inline mask8 cmpgt8i64(const i512 a, const i512 b) { return _mm512_cmpgt_epi64_mask(a, b); }
+
+/// \brief  a mask with the low count lanes set (count may be 0 to 16, or 0 to 8).
+AL_DLL_HIDDEN inline mask16 firstn16(const size_t count) { return static_cast<mask16>(count >= 16 ? 0xffffu : (1u << count) - 1); }
+AL_DLL_HIDDEN inline mask8 firstn8(const size_t count) { return static_cast<mask8>(count >= 8 ? 0xffu : (1u << count) - 1); }
+
+AL_DLL_HIDDEN inline f512 select16f(const f512 falseResult, const f512 trueResult, const mask16 cmp) { return _mm512_mask_blend_ps(cmp, falseResult, trueResult); }
+AL_DLL_HIDDEN inline i512 select16i(const i512 falseResult, const i512 trueResult, const mask16 cmp) { return _mm512_mask_blend_epi32(cmp, falseResult, trueResult); }
+AL_DLL_HIDDEN inline d512 select8d(const d512 falseResult, const d512 trueResult, const mask8 cmp) { return _mm512_mask_blend_pd(cmp, falseResult, trueResult); }
+
+/// \brief  predicated operations. The mask_ forms keep src in the inactive lanes, the
+///         maskz_ forms zero them. Masked-off lanes of a load or store never touch
+///         memory, so they cannot fault.
+AL_DLL_HIDDEN inline f512 maskz_loadu16f(const mask16 k, const void* const ptr) { return _mm512_maskz_loadu_ps(k, ptr); }
+AL_DLL_HIDDEN inline i512 maskz_loadu16i(const mask16 k, const void* const ptr) { return _mm512_maskz_loadu_epi32(k, ptr); }
+AL_DLL_HIDDEN inline d512 maskz_loadu8d(const mask8 k, const void* const ptr) { return _mm512_maskz_loadu_pd(k, ptr); }
+AL_DLL_HIDDEN inline i512 maskz_loadu8i64(const mask8 k, const void* const ptr) { return _mm512_maskz_loadu_epi64(k, ptr); }
+
+AL_DLL_HIDDEN inline void mask_storeu16f(void* const ptr, const mask16 k, const f512 reg) { _mm512_mask_storeu_ps(ptr, k, reg); }
+AL_DLL_HIDDEN inline void mask_storeu16i(void* const ptr, const mask16 k, const i512 reg) { _mm512_mask_storeu_epi32(ptr, k, reg); }
+AL_DLL_HIDDEN inline void mask_storeu8d(void* const ptr, const mask8 k, const d512 reg) { _mm512_mask_storeu_pd(ptr, k, reg); }
+AL_DLL_HIDDEN inline void mask_storeu8i64(void* const ptr, const mask8 k, const i512 reg) { _mm512_mask_storeu_epi64(ptr, k, reg); }
+
+AL_DLL_HIDDEN inline f512 mask_add16f(const f512 src, const mask16 k, const f512 a, const f512 b) { return _mm512_mask_add_ps(src, k, a, b); }
+AL_DLL_HIDDEN inline f512 maskz_add16f(const mask16 k, const f512 a, const f512 b) { return _mm512_maskz_add_ps(k, a, b); }
+AL_DLL_HIDDEN inline f512 mask_sub16f(const f512 src, const mask16 k, const f512 a, const f512 b) { return _mm512_mask_sub_ps(src, k, a, b); }
+AL_DLL_HIDDEN inline f512 mask_mul16f(const f512 src, const mask16 k, const f512 a, const f512 b) { return _mm512_mask_mul_ps(src, k, a, b); }
+AL_DLL_HIDDEN inline f512 mask_div16f(const f512 src, const mask16 k, const f512 a, const f512 b) { return _mm512_mask_div_ps(src, k, a, b); }
+AL_DLL_HIDDEN inline i512 mask_add16i(const i512 src, const mask16 k, const i512 a, const i512 b) { return _mm512_mask_add_epi32(src, k, a, b); }
+AL_DLL_HIDDEN inline d512 mask_add8d(const d512 src, const mask8 k, const d512 a, const d512 b) { return _mm512_mask_add_pd(src, k, a, b); }
+AL_DLL_HIDDEN inline d512 maskz_add8d(const mask8 k, const d512 a, const d512 b) { return _mm512_maskz_add_pd(k, a, b); }
+AL_DLL_HIDDEN inline d512 mask_sub8d(const d512 src, const mask8 k, const d512 a, const d512 b) { return _mm512_mask_sub_pd(src, k, a, b); }
+AL_DLL_HIDDEN inline d512 mask_mul8d(const d512 src, const mask8 k, const d512 a, const d512 b) { return _mm512_mask_mul_pd(src, k, a, b); }
+AL_DLL_HIDDEN inline d512 mask_div8d(const d512 src, const mask8 k, const d512 a, const d512 b) { return _mm512_mask_div_pd(src, k, a, b); }
+
+AL_DLL_HIDDEN inline f512 mask_i32gather16f(const f512 src, const mask16 k, const float* const ptr, const i512 indices)
+  { return _mm512_mask_i32gather_ps(src, k, indices, ptr, 4); }
+
+/// \brief  packs the selected lanes into the low lanes, keeping their order, and zeroes
+///         the rest. Prefer compress + a full store over compressstoreu: the memory
+///         form is microcoded on Zen 4.
+AL_DLL_HIDDEN inline f512 compress16f(const mask16 k, const f512 v) { return _mm512_maskz_compress_ps(k, v); }
+AL_DLL_HIDDEN inline i512 compress16i(const mask16 k, const i512 v) { return _mm512_maskz_compress_epi32(k, v); }
+AL_DLL_HIDDEN inline d512 compress8d(const mask8 k, const d512 v) { return _mm512_maskz_compress_pd(k, v); }
+AL_DLL_HIDDEN inline void compressstoreu16f(void* const ptr, const mask16 k, const f512 v) { _mm512_mask_compressstoreu_ps(ptr, k, v); }
+AL_DLL_HIDDEN inline void compressstoreu16i(void* const ptr, const mask16 k, const i512 v) { _mm512_mask_compressstoreu_epi32(ptr, k, v); }
+AL_DLL_HIDDEN inline void compressstoreu8d(void* const ptr, const mask8 k, const d512 v) { _mm512_mask_compressstoreu_pd(ptr, k, v); }
+
+AL_DLL_HIDDEN inline float hadd16f(const f512 v) { return _mm512_reduce_add_ps(v); }
+AL_DLL_HIDDEN inline float hmin16f(const f512 v) { return _mm512_reduce_min_ps(v); }
+AL_DLL_HIDDEN inline float hmax16f(const f512 v) { return _mm512_reduce_max_ps(v); }
+AL_DLL_HIDDEN inline double hadd8d(const d512 v) { return _mm512_reduce_add_pd(v); }
+AL_DLL_HIDDEN inline double hmin8d(const d512 v) { return _mm512_reduce_min_pd(v); }
+AL_DLL_HIDDEN inline double hmax8d(const d512 v) { return _mm512_reduce_max_pd(v); }
+AL_DLL_HIDDEN inline int32_t hadd16i(const i512 v) { return _mm512_reduce_add_epi32(v); }
+AL_DLL_HIDDEN inline int32_t hmin16i(const i512 v) { return _mm512_reduce_min_epi32(v); }
+AL_DLL_HIDDEN inline int32_t hmax16i(const i512 v) { return _mm512_reduce_max_epi32(v); }
+AL_DLL_HIDDEN inline int64_t hadd8i64(const i512 v) { return _mm512_reduce_add_epi64(v); }
+AL_DLL_HIDDEN inline int64_t hmin8i64(const i512 v) { return _mm512_reduce_min_epi64(v); }
+AL_DLL_HIDDEN inline int64_t hmax8i64(const i512 v) { return _mm512_reduce_max_epi64(v); }
+
+AL_DLL_HIDDEN inline i512 select8i64(const i512 falseResult, const i512 trueResult, const mask8 cmp) { return _mm512_mask_blend_epi64(cmp, falseResult, trueResult); }
+
+# define shiftBitsLeft8i64(reg, count) _mm512_slli_epi64(reg, count)
+# define shiftBitsRight8i64(reg, count) _mm512_srli_epi64(reg, count)
+
+/// \brief  as cvtu52_2i64_to_2d and cvt2d_to_u52_2i64, for 8 lanes; exact for any
+///         int64 with AVX-512DQ.
+# if defined(__AVX512DQ__)
+AL_DLL_HIDDEN inline d512 cvtu52_8i64_to_8d(const i512 reg) { return _mm512_cvtepi64_pd(reg); }
+AL_DLL_HIDDEN inline i512 cvt8d_to_u52_8i64(const d512 reg) { return _mm512_cvtpd_epi64(reg); }
+# else
+AL_DLL_HIDDEN inline d512 cvtu52_8i64_to_8d(const i512 reg) { return sub8d(_mm512_castsi512_pd(or16i(reg, splat8i64(0x4330000000000000))), splat8d(0x1p52)); }
+AL_DLL_HIDDEN inline i512 cvt8d_to_u52_8i64(const d512 reg) { return xor16i(_mm512_castpd_si512(add8d(reg, splat8d(0x1p52))), splat8i64(0x4330000000000000)); }
+# endif
+
+# if defined(__AVX512BW__)
+typedef __mmask64 mask64;
+AL_DLL_HIDDEN inline i512 splat64i8(const int8_t x) { return _mm512_set1_epi8(x); }
+AL_DLL_HIDDEN inline mask64 cmpeq64i8(const i512 a, const i512 b) { return _mm512_cmpeq_epi8_mask(a, b); }
+# endif
+#endif
+
 #ifdef __F16C__
 # ifdef __AVX__
-inline f256 cvtph8(const i128 a) { return _mm256_cvtph_ps(a); }
-inline i128 cvtph8(const f256 a) { return _mm256_cvtps_ph(a, _MM_FROUND_CUR_DIRECTION); }
+AL_DLL_HIDDEN inline f256 cvtph8(const i128 a) { return _mm256_cvtph_ps(a); }
+AL_DLL_HIDDEN inline i128 cvtph8(const f256 a) { return _mm256_cvtps_ph(a, _MM_FROUND_CUR_DIRECTION); }
 # else
-inline f128 cvtph4(const i128 a) { return _mm_cvtph_ps(a); }
-inline i128 cvtph4(const f128 a) { return _mm_cvtps_ph(a, _MM_FROUND_CUR_DIRECTION); }
+AL_DLL_HIDDEN inline f128 cvtph4(const i128 a) { return _mm_cvtph_ps(a); }
+AL_DLL_HIDDEN inline i128 cvtph4(const f128 a) { return _mm_cvtps_ph(a, _MM_FROUND_CUR_DIRECTION); }
 # endif
 #endif
 
 
 #ifdef __AVX__
 /// \brief  loads up to 3 floating point values from ptr, and sets the other elements to zero.
-inline f128 loadmask3f(const void* const ptr, const size_t count)
+AL_DLL_HIDDEN inline f128 loadmask3f(const void* const ptr, const size_t count)
 {
   // mask_offset = 3 - (count % 3)
   //
@@ -384,7 +859,7 @@ inline f128 loadmask3f(const void* const ptr, const size_t count)
 }
 #elif defined(__SSE__)
 /// \brief  loads up to 3 floating point values from ptr, and sets the other elements to zero.
-inline f128 loadmask3f(const void* const ptr, size_t count)
+AL_DLL_HIDDEN inline f128 loadmask3f(const void* const ptr, size_t count)
 {
   alignas(16) float p[4] = {0};
   const float* const fp = (const float*)ptr;
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include "cpu_features.hpp"
+#include "simd_kernels.hpp"
+
+
+namespace simd_kernels {
+
+inline bool supported(Isa isa) {
+    const CpuFeatures& cpu = cpu_features();
+    switch (isa) {
+    case Isa::SSE2:
+        return cpu.sse2;
+    case Isa::AVX2:
+        return cpu.avx2 && cpu.fma && cpu.bmi1 && cpu.bmi2;
+    case Isa::AVX512:
+        return supported(Isa::AVX2) && cpu.avx512f && cpu.avx512bw && cpu.avx512dq && cpu.avx512vl;
+    }
+    return false;
+}
+
+inline const KernelTable& table(Isa isa) {
+    switch (isa) {
+    case Isa::AVX512: return avx512::table;
+    case Isa::AVX2: return avx2::table;
+    case Isa::SSE2: break;
+    }
+    return sse2::table;
+}
+
+// The widest table the host supports.
+inline const KernelTable& active() {
+    static const KernelTable& best =
+        supported(Isa::AVX512) ? avx512::table :
+        supported(Isa::AVX2) ? avx2::table :
+        sse2::table;
+    return best;
+}
+
+// Benchmark Apply() helper: one run per instruction set the host supports, with the
+// Isa as range(0).
+inline void supported_isa_args(benchmark::internal::Benchmark* b) {
+    b->ArgName("isa");
+    for (Isa isa : {Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        if (supported(isa)) {
+            b->Arg(static_cast<int>(isa));
+        }
+    }
+}
+
+inline const KernelTable& table_for(const benchmark::State& state) {
+    return table(static_cast<Isa>(state.range(0)));
+}
+
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <string.h>
+#include "simd_kernels.hpp"
+#include "simd_vec.hpp"
+
+
+// FIX tokenizer and fixed-point number parser behind KernelTable::fix_split and
+// KernelTable::parse_ticks. Only included from simd_kernels_*.cpp.
+//
+// Both read whole vectors at a time, which can run past the end of the input into
+// the fix_padding bytes the caller leaves after it. Bytes past the end are masked
+// off, so their values never matter.
+namespace simd_kernels {
+namespace {
+
+constexpr char fix_soh = '\x01';
+
+// Bit i of soh and eq is set where p[i] is SOH or '=', for 64 bytes, built from as
+// many byte vectors as that takes.
+template <typename B>
+AL_DLL_HIDDEN inline void match_delimiters(const char* p, uint64_t& soh, uint64_t& eq) {
+    const B soh_bytes = B::broadcast(fix_soh);
+    const B eq_bytes = B::broadcast('=');
+    soh = 0;
+    eq = 0;
+    for (int k = 0; k < 64 / B::width; ++k) {
+        const B v = B::loadu(p + k * B::width);
+        soh |= (v == soh_bytes).bits() << (k * B::width);
+        eq |= (v == eq_bytes).bits() << (k * B::width);
+    }
+}
+
+// Tags of up to four digits are read as one 32-bit word, right-aligned so the
+// missing leading digits are zero, and folded in two multiply-add steps. limit is the
+// end of the field, which the word must not run past.
+inline uint32_t parse_tag(const char* begin, const char* end, const char* limit) {
+    const size_t length = static_cast<size_t>(end - begin);
+    if (length - 1 < 4 && limit - begin >= 4) {
+        uint32_t x;
+        memcpy(&x, begin, 4);
+        x = (x << (8 * (4 - length))) & 0x0f0f0f0f;
+        x = (x * 10 + (x >> 8)) & 0x00ff00ff;
+        return (x & 0xff) * 100 + (x >> 16);
+    }
+    uint32_t tag = 0;
+    for (; begin != end; ++begin) {
+        tag = tag * 10 + static_cast<uint32_t>(*begin - '0');
+    }
+    return tag;
+}
+
+// Walks the SOH and '=' bits 64 bytes at a time. Between a SOH and the next '=' is a
+// tag; after that only SOH matters, since values may contain '='.
+template <typename B>
+size_t fix_split(const char* data, size_t n, FixField* fields, size_t max_fields) {
+    size_t count = 0;
+    size_t field_start = 0;
+    size_t tag_end = 0;
+    bool in_value = false;
+    if (max_fields == 0) return 0;
+
+    for (size_t base = 0; base < n; base += 64) {
+        uint64_t soh, eq;
+        match_delimiters<B>(data + base, soh, eq);
+        if (n - base < 64) {
+            const uint64_t valid = (uint64_t(1) << (n - base)) - 1;
+            soh &= valid;
+            eq &= valid;
+        }
+
+        uint64_t pending = in_value ? soh : (soh | eq);
+        while (pending != 0) {
+            const int bit = ctz64(pending);
+            const size_t pos = base + bit;
+            const uint64_t above = ~((uint64_t(2) << bit) - 1);
+            if (!in_value) {
+                if ((eq >> bit) & 1) {
+                    tag_end = pos;
+                    in_value = true;
+                    pending = soh & above;
+                } else {
+                    // A field with no '='; skip it.
+                    field_start = pos + 1;
+                    pending &= above;
+                }
+            } else {
+                fields[count].tag = parse_tag(data + field_start, data + tag_end, data + pos + 1);
+                fields[count].offset = static_cast<uint32_t>(tag_end + 1);
+                fields[count].length = static_cast<uint32_t>(pos - tag_end - 1);
+                if (++count == max_fields) return count;
+                field_start = pos + 1;
+                in_value = false;
+                pending = (soh | eq) & above;
+            }
+        }
+    }
+    return count;
+}
+
+
+inline bool is_digit(const char c) {
+    return static_cast<unsigned>(c - '0') <= 9;
+}
+
+// Digit at a time, for inputs too long for the vector path.
+inline int64_t parse_ticks_scalar(const char* s, size_t len, int decimals) {
+    size_t i = 0;
+    const bool negative = len != 0 && s[0] == '-';
+    i += negative;
+    uint64_t value = 0;
+    for (; i < len && is_digit(s[i]); ++i) {
+        value = value * 10 + static_cast<uint64_t>(s[i] - '0');
+    }
+    int fraction = 0;
+    if (i < len && s[i] == '.') {
+        for (++i; i < len && fraction < decimals && is_digit(s[i]); ++i, ++fraction) {
+            value = value * 10 + static_cast<uint64_t>(s[i] - '0');
+        }
+    }
+    for (; fraction < decimals; ++fraction) {
+        value *= 10;
+    }
+    return negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+}
+
+// Byte j of the result is v[j + offset], or zero outside v. Only used where the
+// caller masks off every byte that would come from past the end of v.
+inline i128 shift_digits(const i128 v, const int offset) {
+#if defined(__SSSE3__)
+    // pshufb zeroes bytes with a negative index, which covers everything before v.
+    return shuffle16i8(v, add16i8(set16i8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), splat16i8(static_cast<int8_t>(offset))));
+#else
+    int8_t buffer[64] = {};
+    storeu4i(buffer + 16, v);
+    return loadu4i(buffer + 16 + offset);
+#endif
+}
+
+// Classifies 16 bytes at once to find the integer and fraction digits, lines them up
+// so that the decimal point falls decimals digits from the right, and folds the 16
+// digits into a number with three multiply-add steps (2, 4, then 8 digits per lane).
+int64_t parse_ticks(const char* s, size_t len, int decimals) {
+    const bool negative = len != 0 && s[0] == '-';
+    const char* const p = s + negative;
+    const size_t digits_len = len - negative;
+    if (digits_len > 16 || decimals < 0 || decimals > 16) {
+        return parse_ticks_scalar(s, len, decimals);
+    }
+
+    const i128 d = sub16i8(loadu4i(p), splat16i8('0'));
+    const uint32_t digits = static_cast<uint32_t>(movemask16i8(cmpeq16i8(min16u8(d, splat16i8(9)), d))) & ((1u << digits_len) - 1);
+    const int whole = ctz32(~digits);
+    int fraction = 0;
+    if (static_cast<size_t>(whole) < digits_len && p[whole] == '.') {
+        fraction = ctz32(~(digits >> (whole + 1)));
+        fraction = fraction < decimals ? fraction : decimals;
+    }
+    if (whole + decimals > 16) {
+        return parse_ticks_scalar(s, len, decimals);
+    }
+
+    // The whole part ends at byte point, and the fraction starts there.
+    const int point = 16 - decimals;
+    const i128 lanes = set16i8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const i128 whole_mask = cmpgt16i8(splat16i8(static_cast<int8_t>(point)), lanes);
+    const i128 fraction_mask = andnot4i(whole_mask, cmpgt16i8(splat16i8(static_cast<int8_t>(point + fraction)), lanes));
+    const i128 aligned = or4i(and4i(shift_digits(d, whole - point), whole_mask),
+                              and4i(shift_digits(d, whole + 1 - point), fraction_mask));
+
+    const i128 zero = zero4i();
+    const i128 pairs_lo = madd8i16(unpacklo16i8(aligned, zero), splat4i(0x0001000A));
+    const i128 pairs_hi = madd8i16(unpackhi16i8(aligned, zero), splat4i(0x0001000A));
+    const i128 quads = madd8i16(packs4i(pairs_lo, pairs_hi), splat4i(0x00010064));
+    const i128 octets = madd8i16(packs4i(quads, quads), splat4i(0x00012710));
+    const uint64_t value = static_cast<uint64_t>(first4i(octets)) * 100000000u
+                         + static_cast<uint64_t>(first4i(shiftBytesRight128(octets, 4)));
+    return negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+}
+
+}
+}
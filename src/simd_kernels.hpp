@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+// Kernels built once per instruction set. Each simd_kernels_<isa>.cpp is compiled with
+// its own -m flags (see CMakeLists.txt) and fills in a KernelTable; simd_dispatch.hpp
+// picks the best one the host supports.
+//
+// The kernel translation units stick to raw pointers and simd.hpp. Any inline library
+// code they instantiate (std::vector, benchmark.h, ...) would get a copy built with
+// their -m flags, and the linker is free to hand that copy to the baseline build.
+namespace simd_kernels {
+
+enum class Isa : int {
+    SSE2 = 0,
+    AVX2 = 1,
+    AVX512 = 2,
+};
+
+// Operations timed by the per-op throughput benchmarks (simd_throughput.hpp).
+enum class SimdOp : int {
+    Add,
+    Mul,
+    Div,
+    Sqrt,
+    Fma,
+    Min,
+    Max,
+    Gather,
+    Compress,
+    HorizontalAdd,
+    Count,
+};
+
+// sum and sum_squares accumulate in Acc (int64_t for int32_t inputs; int64_t sums of
+// squares wrap). min and max return the extreme value of T for an empty range. argmin
+// and argmax return the first position of the extreme, as std::min_element does.
+template <typename T, typename Acc>
+struct ReductionKernels {
+    Acc (*sum)(const T* data, size_t n);
+    Acc (*sum_squares)(const T* data, size_t n);
+    T (*min)(const T* data, size_t n);
+    T (*max)(const T* data, size_t n);
+    size_t (*argmin)(const T* data, size_t n);
+    size_t (*argmax)(const T* data, size_t n);
+};
+
+// One tag=value field of a FIX message. offset and length locate the value, relative
+// to the start of the buffer given to fix_split.
+struct FixField {
+    uint32_t tag;
+    uint32_t offset;
+    uint32_t length;
+};
+
+// fix_split and parse_ticks load whole vectors, and may read up to this many bytes
+// past the end of their input. The buffer holding the input must have them; their
+// values do not matter.
+constexpr size_t fix_padding = 64;
+
+// Pre-trade risk checks (risk_checks.hpp). Prices are in ticks and quantities in lots;
+// each limit that an order breaks sets one bit of its flags.
+enum RiskErrorFlags : uint8_t {
+    NoRiskError = 0,
+    QuantityError = 1 << 0,   // zero, or more than max_quantity
+    PriceBandError = 1 << 1,  // further than price_band from reference_price
+    NotionalError = 1 << 2,   // price * quantity above max_notional
+    PositionError = 1 << 3,   // |position| would go above max_position
+    RateError = 1 << 4,       // more than max_orders in the current window
+    AllRiskErrors = (1 << 5) - 1,
+};
+
+struct RiskLimits {
+    int64_t max_quantity;
+    int64_t reference_price;
+    int64_t price_band;
+    int64_t max_notional;  // 0 to 2^52 - 2
+    int64_t max_position;  // below 2^59
+    int64_t max_orders;
+    uint8_t enabled;  // RiskErrorFlags of the checks to apply
+};
+
+struct RiskState {
+    int64_t position;     // signed, after every accepted order
+    int64_t orders_sent;  // orders checked in the current window
+};
+
+struct KernelTable {
+    Isa isa;
+    const char* name;
+    size_t float_lanes;     // floats per vector register
+
+    // c[i] = a[i] + b[i] for any n. The last partial vector uses masked loads and stores
+    // where the instruction set has them.
+    void (*add_arrays)(const float* a, const float* b, float* c, size_t n);
+
+    // Sum of data[0, n) in int64, prefetching prefetch_distance elements ahead (0
+    // disables it).
+    int64_t (*sum_i32)(const int32_t* data, size_t n, size_t prefetch_distance);
+
+    // The same two kernels written directly against the simd.hpp wrappers; the ones
+    // above are built from simd::Vec (see simd_kernels_impl.hpp).
+    void (*add_arrays_intrinsics)(const float* a, const float* b, float* c, size_t n);
+    int64_t (*sum_i32_intrinsics)(const int32_t* data, size_t n, size_t prefetch_distance);
+
+    // Applies op to every float in data[0, n) and folds the results into a checksum.
+    // n must be a multiple of 64. Gather reads data at indices[0, n); Compress writes
+    // into scratch, which needs room for n + 16 floats.
+    float (*simd_op)(SimdOp op, const float* data, const int32_t* indices, float* scratch, size_t n);
+
+    // ADX for float_lanes instruments at once. The inputs are transposed so that bar i
+    // of instrument j is at [i * float_lanes + j]; out receives one ADX per lane.
+    void (*adx_lanes)(const float* highs, const float* lows, const float* closes, size_t bars, size_t period, float* out);
+
+    // The reduction library (simd_reduce.hpp).
+    ReductionKernels<int32_t, int64_t> reduce_i32;
+    ReductionKernels<int64_t, int64_t> reduce_i64;
+    ReductionKernels<float, float> reduce_f32;
+    ReductionKernels<double, double> reduce_f64;
+
+    // FIX tokenizer and price parser (simd_fix.hpp). fix_split splits data[0, n) into
+    // SOH-terminated tag=value fields. It writes at most max_fields of them and returns
+    // how many it wrote. A trailing field with no SOH is left out. data[n, n +
+    // fix_padding) must be readable.
+    size_t (*fix_split)(const char* data, size_t n, FixField* fields, size_t max_fields);
+
+    // Parses [-]digits[.digits] from s[0, len) as a whole number of 10^-decimals ticks,
+    // so "101.25" with decimals = 4 is 1012500. Fraction digits past decimals are
+    // dropped, and parsing stops at the first character that does not fit the pattern.
+    // s[len, len + fix_padding) must be readable.
+    int64_t (*parse_ticks)(const char* s, size_t len, int decimals);
+
+    // Index of the first of levels[0, n) (sorted ascending) that is >= value, as
+    // std::lower_bound, found with a linear SIMD scan.
+    size_t (*lower_bound_i32)(const int32_t* levels, size_t n, int32_t value);
+
+    // adx_lanes on int64 tick prices in fixed point (fixed_point.hpp), for
+    // float_lanes / 2 instruments at once, laid out the same way. Matches fixed::ADX
+    // bit for bit.
+    void (*adx_lanes_ticks)(const int64_t* highs, const int64_t* lows, const int64_t* closes, size_t bars, size_t period, float* out);
+
+    // Risk checks for orders [0, n), with quantities signed (positive buys, negative
+    // sells). errors[i] receives the RiskErrorFlags of order i. An order's position is
+    // state.position after every earlier accepted order, plus its own quantity; its
+    // rate counts every earlier order, accepted or not. So splitting the orders into
+    // smaller batches gives the same flags and final state. On return state includes
+    // the accepted orders' quantities and all n orders. Returns the OR of errors[0, n).
+    uint8_t (*risk_check)(const int64_t* prices, const int64_t* quantities, size_t n,
+                          const RiskLimits& limits, RiskState& state, uint8_t* errors);
+};
+
+namespace sse2 { extern const KernelTable table; }
+namespace avx2 { extern const KernelTable table; }
+namespace avx512 { extern const KernelTable table; }
+
+}
@@ -0,0 +1,110 @@
+#include "simd_kernels_impl.hpp"
+
+
+namespace simd_kernels::avx512 {
+
+static_assert(simd::native_width<float> == 16, "simd_kernels_avx512.cpp built with the wrong -m flags");
+
+namespace {
+
+// Hand-written intrinsics, kept to show the simd::Vec versions cost nothing extra.
+
+void add_arrays_intrinsics(const float* a, const float* b, float* c, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        storeu16f(c + i, add16f(loadu16f(a + i), loadu16f(b + i)));
+    }
+    if (i < n) {
+        const mask16 tail = firstn16(n - i);
+        mask_storeu16f(c + i, tail, add16f(maskz_loadu16f(tail, a + i), maskz_loadu16f(tail, b + i)));
+    }
+}
+
+// Sign-extends v to int64 and adds the halves into lo and hi.
+inline void accumulate(i512& lo, i512& hi, const i512 v) {
+    lo = add8i64(lo, cvt8i32_to_8i64(cast8i(v)));
+    hi = add8i64(hi, cvt8i32_to_8i64(extract8i(v, 1)));
+}
+
+// Four int64 accumulators, reduced to a scalar once at the end.
+int64_t sum_i32_intrinsics(const int32_t* data, size_t n, size_t prefetch_distance) {
+    constexpr size_t stride = 64;
+    i512 acc0 = zero16i(), acc1 = zero16i(), acc2 = zero16i(), acc3 = zero16i();
+    auto block = [&](const int32_t* p) {
+        accumulate(acc0, acc1, loadu16i(p));
+        accumulate(acc2, acc3, loadu16i(p + 16));
+        accumulate(acc0, acc1, loadu16i(p + 32));
+        accumulate(acc2, acc3, loadu16i(p + 48));
+    };
+    size_t i = 0;
+    if (prefetch_distance != 0 && n > prefetch_distance) {
+        for (; i + stride <= n - prefetch_distance; i += stride) {
+            _mm_prefetch(reinterpret_cast<const char*>(data + i + prefetch_distance), _MM_HINT_T0);
+            _mm_prefetch(reinterpret_cast<const char*>(data + i + prefetch_distance + 16), _MM_HINT_T0);
+            _mm_prefetch(reinterpret_cast<const char*>(data + i + prefetch_distance + 32), _MM_HINT_T0);
+            _mm_prefetch(reinterpret_cast<const char*>(data + i + prefetch_distance + 48), _MM_HINT_T0);
+            block(data + i);
+        }
+    }
+    for (; i + stride <= n; i += stride) {
+        block(data + i);
+    }
+    int64_t sum = hadd8i64(add8i64(add8i64(acc0, acc1), add8i64(acc2, acc3)));
+    for (; i < n; ++i) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+}
+
+extern const KernelTable table = {
+    Isa::AVX512,
+    "avx512",
+    simd::native_width<float>,
+    add_arrays<simd::Native<float>>,
+    sum_i32<simd::Native<int32_t>>,
+    add_arrays_intrinsics,
+    sum_i32_intrinsics,
+    simd_op<simd::Native<float>>,
+    adx_lanes<simd::Native<float>>,
+    {
+        reduce<WideSumOp<simd::Native<int32_t>>>,
+        reduce<WideSumSquaresOp<simd::Native<int32_t>>>,
+        reduce<MinOp<simd::Native<int32_t>>>,
+        reduce<MaxOp<simd::Native<int32_t>>>,
+        argmin<simd::Native<int32_t>>,
+        argmax<simd::Native<int32_t>>,
+    },
+    {
+        reduce<SumOp<simd::Native<int64_t>>>,
+        reduce<SumSquaresOp<simd::Native<int64_t>>>,
+        reduce<MinOp<simd::Native<int64_t>>>,
+        reduce<MaxOp<simd::Native<int64_t>>>,
+        argmin<simd::Native<int64_t>>,
+        argmax<simd::Native<int64_t>>,
+    },
+    {
+        reduce<SumOp<simd::Native<float>>>,
+        reduce<SumSquaresOp<simd::Native<float>>>,
+        reduce<MinOp<simd::Native<float>>>,
+        reduce<MaxOp<simd::Native<float>>>,
+        argmin<simd::Native<float>>,
+        argmax<simd::Native<float>>,
+    },
+    {
+        reduce<SumOp<simd::Native<double>>>,
+        reduce<SumSquaresOp<simd::Native<double>>>,
+        reduce<MinOp<simd::Native<double>>>,
+        reduce<MaxOp<simd::Native<double>>>,
+        argmin<simd::Native<double>>,
+        argmax<simd::Native<double>>,
+    },
+    fix_split<simd::Native<int8_t>>,
+    parse_ticks,
+    lower_bound_i32<simd::Native<int32_t>>,
+    adx_lanes_ticks<simd::Native<int64_t>>,
+    risk_check<simd::Native<int64_t>>,
+};
+
+}
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <string.h>
+#include "fixed_point.hpp"
+#include "simd_kernels.hpp"
+#include "simd_fix.hpp"
+#include "simd_reduce.hpp"
+#include "simd_vec.hpp"
+
+
+// Kernel bodies shared by simd_kernels_*.cpp. They are written once against
+// simd::Vec, and each file instantiates them at its own native width. The unnamed
+// namespace keeps every instantiation private to the file that built it.
+namespace simd_kernels {
+namespace {
+
+template <typename V>
+void add_arrays(const float* a, const float* b, float* c, size_t n) {
+    constexpr size_t width = V::width;
+    size_t i = 0;
+    for (; i + width <= n; i += width) {
+        (V::loadu(a + i) + V::loadu(b + i)).storeu(c + i);
+    }
+    if (i < n) {
+        (V::load_partial(a + i, n - i) + V::load_partial(b + i, n - i)).store_partial(c + i, n - i);
+    }
+}
+
+template <typename V>
+int64_t sum_i32(const int32_t* data, size_t n, size_t prefetch_distance) {
+    return reduce_loop<WideSumOp<V>>(data, n, prefetch_distance);
+}
+
+// One loop per SimdOp. Four independent accumulators keep it from being bound by the
+// latency of a single dependency chain, so what is left is the op's throughput (plus a
+// load from L1). Inputs are expected close to 1 so that Mul and Div neither overflow
+// nor go denormal.
+template <typename V, SimdOp Op>
+float simd_op_loop(const float* data, const int32_t* indices, float* scratch, size_t n) {
+    using IV = simd::Vec<int32_t, V::width>;
+    constexpr size_t width = V::width;
+    constexpr float init =
+        (Op == SimdOp::Mul || Op == SimdOp::Div) ? 1.0f :
+        Op == SimdOp::Min ? 1e30f :
+        Op == SimdOp::Max ? -1e30f :
+        0.0f;
+    const V k = V::broadcast(0.999f);
+    const V one = V::broadcast(1.0f);
+    V acc[4] = {V::broadcast(init), V::broadcast(init), V::broadcast(init), V::broadcast(init)};
+    float scalar = 0.0f;
+    size_t out = 0;
+
+    for (size_t i = 0; i < n; i += 4 * width) {
+        for (size_t j = 0; j < 4; ++j) {
+            const V x = V::loadu(data + i + j * width);
+            if constexpr (Op == SimdOp::Add) acc[j] += x;
+            else if constexpr (Op == SimdOp::Mul) acc[j] *= x;
+            else if constexpr (Op == SimdOp::Div) acc[j] = acc[j] / x;
+            else if constexpr (Op == SimdOp::Sqrt) acc[j] += sqrt(x);
+            else if constexpr (Op == SimdOp::Fma) acc[j] = fmadd(x, k, acc[j]);
+            else if constexpr (Op == SimdOp::Min) acc[j] = min(acc[j], x);
+            else if constexpr (Op == SimdOp::Max) acc[j] = max(acc[j], x);
+            else if constexpr (Op == SimdOp::Gather) acc[j] += gather(data, IV::loadu(indices + i + j * width));
+            else if constexpr (Op == SimdOp::Compress) out += compress_store(scratch + out, x > one, x);
+            else if constexpr (Op == SimdOp::HorizontalAdd) scalar += reduce_add(x);
+        }
+    }
+
+    if constexpr (Op == SimdOp::Compress) {
+        return static_cast<float>(out) + (out != 0 ? scratch[out - 1] : 0.0f);
+    }
+    return reduce_add((acc[0] + acc[1]) + (acc[2] + acc[3])) + scalar;
+}
+
+template <typename V>
+float simd_op(SimdOp op, const float* data, const int32_t* indices, float* scratch, size_t n) {
+    switch (op) {
+    case SimdOp::Add: return simd_op_loop<V, SimdOp::Add>(data, indices, scratch, n);
+    case SimdOp::Mul: return simd_op_loop<V, SimdOp::Mul>(data, indices, scratch, n);
+    case SimdOp::Div: return simd_op_loop<V, SimdOp::Div>(data, indices, scratch, n);
+    case SimdOp::Sqrt: return simd_op_loop<V, SimdOp::Sqrt>(data, indices, scratch, n);
+    case SimdOp::Fma: return simd_op_loop<V, SimdOp::Fma>(data, indices, scratch, n);
+    case SimdOp::Min: return simd_op_loop<V, SimdOp::Min>(data, indices, scratch, n);
+    case SimdOp::Max: return simd_op_loop<V, SimdOp::Max>(data, indices, scratch, n);
+    case SimdOp::Gather: return simd_op_loop<V, SimdOp::Gather>(data, indices, scratch, n);
+    case SimdOp::Compress: return simd_op_loop<V, SimdOp::Compress>(data, indices, scratch, n);
+    case SimdOp::HorizontalAdd: return simd_op_loop<V, SimdOp::HorizontalAdd>(data, indices, scratch, n);
+    case SimdOp::Count: break;
+    }
+    return 0.0f;
+}
+
+// The Wilder recurrence of SOV::ADX, one instrument per lane. The arithmetic follows
+// the scalar version step for step, so the only differences come from the compiler
+// contracting a multiply and add into an FMA, which the AVX2 and AVX-512 builds may
+// do (see ADXLanes in vos_vs_sov.hpp).
+template <typename V>
+AL_DLL_HIDDEN inline void adx_directional_movement(const float* highs, const float* lows, const float* closes,
+                                                   size_t i, V& tr, V& plus_dm, V& minus_dm) {
+    constexpr size_t w = V::width;
+    const V zero = V::zero();
+    const V high = V::loadu(highs + i * w);
+    const V low = V::loadu(lows + i * w);
+    const V prev_high = V::loadu(highs + (i - 1) * w);
+    const V prev_low = V::loadu(lows + (i - 1) * w);
+    const V prev_close = V::loadu(closes + (i - 1) * w);
+
+    const V high_gap = high - prev_close;
+    const V low_gap = low - prev_close;
+    tr = max(max(high - low, max(high_gap, zero - high_gap)), max(low_gap, zero - low_gap));
+
+    const V up = high - prev_high;
+    const V down = prev_low - low;
+    plus_dm = select((up > down) & (up > zero), up, zero);
+    minus_dm = select((down > up) & (down > zero), down, zero);
+}
+
+template <typename V>
+void adx_lanes(const float* highs, const float* lows, const float* closes, size_t bars, size_t period, float* out) {
+    const V zero = V::zero();
+    if (bars <= period) {
+        zero.storeu(out);
+        return;
+    }
+
+    const V hundred = V::broadcast(100.0f);
+    const V n = V::broadcast(static_cast<float>(period));
+    const V n_minus_1 = V::broadcast(static_cast<float>(period - 1));
+    V smoothed_tr = zero, smoothed_plus_dm = zero, smoothed_minus_dm = zero;
+    V tr, plus_dm, minus_dm;
+
+    for (size_t i = 1; i <= period; ++i) {
+        adx_directional_movement(highs, lows, closes, i, tr, plus_dm, minus_dm);
+        smoothed_tr += tr;
+        smoothed_plus_dm += plus_dm;
+        smoothed_minus_dm += minus_dm;
+    }
+    smoothed_tr = smoothed_tr / n;
+    smoothed_plus_dm = smoothed_plus_dm / n;
+    smoothed_minus_dm = smoothed_minus_dm / n;
+
+    V plus_di = hundred * (smoothed_plus_dm / smoothed_tr);
+    V minus_di = hundred * (smoothed_minus_dm / smoothed_tr);
+    V di_diff = plus_di - minus_di;
+    V adx = hundred * max(di_diff, zero - di_diff) / (plus_di + minus_di);
+
+    for (size_t i = period + 1; i < bars; ++i) {
+        adx_directional_movement(highs, lows, closes, i, tr, plus_dm, minus_dm);
+        smoothed_tr = (smoothed_tr * n_minus_1 + tr) / n;
+        smoothed_plus_dm = (smoothed_plus_dm * n_minus_1 + plus_dm) / n;
+        smoothed_minus_dm = (smoothed_minus_dm * n_minus_1 + minus_dm) / n;
+
+        plus_di = hundred * (smoothed_plus_dm / smoothed_tr);
+        minus_di = hundred * (smoothed_minus_dm / smoothed_tr);
+        di_diff = plus_di - minus_di;
+        const V dx = hundred * max(di_diff, zero - di_diff) / (plus_di + minus_di);
+        adx = (adx * n_minus_1 + dx) / n;
+    }
+    adx.storeu(out);
+}
+
+// adx_lanes on int64 tick prices, with the fixed-point arithmetic of fixed::ADX:
+// smoothed values in Q8, divisions by the period as a multiply by a reciprocal and a
+// rounding shift, and DX as one correctly rounded double division. Every lane
+// matches fixed::ADX bit for bit. Only the constants come from fixed_point.hpp; its
+// inline functions would otherwise be built here with this file's -m flags (see
+// simd_kernels.hpp).
+template <typename V>
+AL_DLL_HIDDEN inline void adx_directional_movement_ticks(const int64_t* highs, const int64_t* lows, const int64_t* closes,
+                                                         size_t i, V& tr, V& plus_dm, V& minus_dm) {
+    constexpr size_t w = V::width;
+    const V zero = V::zero();
+    const V high = V::loadu(highs + i * w);
+    const V low = V::loadu(lows + i * w);
+    const V prev_high = V::loadu(highs + (i - 1) * w);
+    const V prev_low = V::loadu(lows + (i - 1) * w);
+    const V prev_close = V::loadu(closes + (i - 1) * w);
+
+    const V high_gap = high - prev_close;
+    const V low_gap = low - prev_close;
+    tr = max(max(high - low, max(high_gap, zero - high_gap)), max(low_gap, zero - low_gap));
+
+    const V up = high - prev_high;
+    const V down = prev_low - low;
+    plus_dm = select((up > down) & (up > zero), up, zero);
+    minus_dm = select((down > up) & (down > zero), down, zero);
+}
+
+template <typename V>
+AL_DLL_HIDDEN inline V divide_by_period(const V x, const V recip) {
+    return shift_right(x * recip + V::broadcast(int64_t(1) << (fixed::reciprocal_bits - 1)), fixed::reciprocal_bits);
+}
+
+template <typename V>
+AL_DLL_HIDDEN inline V fixed_dx(const V plus, const V minus) {
+    using D = simd::Vec<double, V::width>;
+    const V zero = V::zero();
+    const V sum = plus + minus;
+    const V diff = max(plus - minus, minus - plus);
+    const D ratio = to_double(diff * V::broadcast(fixed::hundred)) / to_double(sum);
+    return select(sum == zero, zero, to_int64(ratio));
+}
+
+template <typename V>
+void adx_lanes_ticks(const int64_t* highs, const int64_t* lows, const int64_t* closes, size_t bars, size_t period, float* out) {
+    constexpr int w = V::width;
+    if (bars <= period) {
+        for (int j = 0; j < w; ++j) out[j] = 0.0f;
+        return;
+    }
+
+    const V recip = V::broadcast(((int64_t(1) << fixed::reciprocal_bits) + static_cast<int64_t>(period / 2)) / static_cast<int64_t>(period));
+    const V n_minus_1 = V::broadcast(static_cast<int64_t>(period - 1));
+    V smoothed_tr = V::zero(), smoothed_plus_dm = V::zero(), smoothed_minus_dm = V::zero();
+    V tr, plus_dm, minus_dm;
+
+    for (size_t i = 1; i <= period; ++i) {
+        adx_directional_movement_ticks(highs, lows, closes, i, tr, plus_dm, minus_dm);
+        smoothed_tr += tr;
+        smoothed_plus_dm += plus_dm;
+        smoothed_minus_dm += minus_dm;
+    }
+    smoothed_tr = divide_by_period(shift_left(smoothed_tr, fixed::fraction_bits), recip);
+    smoothed_plus_dm = divide_by_period(shift_left(smoothed_plus_dm, fixed::fraction_bits), recip);
+    smoothed_minus_dm = divide_by_period(shift_left(smoothed_minus_dm, fixed::fraction_bits), recip);
+    V adx = fixed_dx(smoothed_plus_dm, smoothed_minus_dm);
+
+    for (size_t i = period + 1; i < bars; ++i) {
+        adx_directional_movement_ticks(highs, lows, closes, i, tr, plus_dm, minus_dm);
+        smoothed_tr = divide_by_period(smoothed_tr * n_minus_1 + shift_left(tr, fixed::fraction_bits), recip);
+        smoothed_plus_dm = divide_by_period(smoothed_plus_dm * n_minus_1 + shift_left(plus_dm, fixed::fraction_bits), recip);
+        smoothed_minus_dm = divide_by_period(smoothed_minus_dm * n_minus_1 + shift_left(minus_dm, fixed::fraction_bits), recip);
+        adx = divide_by_period(adx * n_minus_1 + fixed_dx(smoothed_plus_dm, smoothed_minus_dm), recip);
+    }
+
+    int64_t lanes[w];
+    adx.storeu(lanes);
+    for (int j = 0; j < w; ++j) {
+        out[j] = static_cast<float>(lanes[j]) * (1.0f / (1 << fixed::fraction_bits));
+    }
+}
+
+// Linear scan, one vector of levels per step. For the shallow books most updates hit,
+// this beats a binary search: no unpredictable branches, and the answer usually sits
+// in the first vector. The last, partial vector is loaded with load_partial; its
+// zeroed lanes come after the real ones, so clamping to the count is enough.
+template <typename V>
+size_t lower_bound_i32(const int32_t* levels, size_t n, int32_t value) {
+    constexpr size_t width = V::width;
+    size_t i = 0;
+    for (; i + width <= n; i += width) {
+        const int index = lower_bound(V::loadu(levels + i), value);
+        if (index != static_cast<int>(width)) return i + index;
+    }
+    if (i == n) return n;
+    const size_t index = static_cast<size_t>(lower_bound(V::load_partial(levels + i, n - i), value));
+    return i + (index < n - i ? index : n - i);
+}
+
+// Every limit but the position is checked on every lane, with no branch on the
+// outcome. A failed compare selects its check's flag (zero when the check is
+// disabled), and a lane's flags are summed, which is their OR as each is a different
+// bit. Flags fit in a byte, so multiplying lane j by 2^(8j) and adding the lanes packs
+// the vector's flags into one integer for a single store.
+//
+// The position check depends on which earlier orders were accepted, so it can't be
+// done across lanes. When no lane failed another check and the position would stay
+// within max_position even if every order went the same way, the whole vector is
+// accepted at once. Sizes are capped at max_position + 1 for that sum, so it can't
+// wrap. Otherwise the lanes are walked in order, each moving the position
+// only if it passes.
+//
+// The notional is compared in double, which simd::Vec converts to only from
+// [0, 2^52), so the size and price are first clamped to [0, max_notional + 1]. That
+// changes no outcome, and as max_notional and max_notional + 1 are both exact
+// doubles, the rounded product is above max_notional exactly when the product is.
+template <typename V>
+uint8_t risk_check(const int64_t* prices, const int64_t* quantities, size_t n,
+                   const RiskLimits& limits, RiskState& state, uint8_t* errors) {
+    using D = decltype(to_double(V::zero()));
+    constexpr int w = V::width;
+    const V zero = V::zero();
+    const V max_quantity = V::broadcast(limits.max_quantity);
+    const V reference_price = V::broadcast(limits.reference_price);
+    const V price_band = V::broadcast(limits.price_band);
+    const V notional_cap = V::broadcast(limits.max_notional + 1);
+    const D max_notional = D::broadcast(static_cast<double>(limits.max_notional));
+    const V max_orders = V::broadcast(limits.max_orders);
+    const V quantity_flag = V::broadcast(limits.enabled & QuantityError);
+    const V price_band_flag = V::broadcast(limits.enabled & PriceBandError);
+    const D notional_flag = D::broadcast(limits.enabled & NotionalError);
+    const V rate_flag = V::broadcast(limits.enabled & RateError);
+    const uint64_t position_flag = limits.enabled & PositionError;
+    const V size_cap = V::broadcast(limits.max_position + 1);
+
+    int64_t lane_numbers[w], byte_places[w];
+    for (int j = 0; j < w; ++j) {
+        lane_numbers[j] = j + 1;
+        byte_places[j] = int64_t(1) << (8 * j);
+    }
+    const V lane_number = V::loadu(lane_numbers);
+    const V byte_place = V::loadu(byte_places);
+
+    const int64_t orders_sent = state.orders_sent;
+    int64_t position = state.position;
+    uint64_t seen = 0;
+    size_t i = 0;
+    auto check = [&](const V price, const V size) {
+        const V offset = price - reference_price;
+        const V order_number = V::broadcast(orders_sent + static_cast<int64_t>(i)) + lane_number;
+        const D notional = to_double(min(size, notional_cap)) * to_double(min(max(price, zero), notional_cap));
+        const V flags = select((size == zero) | (size > max_quantity), quantity_flag, zero)
+                      + select(max(offset, zero - offset) > price_band, price_band_flag, zero)
+                      + to_int64(select(notional > max_notional, notional_flag, D::zero()))
+                      + select(order_number > max_orders, rate_flag, zero);
+        return static_cast<uint64_t>(reduce_add(flags * byte_place));
+    };
+    // Adds the position check to the packed flags of orders [i, i + count), moving
+    // position by each order that passes.
+    auto settle = [&](uint64_t packed, const V quantity, const V size, size_t count) {
+        const int64_t headroom = limits.max_position - (position < 0 ? -position : position);
+        if (packed == 0 && (position_flag == 0 || reduce_add(min(size, size_cap)) <= headroom)) {
+            position += reduce_add(quantity);
+            return packed;
+        }
+        uint64_t settled = 0;
+        for (size_t j = 0; j < count; ++j) {
+            const int64_t new_position = position + quantities[i + j];
+            const bool too_large = (new_position < 0 ? -new_position : new_position) > limits.max_position;
+            const uint64_t flags = ((packed >> (8 * j)) & 0xff) | (too_large ? position_flag : 0);
+            position = flags == 0 ? new_position : position;
+            settled |= flags << (8 * j);
+        }
+        return settled;
+    };
+
+    for (; i + w <= n; i += w) {
+        const V quantity = V::loadu(quantities + i);
+        const V size = max(quantity, zero - quantity);
+        const uint64_t packed = settle(check(V::loadu(prices + i), size), quantity, size, w);
+        memcpy(errors + i, &packed, w);
+        seen |= packed;
+    }
+    if (i < n) {
+        const size_t count = n - i;
+        // The lanes past count hold zero quantities, which fail; their flags are
+        // dropped before the position check.
+        const V quantity = V::load_partial(quantities + i, count);
+        const V size = max(quantity, zero - quantity);
+        const uint64_t mask = (uint64_t(1) << (8 * count)) - 1;
+        const uint64_t packed = settle(check(V::load_partial(prices + i, count), size) & mask, quantity, size, count);
+        memcpy(errors + i, &packed, count);
+        seen |= packed;
+    }
+
+    state.position = position;
+    state.orders_sent = orders_sent + static_cast<int64_t>(n);
+    uint8_t result = 0;
+    for (int j = 0; j < w; ++j) result |= static_cast<uint8_t>(seen >> (8 * j));
+    return result;
+}
+
+}
+}
@@ -0,0 +1,106 @@
+#include "simd_kernels_impl.hpp"
+
+
+namespace simd_kernels::sse2 {
+
+static_assert(simd::native_width<float> == 4, "simd_kernels_sse2.cpp built with the wrong -m flags");
+
+namespace {
+
+// Hand-written intrinsics, kept to show the simd::Vec versions cost nothing extra.
+
+void add_arrays_intrinsics(const float* a, const float* b, float* c, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        storeu4f(c + i, add4f(loadu4f(a + i), loadu4f(b + i)));
+    }
+    for (; i < n; ++i) {
+        c[i] = a[i] + b[i];
+    }
+}
+
+// Sign-extends v to int64 and adds the halves into lo and hi.
+inline void accumulate(i128& lo, i128& hi, const i128 v) {
+    lo = add2i64(lo, widenlo4i32_to_2i64(v));
+    hi = add2i64(hi, widenhi4i32_to_2i64(v));
+}
+
+// Four int64 accumulators, reduced to a scalar once at the end.
+int64_t sum_i32_intrinsics(const int32_t* data, size_t n, size_t prefetch_distance) {
+    constexpr size_t stride = 16;
+    i128 acc0 = zero4i(), acc1 = zero4i(), acc2 = zero4i(), acc3 = zero4i();
+    auto block = [&](const int32_t* p) {
+        accumulate(acc0, acc1, loadu4i(p));
+        accumulate(acc2, acc3, loadu4i(p + 4));
+        accumulate(acc0, acc1, loadu4i(p + 8));
+        accumulate(acc2, acc3, loadu4i(p + 12));
+    };
+    size_t i = 0;
+    if (prefetch_distance != 0 && n > prefetch_distance) {
+        for (; i + stride <= n - prefetch_distance; i += stride) {
+            _mm_prefetch(reinterpret_cast<const char*>(data + i + prefetch_distance), _MM_HINT_T0);
+            block(data + i);
+        }
+    }
+    for (; i + stride <= n; i += stride) {
+        block(data + i);
+    }
+    int64_t sum = first2i64(hadd2i64(add2i64(add2i64(acc0, acc1), add2i64(acc2, acc3))));
+    for (; i < n; ++i) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+}
+
+extern const KernelTable table = {
+    Isa::SSE2,
+    "sse2",
+    simd::native_width<float>,
+    add_arrays<simd::Native<float>>,
+    sum_i32<simd::Native<int32_t>>,
+    add_arrays_intrinsics,
+    sum_i32_intrinsics,
+    simd_op<simd::Native<float>>,
+    adx_lanes<simd::Native<float>>,
+    {
+        reduce<WideSumOp<simd::Native<int32_t>>>,
+        reduce<WideSumSquaresOp<simd::Native<int32_t>>>,
+        reduce<MinOp<simd::Native<int32_t>>>,
+        reduce<MaxOp<simd::Native<int32_t>>>,
+        argmin<simd::Native<int32_t>>,
+        argmax<simd::Native<int32_t>>,
+    },
+    {
+        reduce<SumOp<simd::Native<int64_t>>>,
+        reduce<SumSquaresOp<simd::Native<int64_t>>>,
+        reduce<MinOp<simd::Native<int64_t>>>,
+        reduce<MaxOp<simd::Native<int64_t>>>,
+        argmin<simd::Native<int64_t>>,
+        argmax<simd::Native<int64_t>>,
+    },
+    {
+        reduce<SumOp<simd::Native<float>>>,
+        reduce<SumSquaresOp<simd::Native<float>>>,
+        reduce<MinOp<simd::Native<float>>>,
+        reduce<MaxOp<simd::Native<float>>>,
+        argmin<simd::Native<float>>,
+        argmax<simd::Native<float>>,
+    },
+    {
+        reduce<SumOp<simd::Native<double>>>,
+        reduce<SumSquaresOp<simd::Native<double>>>,
+        reduce<MinOp<simd::Native<double>>>,
+        reduce<MaxOp<simd::Native<double>>>,
+        argmin<simd::Native<double>>,
+        argmax<simd::Native<double>>,
+    },
+    fix_split<simd::Native<int8_t>>,
+    parse_ticks,
+    lower_bound_i32<simd::Native<int32_t>>,
+    adx_lanes_ticks<simd::Native<int64_t>>,
+    risk_check<simd::Native<int64_t>>,
+};
+
+}
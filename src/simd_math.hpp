@@ -1,6 +1,12 @@
 #pragma once
 #include <benchmark/benchmark.h>
-#include <emmintrin.h>
+#include "alloc_counter.hpp"
+#include "aligned_buffer.hpp"
+#include "simd_dispatch.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 const int size = 100000;
 
@@ -11,55 +17,128 @@ void add_arrays(float* a, float* b, float* c, int size) {
 }
 
 
-void add_arrays_simd(float* a, float* b, float* c, int size) {
-    __m128 a_chunk, b_chunk, c_chunk;
+namespace simd_math {
+
+// Element counts from 1 to past the last level cache, as (isa, n, huge pages). The
+// small sizes sit either side of one and two vector widths for each ISA, which shows
+// the cost of the masked tail. After that the size grows 4x per step. Huge pages are
+// only tried with the widest ISA, once the arrays are past L2 and each is at least one
+// huge page. This keeps the family well under the library's 100-input limit.
+inline void sweep_args(benchmark::internal::Benchmark* b) {
+    using simd_kernels::Isa;
+    std::size_t l2 = 0;
+    std::size_t last_level_cache = 0;
+    for (const auto& cache : benchmark::CPUInfo::Get().caches) {
+        if (cache.level == 2) {
+            l2 = std::max(l2, static_cast<std::size_t>(cache.size));
+        }
+        last_level_cache = std::max(last_level_cache, static_cast<std::size_t>(cache.size));
+    }
+    // Two arrays read and one written; go to 4x the last level cache, capped at 1GB.
+    const std::size_t max_bytes = std::min<std::size_t>(std::max<std::size_t>(4 * last_level_cache, 64 << 20), std::size_t(1) << 30);
+    const std::size_t max_n = max_bytes / (3 * sizeof(float));
+    const std::size_t l2_n = std::max<std::size_t>(l2, 256 << 10) / (3 * sizeof(float));
+
+    std::vector<std::size_t> sizes = {1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 33};
+    for (std::size_t n = 64; n <= max_n; n *= 4) {
+        sizes.push_back(n);
+    }
+
+    Isa widest = Isa::SSE2;
+    for (Isa isa : {Isa::AVX2, Isa::AVX512}) {
+        if (simd_kernels::supported(isa)) widest = isa;
+    }
+
+    b->ArgNames({"isa", "n", "huge"});
+    for (Isa isa : {Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        if (!simd_kernels::supported(isa)) continue;
+        for (std::size_t n : sizes) {
+            b->Args({static_cast<int>(isa), static_cast<int64_t>(n), 0});
+            if (isa == widest && n > l2_n && n * sizeof(float) >= AlignedBuffer<float>::huge_page_size) {
+                b->Args({static_cast<int>(isa), static_cast<int64_t>(n), 1});
+            }
+        }
+    }
+}
 
-    for (int i=0; i < size; i+=4) {
-        a_chunk = _mm_loadu_ps(&a[i]);
-        b_chunk = _mm_loadu_ps(&b[i]);
-        c_chunk = _mm_add_ps(a_chunk, b_chunk);
-        _mm_storeu_ps(&c[i], c_chunk);
+inline void fill(AlignedBuffer<float>& buffer, float seed) {
+    for (std::size_t i = 0; i < buffer.size(); ++i) {
+        buffer[i] = seed + static_cast<float>(i % 1024) * 0.25f;
     }
 }
 
+}
 
 
-class SIMDBenchmark : public benchmark::Fixture {
+class SIMDBenchmark : public AllocCountingFixture {
 public:
     void SetUp(const ::benchmark::State& state) override {
-
+        a = AlignedBuffer<float>(size);
+        b = AlignedBuffer<float>(size);
+        c = AlignedBuffer<float>(size);
+        simd_math::fill(a, 1.0f);
+        simd_math::fill(b, 2.0f);
     }
 
     void TearDown(const ::benchmark::State& state) override {
 
     }
+
+    AlignedBuffer<float> a, b, c;
 };
 
 
 BENCHMARK_F(SIMDBenchmark, BM_AddArray)(benchmark::State& state) {
-    float* a = new float[size];
-    float* b = new float[size];
-    float* c = new float[size];
-
-    for (auto _ : state) {
-        add_arrays(a, b, c, size);
+    for (auto _ : alloc_counter::counted(state)) {
+        add_arrays(a.data(), b.data(), c.data(), size);
+        benchmark::ClobberMemory();
     }
-
-    delete[] a;
-    delete[] b;
-    delete[] c;
+    state.SetBytesProcessed(state.iterations() * int64_t(size) * 3 * sizeof(float));
 }
 
-BENCHMARK_F(SIMDBenchmark, BM_AddArraySIMD)(benchmark::State& state) {
-    float* a = new float[size];
-    float* b = new float[size];
-    float* c = new float[size];
+BENCHMARK_DEFINE_F(SIMDBenchmark, BM_AddArraySIMD)(benchmark::State& state) {
+    const simd_kernels::KernelTable& kernels = simd_kernels::table_for(state);
 
-    for (auto _ : state) {
-        add_arrays_simd(a, b, c, size);
+    for (auto _ : alloc_counter::counted(state)) {
+        kernels.add_arrays(a.data(), b.data(), c.data(), size);
+        benchmark::ClobberMemory();
     }
+    state.SetBytesProcessed(state.iterations() * int64_t(size) * 3 * sizeof(float));
+    state.SetLabel(kernels.name);
+}
+BENCHMARK_REGISTER_F(SIMDBenchmark, BM_AddArraySIMD)->Apply(simd_kernels::supported_isa_args);
 
-    delete[] a;
-    delete[] b;
-    delete[] c;
-}
\ No newline at end of file
+BENCHMARK_DEFINE_F(SIMDBenchmark, BM_AddArrayIntrinsics)(benchmark::State& state) {
+    const simd_kernels::KernelTable& kernels = simd_kernels::table_for(state);
+
+    for (auto _ : alloc_counter::counted(state)) {
+        kernels.add_arrays_intrinsics(a.data(), b.data(), c.data(), size);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * int64_t(size) * 3 * sizeof(float));
+    state.SetLabel(kernels.name);
+}
+BENCHMARK_REGISTER_F(SIMDBenchmark, BM_AddArrayIntrinsics)->Apply(simd_kernels::supported_isa_args);
+
+// c = a + b at every size in simd_math::sweep_args. bytes_per_second counts both reads
+// and the write, so the plateaus line up with L1, L2, L3 and DRAM bandwidth.
+BENCHMARK_DEFINE_F(SIMDBenchmark, BM_AddArraySweep)(benchmark::State& state) {
+    const simd_kernels::KernelTable& kernels = simd_kernels::table_for(state);
+    const auto n = static_cast<std::size_t>(state.range(1));
+    const PageSize pages = state.range(2) != 0 ? PageSize::Huge : PageSize::Default;
+    AlignedBuffer<float> x(n, pages), y(n, pages), z(n, pages);
+    simd_math::fill(x, 1.0f);
+    simd_math::fill(y, 2.0f);
+
+    for (auto _ : alloc_counter::counted(state)) {
+        kernels.add_arrays(x.data(), y.data(), z.data(), n);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(n * 3 * sizeof(float)));
+    std::string label = kernels.name;
+    if (pages == PageSize::Huge) {
+        label += x.huge_pages() ? "/hugetlb" : "/thp";
+    }
+    state.SetLabel(label);
+}
+BENCHMARK_REGISTER_F(SIMDBenchmark, BM_AddArraySweep)->Apply(simd_math::sweep_args);
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <float.h>
+#include <type_traits>
+#include "simd_kernels.hpp"
+#include "simd_vec.hpp"
+
+
+// Reduction kernels behind KernelTable::reduce_*. Like simd_kernels_impl.hpp, this is
+// only included from simd_kernels_*.cpp, which instantiate it at their native width.
+//
+// Every loop keeps four independent vector accumulators so that consecutive adds (or
+// mins) do not wait on each other, and reduces horizontally once, at the end. int32
+// inputs are sign-extended and accumulated in int64 lanes, so the sum cannot overflow
+// for any n that fits in memory.
+namespace simd_kernels {
+namespace {
+
+template <typename T> struct ReduceLimits;
+template <> struct ReduceLimits<int32_t> { static constexpr int32_t lowest = INT32_MIN, highest = INT32_MAX; };
+template <> struct ReduceLimits<int64_t> { static constexpr int64_t lowest = INT64_MIN, highest = INT64_MAX; };
+template <> struct ReduceLimits<float> { static constexpr float lowest = -FLT_MAX, highest = FLT_MAX; };
+template <> struct ReduceLimits<double> { static constexpr double lowest = -DBL_MAX, highest = DBL_MAX; };
+
+
+// Each Op describes one reduction over vectors of type In:
+//   Acc init()                    starting accumulator
+//   void step(Acc&, In)           fold in one vector
+//   Acc combine(Acc, Acc)         merge two accumulators
+//   R finish(Acc)                 horizontal reduction
+//   R scalar(R, T)                fold in one tail element
+template <typename Op, typename T>
+auto reduce_loop(const T* data, size_t n, size_t prefetch_distance = 0) {
+    using In = typename Op::In;
+    using Acc = typename Op::Acc;
+    constexpr size_t width = In::width;
+    constexpr size_t unroll = 4 * width;
+    constexpr size_t line = 64 / sizeof(T);
+
+    Acc acc[4] = {Op::init(), Op::init(), Op::init(), Op::init()};
+    size_t i = 0;
+    if (prefetch_distance != 0 && n > prefetch_distance) {
+        for (; i + unroll <= n - prefetch_distance; i += unroll) {
+            for (size_t k = 0; k < unroll; k += line) {
+                _mm_prefetch(reinterpret_cast<const char*>(data + i + k + prefetch_distance), _MM_HINT_T0);
+            }
+            for (size_t j = 0; j < 4; ++j) {
+                Op::step(acc[j], In::loadu(data + i + j * width));
+            }
+        }
+    }
+    for (; i + unroll <= n; i += unroll) {
+        for (size_t j = 0; j < 4; ++j) {
+            Op::step(acc[j], In::loadu(data + i + j * width));
+        }
+    }
+    for (; i + width <= n; i += width) {
+        Op::step(acc[0], In::loadu(data + i));
+    }
+
+    auto result = Op::finish(Op::combine(Op::combine(acc[0], acc[1]), Op::combine(acc[2], acc[3])));
+    for (; i < n; ++i) {
+        result = Op::scalar(result, data[i]);
+    }
+    return result;
+}
+
+
+template <typename V>
+struct SumOp {
+    using T = typename V::value_type;
+    using In = V;
+    using Acc = V;
+    static Acc init() { return V::zero(); }
+    static void step(Acc& acc, const In x) { acc += x; }
+    static Acc combine(const Acc a, const Acc b) { return a + b; }
+    static T finish(const Acc acc) { return reduce_add(acc); }
+    static T scalar(const T r, const T x) { return r + x; }
+};
+
+template <typename V>
+struct SumSquaresOp : SumOp<V> {
+    using Acc = V;
+    static void step(Acc& acc, const V x) {
+        if constexpr (std::is_floating_point_v<typename V::value_type>) {
+            acc = fmadd(x, x, acc);
+        } else {
+            acc += x * x;
+        }
+    }
+    static typename V::value_type scalar(const typename V::value_type r, const typename V::value_type x) {
+        if constexpr (std::is_floating_point_v<typename V::value_type>) {
+            return r + x * x;
+        } else {
+            return static_cast<int64_t>(static_cast<uint64_t>(r) + static_cast<uint64_t>(x) * static_cast<uint64_t>(x));
+        }
+    }
+};
+
+template <typename V>
+struct MinOp {
+    using T = typename V::value_type;
+    using In = V;
+    using Acc = V;
+    static Acc init() { return V::broadcast(ReduceLimits<T>::highest); }
+    static void step(Acc& acc, const In x) { acc = min(acc, x); }
+    static Acc combine(const Acc a, const Acc b) { return min(a, b); }
+    static T finish(const Acc acc) { return reduce_min(acc); }
+    static T scalar(const T r, const T x) { return x < r ? x : r; }
+};
+
+template <typename V>
+struct MaxOp {
+    using T = typename V::value_type;
+    using In = V;
+    using Acc = V;
+    static Acc init() { return V::broadcast(ReduceLimits<T>::lowest); }
+    static void step(Acc& acc, const In x) { acc = max(acc, x); }
+    static Acc combine(const Acc a, const Acc b) { return max(a, b); }
+    static T finish(const Acc acc) { return reduce_max(acc); }
+    static T scalar(const T r, const T x) { return x > r ? x : r; }
+};
+
+
+// int32 in, int64 out: each input vector is split into two sign-extended halves.
+template <typename V>
+struct WideAcc {
+    simd::Vec<int64_t, V::width / 2> lo, hi;
+};
+
+template <typename V>
+struct WideSumOp {
+    using In = V;
+    using Acc = WideAcc<V>;
+    using Wide = simd::Vec<int64_t, V::width / 2>;
+    static Acc init() { return {Wide::zero(), Wide::zero()}; }
+    static void step(Acc& acc, const In x) {
+        acc.lo += widen_lo(x);
+        acc.hi += widen_hi(x);
+    }
+    static Acc combine(const Acc a, const Acc b) { return {a.lo + b.lo, a.hi + b.hi}; }
+    static int64_t finish(const Acc acc) { return reduce_add(acc.lo + acc.hi); }
+    static int64_t scalar(const int64_t r, const int32_t x) { return r + x; }
+};
+
+template <typename V>
+struct WideSumSquaresOp : WideSumOp<V> {
+    using Acc = WideAcc<V>;
+    static void step(Acc& acc, const V x) {
+        const auto lo = widen_lo(x);
+        const auto hi = widen_hi(x);
+        acc.lo += lo * lo;
+        acc.hi += hi * hi;
+    }
+    static int64_t scalar(const int64_t r, const int32_t x) { return r + static_cast<int64_t>(x) * x; }
+};
+
+
+// Position of the first element equal to target, or n.
+template <typename V>
+size_t find_first(const typename V::value_type* data, size_t n, const typename V::value_type target) {
+    constexpr size_t width = V::width;
+    const V t = V::broadcast(target);
+    size_t i = 0;
+    for (; i + 4 * width <= n; i += 4 * width) {
+        const auto m0 = V::loadu(data + i) == t;
+        const auto m1 = V::loadu(data + i + width) == t;
+        const auto m2 = V::loadu(data + i + 2 * width) == t;
+        const auto m3 = V::loadu(data + i + 3 * width) == t;
+        if (any((m0 | m1) | (m2 | m3))) {
+            if (any(m0)) return i + ctz32(m0.bits());
+            if (any(m1)) return i + width + ctz32(m1.bits());
+            if (any(m2)) return i + 2 * width + ctz32(m2.bits());
+            return i + 3 * width + ctz32(m3.bits());
+        }
+    }
+    for (; i < n; ++i) {
+        if (data[i] == target) return i;
+    }
+    return n;
+}
+
+// argmin/argmax find the extreme value first and then its first position, which
+// gives std::min_element/std::max_element semantics. NaNs give unspecified results.
+template <typename V>
+size_t argmin(const typename V::value_type* data, size_t n) {
+    if (n == 0) return 0;
+    return find_first<V>(data, n, reduce_loop<MinOp<V>>(data, n));
+}
+
+template <typename V>
+size_t argmax(const typename V::value_type* data, size_t n) {
+    if (n == 0) return 0;
+    return find_first<V>(data, n, reduce_loop<MaxOp<V>>(data, n));
+}
+
+
+template <typename Op>
+auto reduce(const typename Op::In::value_type* data, size_t n) {
+    return reduce_loop<Op>(data, n);
+}
+
+}
+}
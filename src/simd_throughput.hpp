@@ -0,0 +1,85 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "simd_dispatch.hpp"
+#include <random>
+#include <string>
+#include <vector>
+
+
+// Per-operation throughput of the simd::Vec layer at each instruction set the host
+// supports. items_per_second counts floats, so the widths compare directly.
+namespace simd_throughput {
+
+inline const char* op_name(simd_kernels::SimdOp op) {
+    switch (op) {
+    case simd_kernels::SimdOp::Add: return "add";
+    case simd_kernels::SimdOp::Mul: return "mul";
+    case simd_kernels::SimdOp::Div: return "div";
+    case simd_kernels::SimdOp::Sqrt: return "sqrt";
+    case simd_kernels::SimdOp::Fma: return "fma";
+    case simd_kernels::SimdOp::Min: return "min";
+    case simd_kernels::SimdOp::Max: return "max";
+    case simd_kernels::SimdOp::Gather: return "gather";
+    case simd_kernels::SimdOp::Compress: return "compress";
+    case simd_kernels::SimdOp::HorizontalAdd: return "hadd";
+    case simd_kernels::SimdOp::Count: break;
+    }
+    return "?";
+}
+
+// Every op crossed with every supported instruction set, as (op, isa).
+inline void op_isa_args(benchmark::internal::Benchmark* b) {
+    using simd_kernels::Isa;
+    b->ArgNames({"op", "isa"});
+    for (int op = 0; op < static_cast<int>(simd_kernels::SimdOp::Count); ++op) {
+        for (Isa isa : {Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+            if (simd_kernels::supported(isa)) {
+                b->Args({op, static_cast<int>(isa)});
+            }
+        }
+    }
+}
+
+}
+
+
+class SIMDThroughputBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> value(0.999f, 1.001f);
+        std::uniform_int_distribution<int32_t> index(0, static_cast<int32_t>(size) - 1);
+        data.resize(size);
+        indices.resize(size);
+        scratch.resize(size + 16);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = value(rng);
+            indices[i] = index(rng);
+        }
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    // 16KB of floats, so everything stays in L1.
+    static constexpr size_t size = 4096;
+    std::vector<float> data;
+    std::vector<int32_t> indices;
+    std::vector<float> scratch;
+};
+
+
+BENCHMARK_DEFINE_F(SIMDThroughputBenchmark, BM_SIMDOp)(benchmark::State& state) {
+    const auto op = static_cast<simd_kernels::SimdOp>(state.range(0));
+    const simd_kernels::KernelTable& kernels = simd_kernels::table(static_cast<simd_kernels::Isa>(state.range(1)));
+
+    for (auto _ : alloc_counter::counted(state)) {
+        float checksum = kernels.simd_op(op, data.data(), indices.data(), scratch.data(), size);
+        benchmark::DoNotOptimize(checksum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(size));
+    state.SetLabel(std::string(simd_throughput::op_name(op)) + "/" + kernels.name);
+}
+BENCHMARK_REGISTER_F(SIMDThroughputBenchmark, BM_SIMDOp)->Apply(simd_throughput::op_isa_args);
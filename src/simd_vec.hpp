@@ -0,0 +1,780 @@
+#pragma once
+
+#include "simd.hpp"
+
+
+// Width-agnostic front end over the simd.hpp wrappers. Vec<T, N> and Mask<T, N> are
+// specialised for every register type the including translation unit is compiled for,
+// and Native<T> names the widest one. A kernel written against Native<T> therefore
+// compiles to SSE2, AVX2 or AVX-512 depending on the -m flags of the file including it
+// (see simd_kernels_*.cpp).
+//
+// Everything here is AL_DLL_HIDDEN (always inlined) for the same reason as simd.hpp.
+namespace simd {
+
+template <typename T, int N> struct Vec;
+template <typename T, int N> struct Mask;
+
+#if defined(__AVX512F__)
+template <typename T> inline constexpr int native_width = 64 / sizeof(T);
+#elif defined(__AVX2__)
+template <typename T> inline constexpr int native_width = 32 / sizeof(T);
+#else
+template <typename T> inline constexpr int native_width = 16 / sizeof(T);
+#endif
+
+template <typename T> using Native = Vec<T, native_width<T>>;
+
+// Vec<int8_t, N> is for byte scanners and only loads, stores and compares; its mask
+// bits() is 64-bit so that a 64-lane compare fits.
+//
+// Besides load/store, the other Vecs have load_partial(ptr, count) and store_partial(ptr,
+// count), which touch only the first count elements (and zero the rest of the
+// register). They use AVX2 maskload/maskstore or AVX-512 masked moves, so a loop can
+// finish its tail without a scalar remainder and without reading past the end.
+//
+// Every width also provides these free functions (float and int32_t only for gather):
+//
+//   gather(base, indices)   lane i is base[indices[i]]
+//   widen_lo(v), widen_hi(v)
+//                           the low or high half of an int32_t vector, sign-extended
+//                           to a Vec<int64_t, N / 2>
+//   lower_bound(levels, value)
+//                           for an int32_t vector sorted ascending, the index of the
+//                           first lane >= value, or width if there is none
+//   shift_left(v, count), shift_right(v, count)
+//                           int64_t lanes shifted by count bits; shift_right is logical,
+//                           so it divides by 2^count only for non-negative lanes
+//   to_double(v), to_int64(v)
+//                           int64_t <-> double lane by lane, for values in [0, 2^52);
+//                           to_int64 rounds to nearest
+//   compress_store(dst, m, v)
+//                           writes the lanes selected by m to dst, in order, and returns
+//                           how many there were. It may store a whole vector, so dst
+//                           needs room for width elements either way.
+
+namespace detail {
+
+// Partial loads and stores for 128-bit vectors, which have no masked memory access
+// before AVX. They go through a stack copy one element at a time.
+template <typename V>
+AL_DLL_HIDDEN inline V load_partial_lanes(const typename V::value_type* ptr, const size_t count) {
+    typename V::value_type lanes[V::width] = {};
+    for (size_t i = 0; i < count && i < static_cast<size_t>(V::width); ++i) {
+        lanes[i] = ptr[i];
+    }
+    return V::loadu(lanes);
+}
+
+template <typename V>
+AL_DLL_HIDDEN inline void store_partial_lanes(typename V::value_type* ptr, const size_t count, const V v) {
+    typename V::value_type lanes[V::width];
+    v.storeu(lanes);
+    for (size_t i = 0; i < count && i < static_cast<size_t>(V::width); ++i) {
+        ptr[i] = lanes[i];
+    }
+}
+
+// Branch-free fallback for widths without a compress instruction.
+template <typename V>
+AL_DLL_HIDDEN inline int compress_store_lanes(typename V::value_type* dst, const uint32_t bits, const V v) {
+    typename V::value_type lanes[V::width];
+    v.storeu(lanes);
+    int n = 0;
+    for (int i = 0; i < V::width; ++i) {
+        dst[n] = lanes[i];
+        n += (bits >> i) & 1;
+    }
+    return n;
+}
+
+}
+
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+template <> struct Mask<float, 4> {
+    f128 m;
+    AL_DLL_HIDDEN uint32_t bits() const { return static_cast<uint32_t>(movemask4f(m)); }
+    AL_DLL_HIDDEN friend Mask operator&(const Mask a, const Mask b) { return {and4f(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator|(const Mask a, const Mask b) { return {or4f(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator~(const Mask a) { return {andnot4f(a.m, cast4f(cmpeq4i(zero4i(), zero4i())))}; }
+};
+
+template <> struct Mask<int32_t, 4> {
+    i128 m;
+    AL_DLL_HIDDEN uint32_t bits() const { return static_cast<uint32_t>(movemask4i(m)); }
+    AL_DLL_HIDDEN friend Mask operator&(const Mask a, const Mask b) { return {and4i(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator|(const Mask a, const Mask b) { return {or4i(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator~(const Mask a) { return {xor4i(a.m, cmpeq4i(zero4i(), zero4i()))}; }
+};
+
+template <> struct Mask<double, 2> {
+    d128 m;
+    AL_DLL_HIDDEN uint32_t bits() const { return static_cast<uint32_t>(movemask2d(m)); }
+    AL_DLL_HIDDEN friend Mask operator&(const Mask a, const Mask b) { return {and2d(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator|(const Mask a, const Mask b) { return {or2d(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator~(const Mask a) { return {andnot2d(a.m, cast2d(cmpeq4i(zero4i(), zero4i())))}; }
+};
+
+template <> struct Mask<int64_t, 2> {
+    i128 m;
+    AL_DLL_HIDDEN uint32_t bits() const { return static_cast<uint32_t>(movemask2i64(m)); }
+    AL_DLL_HIDDEN friend Mask operator&(const Mask a, const Mask b) { return {and4i(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator|(const Mask a, const Mask b) { return {or4i(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator~(const Mask a) { return {xor4i(a.m, cmpeq4i(zero4i(), zero4i()))}; }
+};
+
+template <> struct Mask<int8_t, 16> {
+    uint32_t m;
+    AL_DLL_HIDDEN uint64_t bits() const { return static_cast<uint32_t>(m); }
+};
+
+template <> struct Vec<int8_t, 16> {
+    using value_type = int8_t;
+    using mask_type = Mask<int8_t, 16>;
+    static constexpr int width = 16;
+    i128 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero4i()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const int8_t x) { return {splat16i8(x)}; }
+    AL_DLL_HIDDEN static Vec loadu(const void* ptr) { return {loadu4i(ptr)}; }
+    AL_DLL_HIDDEN void storeu(void* ptr) const { storeu4i(ptr, v); }
+
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {static_cast<uint32_t>(movemask16i8(cmpeq16i8(a.v, b.v)))}; }
+};
+
+template <> struct Vec<float, 4> {
+    using value_type = float;
+    using mask_type = Mask<float, 4>;
+    static constexpr int width = 4;
+    f128 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero4f()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const float x) { return {splat4f(x)}; }
+    AL_DLL_HIDDEN static Vec load(const float* ptr) { return {load4f(ptr)}; }
+    AL_DLL_HIDDEN static Vec loadu(const float* ptr) { return {loadu4f(ptr)}; }
+    AL_DLL_HIDDEN void store(float* ptr) const { store4f(ptr, v); }
+    AL_DLL_HIDDEN void storeu(float* ptr) const { storeu4f(ptr, v); }
+    AL_DLL_HIDDEN static Vec load_partial(const float* ptr, const size_t count) { return detail::load_partial_lanes<Vec>(ptr, count); }
+    AL_DLL_HIDDEN void store_partial(float* ptr, const size_t count) const { detail::store_partial_lanes(ptr, count, *this); }
+
+    AL_DLL_HIDDEN friend Vec operator+(const Vec a, const Vec b) { return {add4f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator-(const Vec a, const Vec b) { return {sub4f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator*(const Vec a, const Vec b) { return {mul4f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator/(const Vec a, const Vec b) { return {div4f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {cmpeq4f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator!=(const Vec a, const Vec b) { return {cmpne4f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>(const Vec a, const Vec b) { return {cmpgt4f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>=(const Vec a, const Vec b) { return {cmpge4f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<(const Vec a, const Vec b) { return {cmpgt4f(b.v, a.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<=(const Vec a, const Vec b) { return {cmpge4f(b.v, a.v)}; }
+
+    AL_DLL_HIDDEN friend Vec min(const Vec a, const Vec b) { return {min4f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec max(const Vec a, const Vec b) { return {max4f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec select(const mask_type m, const Vec if_true, const Vec if_false) { return {select4f(if_false.v, if_true.v, m.m)}; }
+    AL_DLL_HIDDEN friend Vec sqrt(const Vec a) { return {sqrt4f(a.v)}; }
+    AL_DLL_HIDDEN friend Vec fmadd(const Vec a, const Vec b, const Vec c) { return {fmadd4f(a.v, b.v, c.v)}; }
+    AL_DLL_HIDDEN friend float reduce_add(const Vec a) { return first4f(hadd4f(a.v)); }
+    AL_DLL_HIDDEN friend float reduce_min(const Vec a) { return first4f(hmin4f(a.v)); }
+    AL_DLL_HIDDEN friend float reduce_max(const Vec a) { return first4f(hmax4f(a.v)); }
+};
+
+template <> struct Vec<int32_t, 4> {
+    using value_type = int32_t;
+    using mask_type = Mask<int32_t, 4>;
+    static constexpr int width = 4;
+    i128 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero4i()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const int32_t x) { return {splat4i(x)}; }
+    AL_DLL_HIDDEN static Vec load(const int32_t* ptr) { return {load4i(ptr)}; }
+    AL_DLL_HIDDEN static Vec loadu(const int32_t* ptr) { return {loadu4i(ptr)}; }
+    AL_DLL_HIDDEN void store(int32_t* ptr) const { store4i(ptr, v); }
+    AL_DLL_HIDDEN void storeu(int32_t* ptr) const { storeu4i(ptr, v); }
+    AL_DLL_HIDDEN static Vec load_partial(const int32_t* ptr, const size_t count) { return detail::load_partial_lanes<Vec>(ptr, count); }
+    AL_DLL_HIDDEN void store_partial(int32_t* ptr, const size_t count) const { detail::store_partial_lanes(ptr, count, *this); }
+
+    AL_DLL_HIDDEN friend Vec operator+(const Vec a, const Vec b) { return {add4i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator-(const Vec a, const Vec b) { return {sub4i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {cmpeq4i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator!=(const Vec a, const Vec b) { return ~(a == b); }
+    AL_DLL_HIDDEN friend mask_type operator>(const Vec a, const Vec b) { return {cmpgt4i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<(const Vec a, const Vec b) { return {cmpgt4i(b.v, a.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>=(const Vec a, const Vec b) { return ~(a < b); }
+    AL_DLL_HIDDEN friend mask_type operator<=(const Vec a, const Vec b) { return ~(a > b); }
+
+    AL_DLL_HIDDEN friend Vec min(const Vec a, const Vec b) { return {min4i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec max(const Vec a, const Vec b) { return {max4i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec select(const mask_type m, const Vec if_true, const Vec if_false) { return {select4i(if_false.v, if_true.v, m.m)}; }
+    AL_DLL_HIDDEN friend int32_t reduce_add(const Vec a) { return first4i(hadd4i(a.v)); }
+    AL_DLL_HIDDEN friend int32_t reduce_min(const Vec a) { return first4i(hmin4i(a.v)); }
+    AL_DLL_HIDDEN friend int32_t reduce_max(const Vec a) { return first4i(hmax4i(a.v)); }
+};
+
+template <> struct Vec<double, 2> {
+    using value_type = double;
+    using mask_type = Mask<double, 2>;
+    static constexpr int width = 2;
+    d128 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero2d()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const double x) { return {splat2d(x)}; }
+    AL_DLL_HIDDEN static Vec load(const double* ptr) { return {load2d(ptr)}; }
+    AL_DLL_HIDDEN static Vec loadu(const double* ptr) { return {loadu2d(ptr)}; }
+    AL_DLL_HIDDEN void store(double* ptr) const { store2d(ptr, v); }
+    AL_DLL_HIDDEN void storeu(double* ptr) const { storeu2d(ptr, v); }
+    AL_DLL_HIDDEN static Vec load_partial(const double* ptr, const size_t count) { return detail::load_partial_lanes<Vec>(ptr, count); }
+    AL_DLL_HIDDEN void store_partial(double* ptr, const size_t count) const { detail::store_partial_lanes(ptr, count, *this); }
+
+    AL_DLL_HIDDEN friend Vec operator+(const Vec a, const Vec b) { return {add2d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator-(const Vec a, const Vec b) { return {sub2d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator*(const Vec a, const Vec b) { return {mul2d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator/(const Vec a, const Vec b) { return {div2d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {cmpeq2d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator!=(const Vec a, const Vec b) { return {cmpne2d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>(const Vec a, const Vec b) { return {cmpgt2d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>=(const Vec a, const Vec b) { return {cmpge2d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<(const Vec a, const Vec b) { return {cmpgt2d(b.v, a.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<=(const Vec a, const Vec b) { return {cmpge2d(b.v, a.v)}; }
+
+    AL_DLL_HIDDEN friend Vec min(const Vec a, const Vec b) { return {min2d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec max(const Vec a, const Vec b) { return {max2d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec select(const mask_type m, const Vec if_true, const Vec if_false) { return {select2d(if_false.v, if_true.v, m.m)}; }
+    AL_DLL_HIDDEN friend Vec sqrt(const Vec a) { return {sqrt2d(a.v)}; }
+    AL_DLL_HIDDEN friend Vec fmadd(const Vec a, const Vec b, const Vec c) { return {fmadd2d(a.v, b.v, c.v)}; }
+    AL_DLL_HIDDEN friend double reduce_add(const Vec a) { return first2d(hadd2d(a.v)); }
+    AL_DLL_HIDDEN friend double reduce_min(const Vec a) { return first2d(hmin2d(a.v)); }
+    AL_DLL_HIDDEN friend double reduce_max(const Vec a) { return first2d(hmax2d(a.v)); }
+};
+
+template <> struct Vec<int64_t, 2> {
+    using value_type = int64_t;
+    using mask_type = Mask<int64_t, 2>;
+    static constexpr int width = 2;
+    i128 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero4i()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const int64_t x) { return {splat2i64(x)}; }
+    AL_DLL_HIDDEN static Vec load(const int64_t* ptr) { return {load4i(ptr)}; }
+    AL_DLL_HIDDEN static Vec loadu(const int64_t* ptr) { return {loadu4i(ptr)}; }
+    AL_DLL_HIDDEN void store(int64_t* ptr) const { store4i(ptr, v); }
+    AL_DLL_HIDDEN void storeu(int64_t* ptr) const { storeu4i(ptr, v); }
+    AL_DLL_HIDDEN static Vec load_partial(const int64_t* ptr, const size_t count) { return detail::load_partial_lanes<Vec>(ptr, count); }
+    AL_DLL_HIDDEN void store_partial(int64_t* ptr, const size_t count) const { detail::store_partial_lanes(ptr, count, *this); }
+
+    AL_DLL_HIDDEN friend Vec operator+(const Vec a, const Vec b) { return {add2i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator-(const Vec a, const Vec b) { return {sub2i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator*(const Vec a, const Vec b) { return {mullo2i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {cmpeq2i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator!=(const Vec a, const Vec b) { return ~(a == b); }
+    AL_DLL_HIDDEN friend mask_type operator>(const Vec a, const Vec b) { return {cmpgt2i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<(const Vec a, const Vec b) { return {cmpgt2i64(b.v, a.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>=(const Vec a, const Vec b) { return ~(a < b); }
+    AL_DLL_HIDDEN friend mask_type operator<=(const Vec a, const Vec b) { return ~(a > b); }
+
+    AL_DLL_HIDDEN friend Vec min(const Vec a, const Vec b) { return {min2i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec max(const Vec a, const Vec b) { return {max2i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec select(const mask_type m, const Vec if_true, const Vec if_false) { return {select4i(if_false.v, if_true.v, m.m)}; }
+    AL_DLL_HIDDEN friend int64_t reduce_add(const Vec a) { return first2i64(hadd2i64(a.v)); }
+    AL_DLL_HIDDEN friend int64_t reduce_min(const Vec a) { return first2i64(hmin2i64(a.v)); }
+    AL_DLL_HIDDEN friend int64_t reduce_max(const Vec a) { return first2i64(hmax2i64(a.v)); }
+};
+
+AL_DLL_HIDDEN inline Vec<float, 4> gather(const float* base, const Vec<int32_t, 4> indices) {
+# if defined(__AVX2__)
+    return {i32gather4f(base, indices.v)};
+# else
+    int32_t i[4];
+    indices.storeu(i);
+    return {set4f(base[i[0]], base[i[1]], base[i[2]], base[i[3]])};
+# endif
+}
+
+AL_DLL_HIDDEN inline Vec<int32_t, 4> gather(const int32_t* base, const Vec<int32_t, 4> indices) {
+# if defined(__AVX2__)
+    return {i32gather4i(base, indices.v)};
+# else
+    int32_t i[4];
+    indices.storeu(i);
+    return {set4i(base[i[0]], base[i[1]], base[i[2]], base[i[3]])};
+# endif
+}
+
+AL_DLL_HIDDEN inline int compress_store(float* dst, const Mask<float, 4> m, const Vec<float, 4> v) { return detail::compress_store_lanes(dst, m.bits(), v); }
+AL_DLL_HIDDEN inline int compress_store(int32_t* dst, const Mask<int32_t, 4> m, const Vec<int32_t, 4> v) { return detail::compress_store_lanes(dst, m.bits(), v); }
+AL_DLL_HIDDEN inline int compress_store(double* dst, const Mask<double, 2> m, const Vec<double, 2> v) { return detail::compress_store_lanes(dst, m.bits(), v); }
+
+AL_DLL_HIDDEN inline Vec<int64_t, 2> widen_lo(const Vec<int32_t, 4> a) { return {widenlo4i32_to_2i64(a.v)}; }
+AL_DLL_HIDDEN inline Vec<int64_t, 2> widen_hi(const Vec<int32_t, 4> a) { return {widenhi4i32_to_2i64(a.v)}; }
+AL_DLL_HIDDEN inline Vec<int64_t, 2> shift_left(const Vec<int64_t, 2> a, const int count) { return {shiftBitsLeft2i64(a.v, count)}; }
+AL_DLL_HIDDEN inline Vec<int64_t, 2> shift_right(const Vec<int64_t, 2> a, const int count) { return {shiftBitsRight2i64(a.v, count)}; }
+AL_DLL_HIDDEN inline Vec<double, 2> to_double(const Vec<int64_t, 2> a) { return {cvtu52_2i64_to_2d(a.v)}; }
+AL_DLL_HIDDEN inline Vec<int64_t, 2> to_int64(const Vec<double, 2> a) { return {cvt2d_to_u52_2i64(a.v)}; }
+AL_DLL_HIDDEN inline int lower_bound(const Vec<int32_t, 4> levels, const int32_t value) { return lower_bound4i(levels.v, value); }
+
+#endif
+
+
+#if defined(__AVX2__)
+
+template <> struct Mask<float, 8> {
+    f256 m;
+    AL_DLL_HIDDEN uint32_t bits() const { return static_cast<uint32_t>(movemask8f(m)); }
+    AL_DLL_HIDDEN friend Mask operator&(const Mask a, const Mask b) { return {and8f(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator|(const Mask a, const Mask b) { return {or8f(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator~(const Mask a) { return {andnot8f(a.m, cast8f(cmpeq8i(zero8i(), zero8i())))}; }
+};
+
+template <> struct Mask<int32_t, 8> {
+    i256 m;
+    AL_DLL_HIDDEN uint32_t bits() const { return static_cast<uint32_t>(movemask8i(m)); }
+    AL_DLL_HIDDEN friend Mask operator&(const Mask a, const Mask b) { return {and8i(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator|(const Mask a, const Mask b) { return {or8i(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator~(const Mask a) { return {xor8i(a.m, cmpeq8i(zero8i(), zero8i()))}; }
+};
+
+template <> struct Mask<double, 4> {
+    d256 m;
+    AL_DLL_HIDDEN uint32_t bits() const { return static_cast<uint32_t>(movemask4d(m)); }
+    AL_DLL_HIDDEN friend Mask operator&(const Mask a, const Mask b) { return {and4d(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator|(const Mask a, const Mask b) { return {or4d(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator~(const Mask a) { return {andnot4d(a.m, cast4d(cmpeq8i(zero8i(), zero8i())))}; }
+};
+
+template <> struct Mask<int64_t, 4> {
+    i256 m;
+    AL_DLL_HIDDEN uint32_t bits() const { return static_cast<uint32_t>(movemask4d(cast4d(m))); }
+    AL_DLL_HIDDEN friend Mask operator&(const Mask a, const Mask b) { return {and8i(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator|(const Mask a, const Mask b) { return {or8i(a.m, b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator~(const Mask a) { return {xor8i(a.m, cmpeq8i(zero8i(), zero8i()))}; }
+};
+
+template <> struct Mask<int8_t, 32> {
+    uint32_t m;
+    AL_DLL_HIDDEN uint64_t bits() const { return static_cast<uint32_t>(m); }
+};
+
+template <> struct Vec<int8_t, 32> {
+    using value_type = int8_t;
+    using mask_type = Mask<int8_t, 32>;
+    static constexpr int width = 32;
+    i256 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero8i()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const int8_t x) { return {splat32i8(x)}; }
+    AL_DLL_HIDDEN static Vec loadu(const void* ptr) { return {loadu8i(ptr)}; }
+    AL_DLL_HIDDEN void storeu(void* ptr) const { storeu8i(ptr, v); }
+
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {static_cast<uint32_t>(movemask32i8(cmpeq32i8(a.v, b.v)))}; }
+};
+
+template <> struct Vec<float, 8> {
+    using value_type = float;
+    using mask_type = Mask<float, 8>;
+    static constexpr int width = 8;
+    f256 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero8f()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const float x) { return {splat8f(x)}; }
+    AL_DLL_HIDDEN static Vec load(const float* ptr) { return {load8f(ptr)}; }
+    AL_DLL_HIDDEN static Vec loadu(const float* ptr) { return {loadu8f(ptr)}; }
+    AL_DLL_HIDDEN void store(float* ptr) const { store8f(ptr, v); }
+    AL_DLL_HIDDEN void storeu(float* ptr) const { storeu8f(ptr, v); }
+    AL_DLL_HIDDEN static Vec load_partial(const float* ptr, const size_t count) { return {maskload8f(ptr, firstn8i(count))}; }
+    AL_DLL_HIDDEN void store_partial(float* ptr, const size_t count) const { maskstore8f(ptr, firstn8i(count), v); }
+
+    AL_DLL_HIDDEN friend Vec operator+(const Vec a, const Vec b) { return {add8f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator-(const Vec a, const Vec b) { return {sub8f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator*(const Vec a, const Vec b) { return {mul8f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator/(const Vec a, const Vec b) { return {div8f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {cmpeq8f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator!=(const Vec a, const Vec b) { return {cmpne8f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>(const Vec a, const Vec b) { return {cmpgt8f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>=(const Vec a, const Vec b) { return {cmpge8f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<(const Vec a, const Vec b) { return {cmpgt8f(b.v, a.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<=(const Vec a, const Vec b) { return {cmpge8f(b.v, a.v)}; }
+
+    AL_DLL_HIDDEN friend Vec min(const Vec a, const Vec b) { return {min8f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec max(const Vec a, const Vec b) { return {max8f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec select(const mask_type m, const Vec if_true, const Vec if_false) { return {select8f(if_false.v, if_true.v, m.m)}; }
+    AL_DLL_HIDDEN friend Vec sqrt(const Vec a) { return {sqrt8f(a.v)}; }
+    AL_DLL_HIDDEN friend Vec fmadd(const Vec a, const Vec b, const Vec c) { return {fmadd8f(a.v, b.v, c.v)}; }
+    AL_DLL_HIDDEN friend float reduce_add(const Vec a) { return hadd8f(a.v); }
+    AL_DLL_HIDDEN friend float reduce_min(const Vec a) { return hmin8f(a.v); }
+    AL_DLL_HIDDEN friend float reduce_max(const Vec a) { return hmax8f(a.v); }
+};
+
+template <> struct Vec<int32_t, 8> {
+    using value_type = int32_t;
+    using mask_type = Mask<int32_t, 8>;
+    static constexpr int width = 8;
+    i256 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero8i()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const int32_t x) { return {splat8i(x)}; }
+    AL_DLL_HIDDEN static Vec load(const int32_t* ptr) { return {load8i(ptr)}; }
+    AL_DLL_HIDDEN static Vec loadu(const int32_t* ptr) { return {loadu8i(ptr)}; }
+    AL_DLL_HIDDEN void store(int32_t* ptr) const { store8i(ptr, v); }
+    AL_DLL_HIDDEN void storeu(int32_t* ptr) const { storeu8i(ptr, v); }
+    AL_DLL_HIDDEN static Vec load_partial(const int32_t* ptr, const size_t count) { return {maskload8i(ptr, firstn8i(count))}; }
+    AL_DLL_HIDDEN void store_partial(int32_t* ptr, const size_t count) const { maskstore8i(ptr, firstn8i(count), v); }
+
+    AL_DLL_HIDDEN friend Vec operator+(const Vec a, const Vec b) { return {add8i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator-(const Vec a, const Vec b) { return {sub8i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {cmpeq8i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator!=(const Vec a, const Vec b) { return ~(a == b); }
+    AL_DLL_HIDDEN friend mask_type operator>(const Vec a, const Vec b) { return {cmpgt8i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<(const Vec a, const Vec b) { return {cmpgt8i(b.v, a.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>=(const Vec a, const Vec b) { return ~(a < b); }
+    AL_DLL_HIDDEN friend mask_type operator<=(const Vec a, const Vec b) { return ~(a > b); }
+
+    AL_DLL_HIDDEN friend Vec min(const Vec a, const Vec b) { return {min8i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec max(const Vec a, const Vec b) { return {max8i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec select(const mask_type m, const Vec if_true, const Vec if_false) { return {select8i(if_false.v, if_true.v, m.m)}; }
+    AL_DLL_HIDDEN friend int32_t reduce_add(const Vec a) { return hadd8i(a.v); }
+    AL_DLL_HIDDEN friend int32_t reduce_min(const Vec a) { return hmin8i(a.v); }
+    AL_DLL_HIDDEN friend int32_t reduce_max(const Vec a) { return hmax8i(a.v); }
+};
+
+template <> struct Vec<double, 4> {
+    using value_type = double;
+    using mask_type = Mask<double, 4>;
+    static constexpr int width = 4;
+    d256 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero4d()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const double x) { return {splat4d(x)}; }
+    AL_DLL_HIDDEN static Vec load(const double* ptr) { return {load4d(ptr)}; }
+    AL_DLL_HIDDEN static Vec loadu(const double* ptr) { return {loadu4d(ptr)}; }
+    AL_DLL_HIDDEN void store(double* ptr) const { store4d(ptr, v); }
+    AL_DLL_HIDDEN void storeu(double* ptr) const { storeu4d(ptr, v); }
+    AL_DLL_HIDDEN static Vec load_partial(const double* ptr, const size_t count) { return {maskload4d(ptr, firstn4i64(count))}; }
+    AL_DLL_HIDDEN void store_partial(double* ptr, const size_t count) const { maskstore4d(ptr, firstn4i64(count), v); }
+
+    AL_DLL_HIDDEN friend Vec operator+(const Vec a, const Vec b) { return {add4d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator-(const Vec a, const Vec b) { return {sub4d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator*(const Vec a, const Vec b) { return {mul4d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator/(const Vec a, const Vec b) { return {div4d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {cmpeq4d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator!=(const Vec a, const Vec b) { return {cmpne4d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>(const Vec a, const Vec b) { return {cmpgt4d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>=(const Vec a, const Vec b) { return {cmpge4d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<(const Vec a, const Vec b) { return {cmpgt4d(b.v, a.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<=(const Vec a, const Vec b) { return {cmpge4d(b.v, a.v)}; }
+
+    AL_DLL_HIDDEN friend Vec min(const Vec a, const Vec b) { return {min4d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec max(const Vec a, const Vec b) { return {max4d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec select(const mask_type m, const Vec if_true, const Vec if_false) { return {select4d(if_false.v, if_true.v, m.m)}; }
+    AL_DLL_HIDDEN friend Vec sqrt(const Vec a) { return {sqrt4d(a.v)}; }
+    AL_DLL_HIDDEN friend Vec fmadd(const Vec a, const Vec b, const Vec c) { return {fmadd4d(a.v, b.v, c.v)}; }
+    AL_DLL_HIDDEN friend double reduce_add(const Vec a) { return hadd4d(a.v); }
+    AL_DLL_HIDDEN friend double reduce_min(const Vec a) { return hmin4d(a.v); }
+    AL_DLL_HIDDEN friend double reduce_max(const Vec a) { return hmax4d(a.v); }
+};
+
+template <> struct Vec<int64_t, 4> {
+    using value_type = int64_t;
+    using mask_type = Mask<int64_t, 4>;
+    static constexpr int width = 4;
+    i256 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero8i()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const int64_t x) { return {splat4i64(x)}; }
+    AL_DLL_HIDDEN static Vec load(const int64_t* ptr) { return {load8i(ptr)}; }
+    AL_DLL_HIDDEN static Vec loadu(const int64_t* ptr) { return {loadu8i(ptr)}; }
+    AL_DLL_HIDDEN void store(int64_t* ptr) const { store8i(ptr, v); }
+    AL_DLL_HIDDEN void storeu(int64_t* ptr) const { storeu8i(ptr, v); }
+    AL_DLL_HIDDEN static Vec load_partial(const int64_t* ptr, const size_t count) { return {cast8i(maskload4d(ptr, firstn4i64(count)))}; }
+    AL_DLL_HIDDEN void store_partial(int64_t* ptr, const size_t count) const { maskstore4d(ptr, firstn4i64(count), cast4d(v)); }
+
+    AL_DLL_HIDDEN friend Vec operator+(const Vec a, const Vec b) { return {add4i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator-(const Vec a, const Vec b) { return {sub4i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator*(const Vec a, const Vec b) { return {mullo4i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {cmpeq4i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator!=(const Vec a, const Vec b) { return ~(a == b); }
+    AL_DLL_HIDDEN friend mask_type operator>(const Vec a, const Vec b) { return {cmpgt4i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<(const Vec a, const Vec b) { return {cmpgt4i64(b.v, a.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>=(const Vec a, const Vec b) { return ~(a < b); }
+    AL_DLL_HIDDEN friend mask_type operator<=(const Vec a, const Vec b) { return ~(a > b); }
+
+    AL_DLL_HIDDEN friend Vec min(const Vec a, const Vec b) { return {min4i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec max(const Vec a, const Vec b) { return {max4i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec select(const mask_type m, const Vec if_true, const Vec if_false) { return {select8i(if_false.v, if_true.v, m.m)}; }
+    AL_DLL_HIDDEN friend int64_t reduce_add(const Vec a) { return hadd4i64(a.v); }
+    AL_DLL_HIDDEN friend int64_t reduce_min(const Vec a) { return hmin4i64(a.v); }
+    AL_DLL_HIDDEN friend int64_t reduce_max(const Vec a) { return hmax4i64(a.v); }
+};
+
+AL_DLL_HIDDEN inline Vec<float, 8> gather(const float* base, const Vec<int32_t, 8> indices) { return {i32gather8f(base, indices.v)}; }
+AL_DLL_HIDDEN inline Vec<int32_t, 8> gather(const int32_t* base, const Vec<int32_t, 8> indices) { return {i32gather8i(base, indices.v)}; }
+
+AL_DLL_HIDDEN inline Vec<int64_t, 4> widen_lo(const Vec<int32_t, 8> a) { return {cvt4i32_to_4i64(cast4i(a.v))}; }
+AL_DLL_HIDDEN inline Vec<int64_t, 4> widen_hi(const Vec<int32_t, 8> a) { return {cvt4i32_to_4i64(extract4i(a.v, 1))}; }
+AL_DLL_HIDDEN inline Vec<int64_t, 4> shift_left(const Vec<int64_t, 4> a, const int count) { return {shiftBitsLeft4i64(a.v, count)}; }
+AL_DLL_HIDDEN inline Vec<int64_t, 4> shift_right(const Vec<int64_t, 4> a, const int count) { return {shiftBitsRight4i64(a.v, count)}; }
+AL_DLL_HIDDEN inline Vec<double, 4> to_double(const Vec<int64_t, 4> a) { return {cvtu52_4i64_to_4d(a.v)}; }
+AL_DLL_HIDDEN inline Vec<int64_t, 4> to_int64(const Vec<double, 4> a) { return {cvt4d_to_u52_4i64(a.v)}; }
+AL_DLL_HIDDEN inline int lower_bound(const Vec<int32_t, 8> levels, const int32_t value) { return lower_bound8i(levels.v, value); }
+
+# if defined(__BMI2__)
+AL_DLL_HIDDEN inline int compress_store(float* dst, const Mask<float, 8> m, const Vec<float, 8> v) {
+    storeu8f(dst, compress8f(v.v, m.bits()));
+    return popcount32(m.bits());
+}
+AL_DLL_HIDDEN inline int compress_store(int32_t* dst, const Mask<int32_t, 8> m, const Vec<int32_t, 8> v) {
+    storeu8i(dst, compress8i(v.v, m.bits()));
+    return popcount32(m.bits());
+}
+AL_DLL_HIDDEN inline int compress_store(double* dst, const Mask<double, 4> m, const Vec<double, 4> v) {
+    storeu4d(dst, compress4d(v.v, m.bits()));
+    return popcount32(m.bits());
+}
+# else
+AL_DLL_HIDDEN inline int compress_store(float* dst, const Mask<float, 8> m, const Vec<float, 8> v) { return detail::compress_store_lanes(dst, m.bits(), v); }
+AL_DLL_HIDDEN inline int compress_store(int32_t* dst, const Mask<int32_t, 8> m, const Vec<int32_t, 8> v) { return detail::compress_store_lanes(dst, m.bits(), v); }
+AL_DLL_HIDDEN inline int compress_store(double* dst, const Mask<double, 4> m, const Vec<double, 4> v) { return detail::compress_store_lanes(dst, m.bits(), v); }
+# endif
+
+#endif
+
+
+#if defined(__AVX512F__)
+
+template <> struct Mask<float, 16> {
+    mask16 m;
+    AL_DLL_HIDDEN uint32_t bits() const { return static_cast<uint32_t>(m); }
+    AL_DLL_HIDDEN friend Mask operator&(const Mask a, const Mask b) { return {static_cast<mask16>(a.m & b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator|(const Mask a, const Mask b) { return {static_cast<mask16>(a.m | b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator~(const Mask a) { return {static_cast<mask16>(~a.m)}; }
+};
+
+template <> struct Mask<int32_t, 16> {
+    mask16 m;
+    AL_DLL_HIDDEN uint32_t bits() const { return static_cast<uint32_t>(m); }
+    AL_DLL_HIDDEN friend Mask operator&(const Mask a, const Mask b) { return {static_cast<mask16>(a.m & b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator|(const Mask a, const Mask b) { return {static_cast<mask16>(a.m | b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator~(const Mask a) { return {static_cast<mask16>(~a.m)}; }
+};
+
+template <> struct Mask<double, 8> {
+    mask8 m;
+    AL_DLL_HIDDEN uint32_t bits() const { return static_cast<uint32_t>(m); }
+    AL_DLL_HIDDEN friend Mask operator&(const Mask a, const Mask b) { return {static_cast<mask8>(a.m & b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator|(const Mask a, const Mask b) { return {static_cast<mask8>(a.m | b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator~(const Mask a) { return {static_cast<mask8>(~a.m)}; }
+};
+
+template <> struct Mask<int64_t, 8> {
+    mask8 m;
+    AL_DLL_HIDDEN uint32_t bits() const { return static_cast<uint32_t>(m); }
+    AL_DLL_HIDDEN friend Mask operator&(const Mask a, const Mask b) { return {static_cast<mask8>(a.m & b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator|(const Mask a, const Mask b) { return {static_cast<mask8>(a.m | b.m)}; }
+    AL_DLL_HIDDEN friend Mask operator~(const Mask a) { return {static_cast<mask8>(~a.m)}; }
+};
+
+# if defined(__AVX512BW__)
+template <> struct Mask<int8_t, 64> {
+    mask64 m;
+    AL_DLL_HIDDEN uint64_t bits() const { return static_cast<uint64_t>(m); }
+};
+
+template <> struct Vec<int8_t, 64> {
+    using value_type = int8_t;
+    using mask_type = Mask<int8_t, 64>;
+    static constexpr int width = 64;
+    i512 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero16i()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const int8_t x) { return {splat64i8(x)}; }
+    AL_DLL_HIDDEN static Vec loadu(const void* ptr) { return {loadu16i(ptr)}; }
+    AL_DLL_HIDDEN void storeu(void* ptr) const { storeu16i(ptr, v); }
+
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {cmpeq64i8(a.v, b.v)}; }
+};
+# endif
+
+template <> struct Vec<float, 16> {
+    using value_type = float;
+    using mask_type = Mask<float, 16>;
+    static constexpr int width = 16;
+    f512 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero16f()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const float x) { return {splat16f(x)}; }
+    AL_DLL_HIDDEN static Vec load(const float* ptr) { return {load16f(ptr)}; }
+    AL_DLL_HIDDEN static Vec loadu(const float* ptr) { return {loadu16f(ptr)}; }
+    AL_DLL_HIDDEN void store(float* ptr) const { store16f(ptr, v); }
+    AL_DLL_HIDDEN void storeu(float* ptr) const { storeu16f(ptr, v); }
+    AL_DLL_HIDDEN static Vec load_partial(const float* ptr, const size_t count) { return {maskz_loadu16f(firstn16(count), ptr)}; }
+    AL_DLL_HIDDEN void store_partial(float* ptr, const size_t count) const { mask_storeu16f(ptr, firstn16(count), v); }
+
+    AL_DLL_HIDDEN friend Vec operator+(const Vec a, const Vec b) { return {add16f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator-(const Vec a, const Vec b) { return {sub16f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator*(const Vec a, const Vec b) { return {mul16f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator/(const Vec a, const Vec b) { return {div16f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {cmpeq16f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator!=(const Vec a, const Vec b) { return {cmpne16f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>(const Vec a, const Vec b) { return {cmpgt16f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>=(const Vec a, const Vec b) { return {cmpge16f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<(const Vec a, const Vec b) { return {cmpgt16f(b.v, a.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<=(const Vec a, const Vec b) { return {cmpge16f(b.v, a.v)}; }
+
+    AL_DLL_HIDDEN friend Vec min(const Vec a, const Vec b) { return {min16f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec max(const Vec a, const Vec b) { return {max16f(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec select(const mask_type m, const Vec if_true, const Vec if_false) { return {select16f(if_false.v, if_true.v, m.m)}; }
+    AL_DLL_HIDDEN friend Vec sqrt(const Vec a) { return {sqrt16f(a.v)}; }
+    AL_DLL_HIDDEN friend Vec fmadd(const Vec a, const Vec b, const Vec c) { return {fmadd16f(a.v, b.v, c.v)}; }
+    AL_DLL_HIDDEN friend float reduce_add(const Vec a) { return hadd16f(a.v); }
+    AL_DLL_HIDDEN friend float reduce_min(const Vec a) { return hmin16f(a.v); }
+    AL_DLL_HIDDEN friend float reduce_max(const Vec a) { return hmax16f(a.v); }
+};
+
+template <> struct Vec<int32_t, 16> {
+    using value_type = int32_t;
+    using mask_type = Mask<int32_t, 16>;
+    static constexpr int width = 16;
+    i512 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero16i()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const int32_t x) { return {splat16i(x)}; }
+    AL_DLL_HIDDEN static Vec load(const int32_t* ptr) { return {load16i(ptr)}; }
+    AL_DLL_HIDDEN static Vec loadu(const int32_t* ptr) { return {loadu16i(ptr)}; }
+    AL_DLL_HIDDEN void store(int32_t* ptr) const { store16i(ptr, v); }
+    AL_DLL_HIDDEN void storeu(int32_t* ptr) const { storeu16i(ptr, v); }
+    AL_DLL_HIDDEN static Vec load_partial(const int32_t* ptr, const size_t count) { return {maskz_loadu16i(firstn16(count), ptr)}; }
+    AL_DLL_HIDDEN void store_partial(int32_t* ptr, const size_t count) const { mask_storeu16i(ptr, firstn16(count), v); }
+
+    AL_DLL_HIDDEN friend Vec operator+(const Vec a, const Vec b) { return {add16i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator-(const Vec a, const Vec b) { return {sub16i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {cmpeq16i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator!=(const Vec a, const Vec b) { return ~(a == b); }
+    AL_DLL_HIDDEN friend mask_type operator>(const Vec a, const Vec b) { return {cmpgt16i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<(const Vec a, const Vec b) { return {cmpgt16i(b.v, a.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>=(const Vec a, const Vec b) { return ~(a < b); }
+    AL_DLL_HIDDEN friend mask_type operator<=(const Vec a, const Vec b) { return ~(a > b); }
+
+    AL_DLL_HIDDEN friend Vec min(const Vec a, const Vec b) { return {min16i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec max(const Vec a, const Vec b) { return {max16i(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec select(const mask_type m, const Vec if_true, const Vec if_false) { return {select16i(if_false.v, if_true.v, m.m)}; }
+    AL_DLL_HIDDEN friend int32_t reduce_add(const Vec a) { return hadd16i(a.v); }
+    AL_DLL_HIDDEN friend int32_t reduce_min(const Vec a) { return hmin16i(a.v); }
+    AL_DLL_HIDDEN friend int32_t reduce_max(const Vec a) { return hmax16i(a.v); }
+};
+
+template <> struct Vec<double, 8> {
+    using value_type = double;
+    using mask_type = Mask<double, 8>;
+    static constexpr int width = 8;
+    d512 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero8d()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const double x) { return {splat8d(x)}; }
+    AL_DLL_HIDDEN static Vec load(const double* ptr) { return {load8d(ptr)}; }
+    AL_DLL_HIDDEN static Vec loadu(const double* ptr) { return {loadu8d(ptr)}; }
+    AL_DLL_HIDDEN void store(double* ptr) const { store8d(ptr, v); }
+    AL_DLL_HIDDEN void storeu(double* ptr) const { storeu8d(ptr, v); }
+    AL_DLL_HIDDEN static Vec load_partial(const double* ptr, const size_t count) { return {maskz_loadu8d(firstn8(count), ptr)}; }
+    AL_DLL_HIDDEN void store_partial(double* ptr, const size_t count) const { mask_storeu8d(ptr, firstn8(count), v); }
+
+    AL_DLL_HIDDEN friend Vec operator+(const Vec a, const Vec b) { return {add8d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator-(const Vec a, const Vec b) { return {sub8d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator*(const Vec a, const Vec b) { return {mul8d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator/(const Vec a, const Vec b) { return {div8d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {cmpeq8d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator!=(const Vec a, const Vec b) { return {cmpne8d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>(const Vec a, const Vec b) { return {cmpgt8d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>=(const Vec a, const Vec b) { return {cmpge8d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<(const Vec a, const Vec b) { return {cmpgt8d(b.v, a.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<=(const Vec a, const Vec b) { return {cmpge8d(b.v, a.v)}; }
+
+    AL_DLL_HIDDEN friend Vec min(const Vec a, const Vec b) { return {min8d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec max(const Vec a, const Vec b) { return {max8d(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec select(const mask_type m, const Vec if_true, const Vec if_false) { return {select8d(if_false.v, if_true.v, m.m)}; }
+    AL_DLL_HIDDEN friend Vec sqrt(const Vec a) { return {sqrt8d(a.v)}; }
+    AL_DLL_HIDDEN friend Vec fmadd(const Vec a, const Vec b, const Vec c) { return {fmadd8d(a.v, b.v, c.v)}; }
+    AL_DLL_HIDDEN friend double reduce_add(const Vec a) { return hadd8d(a.v); }
+    AL_DLL_HIDDEN friend double reduce_min(const Vec a) { return hmin8d(a.v); }
+    AL_DLL_HIDDEN friend double reduce_max(const Vec a) { return hmax8d(a.v); }
+};
+
+template <> struct Vec<int64_t, 8> {
+    using value_type = int64_t;
+    using mask_type = Mask<int64_t, 8>;
+    static constexpr int width = 8;
+    i512 v;
+
+    AL_DLL_HIDDEN static Vec zero() { return {zero16i()}; }
+    AL_DLL_HIDDEN static Vec broadcast(const int64_t x) { return {splat8i64(x)}; }
+    AL_DLL_HIDDEN static Vec load(const int64_t* ptr) { return {load16i(ptr)}; }
+    AL_DLL_HIDDEN static Vec loadu(const int64_t* ptr) { return {loadu16i(ptr)}; }
+    AL_DLL_HIDDEN void store(int64_t* ptr) const { store16i(ptr, v); }
+    AL_DLL_HIDDEN void storeu(int64_t* ptr) const { storeu16i(ptr, v); }
+    AL_DLL_HIDDEN static Vec load_partial(const int64_t* ptr, const size_t count) { return {maskz_loadu8i64(firstn8(count), ptr)}; }
+    AL_DLL_HIDDEN void store_partial(int64_t* ptr, const size_t count) const { mask_storeu8i64(ptr, firstn8(count), v); }
+
+    AL_DLL_HIDDEN friend Vec operator+(const Vec a, const Vec b) { return {add8i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator-(const Vec a, const Vec b) { return {sub8i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec operator*(const Vec a, const Vec b) { return {mullo8i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator==(const Vec a, const Vec b) { return {cmpeq8i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator!=(const Vec a, const Vec b) { return ~(a == b); }
+    AL_DLL_HIDDEN friend mask_type operator>(const Vec a, const Vec b) { return {cmpgt8i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator<(const Vec a, const Vec b) { return {cmpgt8i64(b.v, a.v)}; }
+    AL_DLL_HIDDEN friend mask_type operator>=(const Vec a, const Vec b) { return ~(a < b); }
+    AL_DLL_HIDDEN friend mask_type operator<=(const Vec a, const Vec b) { return ~(a > b); }
+
+    AL_DLL_HIDDEN friend Vec min(const Vec a, const Vec b) { return {min8i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec max(const Vec a, const Vec b) { return {max8i64(a.v, b.v)}; }
+    AL_DLL_HIDDEN friend Vec select(const mask_type m, const Vec if_true, const Vec if_false) { return {select8i64(if_false.v, if_true.v, m.m)}; }
+    AL_DLL_HIDDEN friend int64_t reduce_add(const Vec a) { return hadd8i64(a.v); }
+    AL_DLL_HIDDEN friend int64_t reduce_min(const Vec a) { return hmin8i64(a.v); }
+    AL_DLL_HIDDEN friend int64_t reduce_max(const Vec a) { return hmax8i64(a.v); }
+};
+
+AL_DLL_HIDDEN inline Vec<float, 16> gather(const float* base, const Vec<int32_t, 16> indices) { return {i32gather16f(base, indices.v)}; }
+AL_DLL_HIDDEN inline Vec<int32_t, 16> gather(const int32_t* base, const Vec<int32_t, 16> indices) { return {i32gather16i(base, indices.v)}; }
+
+AL_DLL_HIDDEN inline Vec<int64_t, 8> widen_lo(const Vec<int32_t, 16> a) { return {cvt8i32_to_8i64(cast8i(a.v))}; }
+AL_DLL_HIDDEN inline Vec<int64_t, 8> widen_hi(const Vec<int32_t, 16> a) { return {cvt8i32_to_8i64(extract8i(a.v, 1))}; }
+AL_DLL_HIDDEN inline Vec<int64_t, 8> shift_left(const Vec<int64_t, 8> a, const int count) { return {shiftBitsLeft8i64(a.v, count)}; }
+AL_DLL_HIDDEN inline Vec<int64_t, 8> shift_right(const Vec<int64_t, 8> a, const int count) { return {shiftBitsRight8i64(a.v, count)}; }
+AL_DLL_HIDDEN inline Vec<double, 8> to_double(const Vec<int64_t, 8> a) { return {cvtu52_8i64_to_8d(a.v)}; }
+AL_DLL_HIDDEN inline Vec<int64_t, 8> to_int64(const Vec<double, 8> a) { return {cvt8d_to_u52_8i64(a.v)}; }
+AL_DLL_HIDDEN inline int lower_bound(const Vec<int32_t, 16> levels, const int32_t value) { return lower_bound16i(levels.v, value); }
+
+AL_DLL_HIDDEN inline int compress_store(float* dst, const Mask<float, 16> m, const Vec<float, 16> v) {
+    storeu16f(dst, compress16f(m.m, v.v));
+    return popcount32(m.bits());
+}
+AL_DLL_HIDDEN inline int compress_store(int32_t* dst, const Mask<int32_t, 16> m, const Vec<int32_t, 16> v) {
+    storeu16i(dst, compress16i(m.m, v.v));
+    return popcount32(m.bits());
+}
+AL_DLL_HIDDEN inline int compress_store(double* dst, const Mask<double, 8> m, const Vec<double, 8> v) {
+    storeu8d(dst, compress8d(m.m, v.v));
+    return popcount32(m.bits());
+}
+
+#endif
+
+
+// Generic helpers shared by every width.
+template <typename T, int N>
+AL_DLL_HIDDEN inline Vec<T, N>& operator+=(Vec<T, N>& a, const Vec<T, N> b) { return a = a + b; }
+
+template <typename T, int N>
+AL_DLL_HIDDEN inline Vec<T, N>& operator-=(Vec<T, N>& a, const Vec<T, N> b) { return a = a - b; }
+
+template <typename T, int N>
+AL_DLL_HIDDEN inline Vec<T, N>& operator*=(Vec<T, N>& a, const Vec<T, N> b) { return a = a * b; }
+
+template <typename M>
+AL_DLL_HIDDEN inline bool any(const M m) { return m.bits() != 0; }
+
+template <typename M>
+AL_DLL_HIDDEN inline bool none(const M m) { return m.bits() == 0; }
+
+template <typename T, int N>
+AL_DLL_HIDDEN inline bool all(const Mask<T, N> m) { return m.bits() == (N == 32 ? ~0u : (1u << N) - 1); }
+
+}
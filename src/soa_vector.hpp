@@ -0,0 +1,329 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "aligned_buffer.hpp"
+#include "vos_vs_sov.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+// Stands in for Ts&... of one record spread across columns. Reading converts to the
+// value tuple and assigning writes through to the columns, like
+// std::vector<bool>::reference.
+template <typename... Ts>
+class soa_reference {
+public:
+    explicit soa_reference(Ts&... fields) : fields_(fields...) {}
+    soa_reference(const soa_reference&) = default;
+
+    soa_reference& operator=(const soa_reference& other) {
+        fields_ = other.fields_;
+        return *this;
+    }
+
+    soa_reference& operator=(const std::tuple<std::remove_const_t<Ts>...>& values) {
+        fields_ = values;
+        return *this;
+    }
+
+    operator std::tuple<std::remove_const_t<Ts>...>() const { return fields_; }
+
+    template <size_t I>
+    auto& get() const { return std::get<I>(fields_); }
+
+private:
+    std::tuple<Ts&...> fields_;
+};
+
+template <size_t I, typename... Ts>
+auto& get(const soa_reference<Ts...>& ref) { return ref.template get<I>(); }
+
+
+// A vector of records (Ts...) stored as one column per field. Every column is a
+// separate 64-byte aligned buffer, so a loop over one field streams through exactly
+// the bytes it uses and can be vectorised with aligned loads. All columns share one
+// size and capacity and grow together.
+template <typename... Ts>
+class soa_vector {
+    static_assert(sizeof...(Ts) > 0, "soa_vector needs at least one field");
+    static_assert((std::is_trivially_copyable_v<Ts> && ...), "columns are grown with memcpy, so fields must be trivially copyable");
+
+public:
+    using value_type = std::tuple<Ts...>;
+    using reference = soa_reference<Ts...>;
+    using const_reference = soa_reference<const Ts...>;
+    static constexpr size_t fields = sizeof...(Ts);
+
+    template <size_t I>
+    using field_type = std::tuple_element_t<I, value_type>;
+
+    soa_vector() = default;
+    explicit soa_vector(size_t size) { resize(size); }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    void reserve(size_t capacity) {
+        if (capacity <= capacity_) return;
+        std::apply([&](auto&... column) { (grow(column, capacity), ...); }, columns_);
+        capacity_ = capacity;
+    }
+
+    // New records are zero, since the buffers are.
+    void resize(size_t size) {
+        reserve(size);
+        if (size < size_) {
+            // Zero the dropped records so that growing again gives zeros.
+            std::apply([&](auto&... column) { (std::memset(column.data() + size, 0, (size_ - size) * sizeof(column[0])), ...); }, columns_);
+        }
+        size_ = size;
+    }
+
+    void clear() { resize(0); }
+
+    void push_back(const value_type& record) {
+        std::apply([&](const Ts&... values) { emplace_back(values...); }, record);
+    }
+
+    void emplace_back(const Ts&... values) {
+        if (size_ == capacity_) {
+            reserve(capacity_ ? 2 * capacity_ : 16);
+        }
+        store(size_, std::index_sequence_for<Ts...>(), values...);
+        ++size_;
+    }
+
+    reference operator[](size_t i) {
+        return std::apply([&](auto&... column) { return reference(column[i]...); }, columns_);
+    }
+
+    const_reference operator[](size_t i) const {
+        return std::apply([&](const auto&... column) { return const_reference(column[i]...); }, columns_);
+    }
+
+    template <size_t I>
+    field_type<I>& get(size_t i) { return std::get<I>(columns_)[i]; }
+
+    template <size_t I>
+    const field_type<I>& get(size_t i) const { return std::get<I>(columns_)[i]; }
+
+    template <size_t I>
+    std::span<field_type<I>> column() { return {std::get<I>(columns_).data(), size_}; }
+
+    template <size_t I>
+    std::span<const field_type<I>> column() const { return {std::get<I>(columns_).data(), size_}; }
+
+private:
+    template <typename T>
+    void grow(AlignedBuffer<T>& column, size_t capacity) {
+        AlignedBuffer<T> bigger(capacity);
+        if (size_ != 0) {
+            std::memcpy(bigger.data(), column.data(), size_ * sizeof(T));
+        }
+        column = std::move(bigger);
+    }
+
+    template <size_t... I>
+    void store(size_t i, std::index_sequence<I...>, const Ts&... values) {
+        ((std::get<I>(columns_)[i] = values), ...);
+    }
+
+    std::tuple<AlignedBuffer<Ts>...> columns_;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
+
+
+// Array of structures of arrays: records are grouped into blocks of Block, and each
+// block holds one Block-long array per field. Within a block a field is contiguous,
+// which is what a vector loop wants, while all the fields of a record sit within one
+// block, a few cache lines, rather than in columns far apart. Block must be a power
+// of two; a multiple of the SIMD width keeps each array made of whole vectors.
+template <size_t Block, typename... Ts>
+class aosoa_vector {
+    static_assert(Block != 0 && (Block & (Block - 1)) == 0, "Block must be a power of two");
+    static_assert((std::is_trivially_copyable_v<Ts> && ...), "blocks are grown with memcpy, so fields must be trivially copyable");
+
+    static constexpr size_t field_bytes[] = {sizeof(Ts) * Block...};
+
+    template <size_t I>
+    static constexpr size_t offset() {
+        size_t offset = 0;
+        for (size_t k = 0; k < I; ++k) offset += field_bytes[k];
+        return offset;
+    }
+
+public:
+    using value_type = std::tuple<Ts...>;
+    using reference = soa_reference<Ts...>;
+    using const_reference = soa_reference<const Ts...>;
+    static constexpr size_t block_size = Block;
+    static constexpr size_t block_bytes = (offset<sizeof...(Ts)>() + 63) & ~size_t(63);
+
+    template <size_t I>
+    using field_type = std::tuple_element_t<I, value_type>;
+
+    aosoa_vector() = default;
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return blocks_.size() / block_bytes * Block; }
+    bool empty() const { return size_ == 0; }
+    size_t blocks() const { return (size_ + Block - 1) / Block; }
+
+    void reserve(size_t capacity) {
+        const size_t blocks = (capacity + Block - 1) / Block;
+        if (blocks * block_bytes <= blocks_.size()) return;
+        AlignedBuffer<std::byte> bigger(blocks * block_bytes);
+        if (size_ != 0) {
+            std::memcpy(bigger.data(), blocks_.data(), this->blocks() * block_bytes);
+        }
+        blocks_ = std::move(bigger);
+    }
+
+    // Zeroes the used blocks, so that the tail of the last block stays zero.
+    void clear() {
+        if (size_ != 0) {
+            std::memset(blocks_.data(), 0, blocks() * block_bytes);
+        }
+        size_ = 0;
+    }
+
+    void push_back(const value_type& record) {
+        std::apply([&](const Ts&... values) { emplace_back(values...); }, record);
+    }
+
+    void emplace_back(const Ts&... values) {
+        if (size_ == capacity()) {
+            reserve(size_ ? 2 * size_ : 16 * Block);
+        }
+        store(size_, std::index_sequence_for<Ts...>(), values...);
+        ++size_;
+    }
+
+    reference operator[](size_t i) { return make_reference<reference>(*this, i, std::index_sequence_for<Ts...>()); }
+    const_reference operator[](size_t i) const { return make_reference<const_reference>(*this, i, std::index_sequence_for<Ts...>()); }
+
+    template <size_t I>
+    field_type<I>& get(size_t i) { return block_column<I>(i / Block)[i % Block]; }
+
+    template <size_t I>
+    const field_type<I>& get(size_t i) const { return block_column<I>(i / Block)[i % Block]; }
+
+    // Field I of every record in block b. The last block's array runs past size() into
+    // zeroed records.
+    template <size_t I>
+    std::span<field_type<I>, Block> block_column(size_t b) {
+        return std::span<field_type<I>, Block>(reinterpret_cast<field_type<I>*>(blocks_.data() + b * block_bytes + offset<I>()), Block);
+    }
+
+    template <size_t I>
+    std::span<const field_type<I>, Block> block_column(size_t b) const {
+        return std::span<const field_type<I>, Block>(reinterpret_cast<const field_type<I>*>(blocks_.data() + b * block_bytes + offset<I>()), Block);
+    }
+
+private:
+    template <typename R, typename Self, size_t... I>
+    static R make_reference(Self& self, size_t i, std::index_sequence<I...>) {
+        return R(self.template get<I>(i)...);
+    }
+
+    template <size_t... I>
+    void store(size_t i, std::index_sequence<I...>, const Ts&... values) {
+        ((get<I>(i) = values), ...);
+    }
+
+    AlignedBuffer<std::byte> blocks_;
+    size_t size_ = 0;
+};
+
+
+namespace soa {
+
+enum Ohlc : size_t { Open, High, Low, Close };
+
+using OpenHighLowCloses = soa_vector<float, float, float, float>;
+
+template <size_t Block>
+using OpenHighLowCloseBlocks = aosoa_vector<Block, float, float, float, float>;
+
+inline SOV::OpenHighLowClosesView view(const OpenHighLowCloses& bars) {
+    return {bars.column<Open>(), bars.column<High>(), bars.column<Low>(), bars.column<Close>(), {}};
+}
+
+// SOV::ADX over any container with size() and get<Field>(i), so the layouts can be
+// compared running the same arithmetic.
+template <typename Bars>
+float ADX(const Bars& data, size_t period = 14) {
+    return SOV::WilderADX(data.size(), period,
+                          [&](size_t i) { return data.template get<High>(i); },
+                          [&](size_t i) { return data.template get<Low>(i); },
+                          [&](size_t i) { return data.template get<Close>(i); });
+}
+
+}
+
+
+// ADX over the same bars in four layouts, from 100 bars (well inside L1) to 1M (out
+// of L2): VOS::ADX on an array of structs, SOV::ADX on the soa_vector columns, and
+// soa::ADX on soa_vector and on 16-bar AoSoA blocks. items_per_second counts bars.
+class LayoutBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        const auto n = static_cast<size_t>(state.range(0));
+        aos = generateVOSData(n);
+        soa_bars.clear();
+        aosoa_bars.clear();
+        for (const VOS::OpenHighLowClose& bar : aos) {
+            soa_bars.emplace_back(bar.open, bar.high, bar.low, bar.close);
+            aosoa_bars.emplace_back(bar.open, bar.high, bar.low, bar.close);
+        }
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    VOS::OpenHighLowCloses aos;
+    soa::OpenHighLowCloses soa_bars;
+    soa::OpenHighLowCloseBlocks<16> aosoa_bars;
+};
+
+
+BENCHMARK_DEFINE_F(LayoutBenchmark, BM_AoS)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        benchmark::DoNotOptimize(VOS::ADX(aos));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_REGISTER_F(LayoutBenchmark, BM_AoS)->ArgName("bars")->RangeMultiplier(10)->Range(100, 1000000);
+
+BENCHMARK_DEFINE_F(LayoutBenchmark, BM_SoAColumns)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        benchmark::DoNotOptimize(SOV::ADX(soa::view(soa_bars)));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_REGISTER_F(LayoutBenchmark, BM_SoAColumns)->ArgName("bars")->RangeMultiplier(10)->Range(100, 1000000);
+
+BENCHMARK_DEFINE_F(LayoutBenchmark, BM_SoA)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        benchmark::DoNotOptimize(soa::ADX(soa_bars));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_REGISTER_F(LayoutBenchmark, BM_SoA)->ArgName("bars")->RangeMultiplier(10)->Range(100, 1000000);
+
+BENCHMARK_DEFINE_F(LayoutBenchmark, BM_AoSoA)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        benchmark::DoNotOptimize(soa::ADX(aosoa_bars));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_REGISTER_F(LayoutBenchmark, BM_AoSoA)->ArgName("bars")->RangeMultiplier(10)->Range(100, 1000000);
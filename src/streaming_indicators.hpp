@@ -0,0 +1,470 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "vos_vs_sov.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+
+namespace streaming {
+
+// One bar and what it adds relative to the bar before it. Working out true range,
+// the directional moves and the close-to-close change is common to several
+// indicators, so it is done once per bar here and every indicator reads the result.
+struct Step {
+    float high, low, close, volume;
+    bool first;     // no previous bar; the fields below are zero
+    float tr;
+    float plusDM;
+    float minusDM;
+    float change;   // close - previous close
+};
+
+class Stepper {
+public:
+    Step next(float high, float low, float close, float volume = 0.0f) {
+        Step s{high, low, close, volume, first_, 0.0f, 0.0f, 0.0f, 0.0f};
+        if (!first_) {
+            // Written exactly as in VOS::ADX and SOV::ADX.
+            s.tr = std::max({high - low, std::abs(high - prev_close_), std::abs(low - prev_close_)});
+            s.plusDM = (high - prev_high_ > prev_low_ - low && high - prev_high_ > 0) ? (high - prev_high_) : 0;
+            s.minusDM = (prev_low_ - low > high - prev_high_ && prev_low_ - low > 0) ? (prev_low_ - low) : 0;
+            s.change = close - prev_close_;
+        }
+        first_ = false;
+        prev_high_ = high;
+        prev_low_ = low;
+        prev_close_ = close;
+        return s;
+    }
+
+private:
+    bool first_ = true;
+    float prev_high_ = 0.0f, prev_low_ = 0.0f, prev_close_ = 0.0f;
+};
+
+// Every indicator below takes one Step per bar in update(), which is O(1), and has an
+// append() that makes the Step itself for use on its own.
+template <typename Derived>
+class Indicator {
+public:
+    void append(float high, float low, float close, float volume = 0.0f) {
+        static_cast<Derived*>(this)->update(stepper_.next(high, low, close, volume));
+    }
+
+    void append(const VOS::OpenHighLowClose& bar) {
+        append(bar.high, bar.low, bar.close);
+    }
+
+private:
+    Stepper stepper_;
+};
+
+
+// VOS::ADX and SOV::ADX, one bar at a time. The object keeps the Wilder-smoothed TR,
+// +DM, -DM and ADX. After appending bars 0..n-1, value() equals the batch ADX of those
+// n bars bit for bit: every expression is written exactly as in the batch loop,
+// including the size_t period that the float arithmetic converts on each use.
+class ADX : public Indicator<ADX> {
+public:
+    explicit ADX(size_t period = 14) : period_(period) {}
+
+    void update(const Step& s) {
+        const size_t i = bars_++;
+        if (s.first) return;
+
+        if (i <= period_) {
+            // Initial smoothing values: a plain sum, then the mean once there are
+            // period of them.
+            smoothedTR_ += s.tr;
+            smoothedPlusDM_ += s.plusDM;
+            smoothedMinusDM_ += s.minusDM;
+            if (i < period_) return;
+            smoothedTR_ /= period_;
+            smoothedPlusDM_ /= period_;
+            smoothedMinusDM_ /= period_;
+            adx_ = dx();
+            return;
+        }
+
+        smoothedTR_ = (smoothedTR_ * (period_ - 1) + s.tr) / period_;
+        smoothedPlusDM_ = (smoothedPlusDM_ * (period_ - 1) + s.plusDM) / period_;
+        smoothedMinusDM_ = (smoothedMinusDM_ * (period_ - 1) + s.minusDM) / period_;
+        adx_ = (adx_ * (period_ - 1) + dx()) / period_;
+    }
+
+    // 0 until more than period bars have been appended, as in the batch functions.
+    float value() const { return ready() ? adx_ : 0.0f; }
+    bool ready() const { return bars_ > period_; }
+    size_t bars() const { return bars_; }
+    size_t period() const { return period_; }
+
+    void reset() { *this = ADX(period_); }
+
+private:
+    float dx() const {
+        float plusDI = 100.0f * (smoothedPlusDM_ / smoothedTR_);
+        float minusDI = 100.0f * (smoothedMinusDM_ / smoothedTR_);
+        return 100.0f * std::abs(plusDI - minusDI) / (plusDI + minusDI);
+    }
+
+    size_t period_;
+    size_t bars_ = 0;
+    float smoothedTR_ = 0.0f, smoothedPlusDM_ = 0.0f, smoothedMinusDM_ = 0.0f;
+    float adx_ = 0.0f;
+};
+
+// Wilder's average true range: the mean of the first period true ranges, then the
+// same smoothing as ADX uses for TR.
+class ATR : public Indicator<ATR> {
+public:
+    explicit ATR(size_t period = 14) : period_(period) {}
+
+    void update(const Step& s) {
+        const size_t i = bars_++;
+        if (s.first) return;
+        if (i <= period_) {
+            atr_ += s.tr;
+            if (i == period_) atr_ /= period_;
+            return;
+        }
+        atr_ = (atr_ * (period_ - 1) + s.tr) / period_;
+    }
+
+    float value() const { return ready() ? atr_ : 0.0f; }
+    bool ready() const { return bars_ > period_; }
+
+private:
+    size_t period_;
+    size_t bars_ = 0;
+    float atr_ = 0.0f;
+};
+
+// Exponential moving average of the close with alpha = 2 / (period + 1), seeded with
+// the first close.
+class EMA : public Indicator<EMA> {
+public:
+    explicit EMA(size_t period = 20) : alpha_(2.0f / static_cast<float>(period + 1)) {}
+
+    void update(const Step& s) {
+        ema_ = s.first ? s.close : ema_ + alpha_ * (s.close - ema_);
+    }
+
+    float value() const { return ema_; }
+
+private:
+    float alpha_;
+    float ema_ = 0.0f;
+};
+
+// Wilder's RSI: average gain and loss over the first period changes, then smoothed
+// like ATR.
+class RSI : public Indicator<RSI> {
+public:
+    explicit RSI(size_t period = 14) : period_(period) {}
+
+    void update(const Step& s) {
+        const size_t i = bars_++;
+        if (s.first) return;
+        const float gain = s.change > 0 ? s.change : 0.0f;
+        const float loss = s.change < 0 ? -s.change : 0.0f;
+        if (i <= period_) {
+            gain_ += gain;
+            loss_ += loss;
+            if (i == period_) {
+                gain_ /= period_;
+                loss_ /= period_;
+            }
+            return;
+        }
+        gain_ = (gain_ * (period_ - 1) + gain) / period_;
+        loss_ = (loss_ * (period_ - 1) + loss) / period_;
+    }
+
+    float value() const {
+        if (!ready()) return 0.0f;
+        return loss_ == 0.0f ? 100.0f : 100.0f - 100.0f / (1.0f + gain_ / loss_);
+    }
+    bool ready() const { return bars_ > period_; }
+
+private:
+    size_t period_;
+    size_t bars_ = 0;
+    float gain_ = 0.0f;
+    float loss_ = 0.0f;
+};
+
+// Mean and width standard deviations either side of it, over the last period closes.
+// The window is a ring buffer with a running sum and sum of squares; those are doubles
+// so that adding each close and later subtracting it leaves no visible drift.
+class Bollinger : public Indicator<Bollinger> {
+public:
+    explicit Bollinger(size_t period = 20, float width = 2.0f)
+        : window_(period), width_(width) {}
+
+    void update(const Step& s) {
+        float& slot = window_[next_];
+        if (bars_ >= window_.size()) {
+            sum_ -= slot;
+            sum_squares_ -= static_cast<double>(slot) * slot;
+        }
+        slot = s.close;
+        sum_ += s.close;
+        sum_squares_ += static_cast<double>(s.close) * s.close;
+        next_ = next_ + 1 == window_.size() ? 0 : next_ + 1;
+        ++bars_;
+    }
+
+    float middle() const { return ready() ? static_cast<float>(mean()) : 0.0f; }
+    float upper() const { return ready() ? static_cast<float>(mean() + width_ * deviation()) : 0.0f; }
+    float lower() const { return ready() ? static_cast<float>(mean() - width_ * deviation()) : 0.0f; }
+    bool ready() const { return bars_ >= window_.size(); }
+
+private:
+    double mean() const { return sum_ / static_cast<double>(window_.size()); }
+    double deviation() const {
+        const double variance = sum_squares_ / static_cast<double>(window_.size()) - mean() * mean();
+        return variance > 0 ? std::sqrt(variance) : 0.0;
+    }
+
+    std::vector<float> window_;
+    float width_;
+    size_t next_ = 0;
+    size_t bars_ = 0;
+    double sum_ = 0.0;
+    double sum_squares_ = 0.0;
+};
+
+// Volume-weighted average of the typical price (high + low + close) / 3 since the
+// first bar.
+class VWAP : public Indicator<VWAP> {
+public:
+    void update(const Step& s) {
+        const float typical = (s.high + s.low + s.close) / 3.0f;
+        price_volume_ += static_cast<double>(typical) * s.volume;
+        volume_ += s.volume;
+    }
+
+    float value() const { return volume_ > 0 ? static_cast<float>(price_volume_ / volume_) : 0.0f; }
+
+private:
+    double price_volume_ = 0.0;
+    double volume_ = 0.0;
+};
+
+
+// Feeds every bar of data to one indicator: a pass over memory per indicator. volumes
+// is only read if the indicator uses it.
+template <typename I>
+I run(I indicator, const SOV::OpenHighLowClosesView& data) {
+    const size_t size = data.closes.size();
+    if constexpr (std::is_same_v<I, VWAP>) {
+        if (data.volumes.size() != size) {
+            throw std::invalid_argument("VWAP needs a volume for every bar");
+        }
+        for (size_t i = 0; i < size; ++i) {
+            indicator.append(data.highs[i], data.lows[i], data.closes[i], data.volumes[i]);
+        }
+    } else {
+        for (size_t i = 0; i < size; ++i) {
+            indicator.append(data.highs[i], data.lows[i], data.closes[i]);
+        }
+    }
+    return indicator;
+}
+
+
+// Which indicators an IndicatorSet computes, as a bit mask.
+enum Indicators : unsigned {
+    WithADX       = 1u << 0,
+    WithATR       = 1u << 1,
+    WithEMA       = 1u << 2,
+    WithRSI       = 1u << 3,
+    WithBollinger = 1u << 4,
+    WithVWAP      = 1u << 5,
+    WithAll       = (1u << 6) - 1,
+};
+
+struct Periods {
+    size_t adx = 14;
+    size_t atr = 14;
+    size_t ema = 20;
+    size_t rsi = 14;
+    size_t bollinger = 20;
+    float bollinger_width = 2.0f;
+};
+
+// Stands in for an indicator that is not selected; takes no space and does nothing.
+struct Unselected {
+    template <typename... Args>
+    explicit Unselected(Args&&...) {}
+    void update(const Step&) {}
+};
+
+// Several indicators in one pass: each bar is loaded once, its Step computed once and
+// handed to every selected indicator. Selected is fixed at compile time, so the
+// indicators that are left out have no state and no code in the loop. Each selected
+// indicator gives exactly the value it would on its own.
+template <unsigned Selected>
+class IndicatorSet {
+    template <unsigned Bit, typename I>
+    using Slot = std::conditional_t<(Selected & Bit) != 0, I, Unselected>;
+
+public:
+    static constexpr bool has(unsigned bit) { return (Selected & bit) != 0; }
+
+    explicit IndicatorSet(const Periods& periods = Periods())
+        : adx(periods.adx), atr(periods.atr), ema(periods.ema), rsi(periods.rsi),
+          bollinger(periods.bollinger, periods.bollinger_width) {}
+
+    void append(float high, float low, float close, float volume = 0.0f) {
+        const Step s = stepper_.next(high, low, close, volume);
+        adx.update(s);
+        atr.update(s);
+        ema.update(s);
+        rsi.update(s);
+        bollinger.update(s);
+        vwap.update(s);
+    }
+
+    void run(const SOV::OpenHighLowClosesView& data) {
+        const size_t size = data.closes.size();
+        if constexpr (has(WithVWAP)) {
+            if (data.volumes.size() != size) {
+                throw std::invalid_argument("VWAP needs a volume for every bar");
+            }
+            for (size_t i = 0; i < size; ++i) {
+                append(data.highs[i], data.lows[i], data.closes[i], data.volumes[i]);
+            }
+        } else {
+            for (size_t i = 0; i < size; ++i) {
+                append(data.highs[i], data.lows[i], data.closes[i]);
+            }
+        }
+    }
+
+    [[no_unique_address]] Slot<WithADX, ADX> adx;
+    [[no_unique_address]] Slot<WithATR, ATR> atr;
+    [[no_unique_address]] Slot<WithEMA, EMA> ema;
+    [[no_unique_address]] Slot<WithRSI, RSI> rsi;
+    [[no_unique_address]] Slot<WithBollinger, Bollinger> bollinger;
+    [[no_unique_address]] Slot<WithVWAP, VWAP> vwap;
+
+private:
+    Stepper stepper_;
+};
+
+}
+
+
+// Keeping ADX current while 1M bars arrive. Incremental does O(1) work per bar;
+// Recompute calls SOV::ADX on the whole history after each append, so one bar costs
+// O(history) and the full 1M bars O(n^2). Recompute is run as a single append at a
+// given history length; items_per_second is bars appended for both.
+class StreamingADXBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        if (bars.closes.size() != n_bars) {
+            bars = generateSOVData(n_bars);
+        }
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    static const size_t n_bars = 1000000;
+    static inline SOV::OpenHighLowCloses bars;
+};
+
+
+BENCHMARK_F(StreamingADXBenchmark, BM_IncrementalADX)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        streaming::ADX adx;
+        for (size_t i = 0; i < n_bars; ++i) {
+            adx.append(bars.highs[i], bars.lows[i], bars.closes[i]);
+            benchmark::DoNotOptimize(adx.value());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_bars));
+}
+
+BENCHMARK_DEFINE_F(StreamingADXBenchmark, BM_RecomputeADX)(benchmark::State& state) {
+    const auto history = static_cast<size_t>(state.range(0));
+    SOV::OpenHighLowCloses prefix;
+    prefix.highs.assign(bars.highs.begin(), bars.highs.begin() + history);
+    prefix.lows.assign(bars.lows.begin(), bars.lows.begin() + history);
+    prefix.closes.assign(bars.closes.begin(), bars.closes.begin() + history);
+    for (auto _ : alloc_counter::counted(state)) {
+        benchmark::DoNotOptimize(SOV::ADX(prefix));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_REGISTER_F(StreamingADXBenchmark, BM_RecomputeADX)
+    ->ArgName("history")->RangeMultiplier(10)->Range(1000, 1000000);
+
+
+// All six indicators over 10M bars (200MB of columns), as one fused pass and as six
+// passes one after another. items_per_second counts bars.
+class IndicatorSetBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        if (bars.closes.size() != n_bars) {
+            bars = generateSOVData(n_bars);
+            std::mt19937 rng(7);
+            std::uniform_real_distribution<float> volume(100.0f, 10000.0f);
+            bars.volumes.resize(n_bars);
+            for (float& v : bars.volumes) v = volume(rng);
+        }
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    static const size_t n_bars = 10000000;
+    static inline SOV::OpenHighLowCloses bars;
+};
+
+
+BENCHMARK_F(IndicatorSetBenchmark, BM_SeparatePasses)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        benchmark::DoNotOptimize(streaming::run(streaming::ADX(), bars).value());
+        benchmark::DoNotOptimize(streaming::run(streaming::ATR(), bars).value());
+        benchmark::DoNotOptimize(streaming::run(streaming::EMA(), bars).value());
+        benchmark::DoNotOptimize(streaming::run(streaming::RSI(), bars).value());
+        benchmark::DoNotOptimize(streaming::run(streaming::Bollinger(), bars).middle());
+        benchmark::DoNotOptimize(streaming::run(streaming::VWAP(), bars).value());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_bars));
+}
+
+BENCHMARK_F(IndicatorSetBenchmark, BM_FusedPass)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        streaming::IndicatorSet<streaming::WithAll> set;
+        set.run(bars);
+        benchmark::DoNotOptimize(set.adx.value());
+        benchmark::DoNotOptimize(set.atr.value());
+        benchmark::DoNotOptimize(set.ema.value());
+        benchmark::DoNotOptimize(set.rsi.value());
+        benchmark::DoNotOptimize(set.bollinger.middle());
+        benchmark::DoNotOptimize(set.vwap.value());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_bars));
+}
+
+// ADX and ATR only, which share the true range; the other four compile away.
+BENCHMARK_F(IndicatorSetBenchmark, BM_FusedADXATR)(benchmark::State& state) {
+    for (auto _ : alloc_counter::counted(state)) {
+        streaming::IndicatorSet<streaming::WithADX | streaming::WithATR> set;
+        set.run(bars);
+        benchmark::DoNotOptimize(set.adx.value());
+        benchmark::DoNotOptimize(set.atr.value());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n_bars));
+}
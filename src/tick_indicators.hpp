@@ -0,0 +1,245 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "fixed_point.hpp"
+#include "simd_dispatch.hpp"
+#include "vos_vs_sov.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+
+// ADX on int64 tick prices in fixed point (see fixed_point.hpp). It replaces the four
+// float divisions by the period on every bar with multiplies by a reciprocal. Of the
+// three divisions that form DX, one double division is left.
+//
+// Tolerance: against SOV::ADX on the same prices as float, the result stays within
+// 1/64 + period / 512 ADX points (0..100 scale). That bound is observed on
+// generateSOVData series, not proven. Each Wilder step rounds to 1/256 and the
+// smoothing carries up to period of those half-steps; the fixed term covers rounding
+// DX and the float reference itself, which dominates at small periods. Measured
+// worst cases: 0.005 at period 2, 0.010 at period 14, 0.023 at period 100.
+namespace fixed {
+
+struct OpenHighLowCloses {
+    std::vector<int64_t> opens;
+    std::vector<int64_t> highs;
+    std::vector<int64_t> lows;
+    std::vector<int64_t> closes;
+};
+
+inline int64_t to_ticks(float price, double tick_size) {
+    return std::llround(static_cast<double>(price) / tick_size);
+}
+
+inline OpenHighLowCloses to_ticks(const SOV::OpenHighLowClosesView& data, double tick_size) {
+    OpenHighLowCloses ticks;
+    auto convert = [&](std::span<const float> prices, std::vector<int64_t>& out) {
+        out.resize(prices.size());
+        std::transform(prices.begin(), prices.end(), out.begin(), [&](float p) { return to_ticks(p, tick_size); });
+    };
+    convert(data.opens, ticks.opens);
+    convert(data.highs, ticks.highs);
+    convert(data.lows, ticks.lows);
+    convert(data.closes, ticks.closes);
+    return ticks;
+}
+
+inline SOV::OpenHighLowCloses to_prices(const OpenHighLowCloses& ticks, double tick_size) {
+    SOV::OpenHighLowCloses prices;
+    auto convert = [&](const std::vector<int64_t>& in, std::vector<float>& out) {
+        out.resize(in.size());
+        std::transform(in.begin(), in.end(), out.begin(), [&](int64_t t) { return static_cast<float>(static_cast<double>(t) * tick_size); });
+    };
+    convert(ticks.opens, prices.opens);
+    convert(ticks.highs, prices.highs);
+    convert(ticks.lows, prices.lows);
+    convert(ticks.closes, prices.closes);
+    return prices;
+}
+
+float ADX(const OpenHighLowCloses& data, size_t period = 14) {
+    const size_t size = data.closes.size();
+    if (size <= period) return 0.0f;
+
+    const int64_t recip = reciprocal(period);
+    const int64_t n_minus_1 = static_cast<int64_t>(period - 1);
+    int64_t smoothedTR = 0, smoothedPlusDM = 0, smoothedMinusDM = 0;
+    auto step = [&](size_t i, int64_t& tr, int64_t& plusDM, int64_t& minusDM) {
+        const int64_t high = data.highs[i], low = data.lows[i];
+        const int64_t prev_high = data.highs[i - 1], prev_low = data.lows[i - 1], prev_close = data.closes[i - 1];
+        tr = std::max({high - low, std::abs(high - prev_close), std::abs(low - prev_close)});
+        const int64_t up = high - prev_high;
+        const int64_t down = prev_low - low;
+        plusDM = (up > down && up > 0) ? up : 0;
+        minusDM = (down > up && down > 0) ? down : 0;
+    };
+
+    for (size_t i = 1; i <= period; ++i) {
+        int64_t tr, plusDM, minusDM;
+        step(i, tr, plusDM, minusDM);
+        smoothedTR += tr;
+        smoothedPlusDM += plusDM;
+        smoothedMinusDM += minusDM;
+    }
+    smoothedTR = divide(smoothedTR << fraction_bits, recip);
+    smoothedPlusDM = divide(smoothedPlusDM << fraction_bits, recip);
+    smoothedMinusDM = divide(smoothedMinusDM << fraction_bits, recip);
+    int64_t adx = dx(smoothedPlusDM, smoothedMinusDM);
+
+    for (size_t i = period + 1; i < size; ++i) {
+        int64_t tr, plusDM, minusDM;
+        step(i, tr, plusDM, minusDM);
+        smoothedTR = wilder(smoothedTR, tr << fraction_bits, n_minus_1, recip);
+        smoothedPlusDM = wilder(smoothedPlusDM, plusDM << fraction_bits, n_minus_1, recip);
+        smoothedMinusDM = wilder(smoothedMinusDM, minusDM << fraction_bits, n_minus_1, recip);
+        adx = wilder(adx, dx(smoothedPlusDM, smoothedMinusDM), n_minus_1, recip);
+    }
+
+    return to_float(adx);
+}
+
+
+// SOV::ADXLanes for tick prices: the universe transposed into blocks of
+// float_lanes / 2 instruments for KernelTable::adx_lanes_ticks.
+class ADXLanes {
+public:
+    explicit ADXLanes(const simd_kernels::KernelTable& kernels = simd_kernels::active())
+        : kernels_(kernels), lanes_(kernels.float_lanes / 2) {}
+
+    // Every instrument needs the same number of bars. The last block is padded with
+    // copies of the last instrument.
+    void load(const std::vector<OpenHighLowCloses>& universe) {
+        count_ = universe.size();
+        bars_ = count_ ? universe.front().closes.size() : 0;
+        for (const OpenHighLowCloses& instrument : universe) {
+            if (instrument.closes.size() != bars_ || instrument.highs.size() != bars_ || instrument.lows.size() != bars_) {
+                throw std::invalid_argument("fixed::ADXLanes: every instrument needs the same number of bars");
+            }
+        }
+
+        const size_t blocks = (count_ + lanes_ - 1) / lanes_;
+        highs_.resize(blocks * bars_ * lanes_);
+        lows_.resize(blocks * bars_ * lanes_);
+        closes_.resize(blocks * bars_ * lanes_);
+        for (size_t block = 0; block < blocks; ++block) {
+            const size_t base = block * bars_ * lanes_;
+            for (size_t i = 0; i < bars_; ++i) {
+                for (size_t lane = 0; lane < lanes_; ++lane) {
+                    const OpenHighLowCloses& instrument = universe[std::min(block * lanes_ + lane, count_ - 1)];
+                    highs_[base + i * lanes_ + lane] = instrument.highs[i];
+                    lows_[base + i * lanes_ + lane] = instrument.lows[i];
+                    closes_[base + i * lanes_ + lane] = instrument.closes[i];
+                }
+            }
+        }
+    }
+
+    // out[k] is the ADX of universe[k]; out needs room for padded_size().
+    void compute(float* out, size_t period = 14) const {
+        const size_t blocks = padded_size() / lanes_;
+        for (size_t block = 0; block < blocks; ++block) {
+            const size_t base = block * bars_ * lanes_;
+            kernels_.adx_lanes_ticks(highs_.data() + base, lows_.data() + base, closes_.data() + base,
+                                     bars_, period, out + block * lanes_);
+        }
+    }
+
+    size_t size() const { return count_; }
+    size_t padded_size() const { return (count_ + lanes_ - 1) / lanes_ * lanes_; }
+
+private:
+    const simd_kernels::KernelTable& kernels_;
+    size_t lanes_;
+    size_t count_ = 0;
+    size_t bars_ = 0;
+    std::vector<int64_t> highs_;
+    std::vector<int64_t> lows_;
+    std::vector<int64_t> closes_;
+};
+
+}
+
+
+// Float against fixed-point ADX on the same prices (a 0.0001 tick), as the scalar loop
+// over a universe of 5000 instruments x 252 bars and as the lane kernels. The fixed
+// lanes hold int64, so they fit half as many instruments per vector as the float
+// ones. items_per_second counts instruments.
+class TickADXBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        if (float_universe.size() == n_instruments) return;
+        for (size_t k = 0; k < n_instruments; ++k) {
+            fixed::OpenHighLowCloses ticks = fixed::to_ticks(generateSOVData(n_bars), tick_size);
+            float_universe.push_back(fixed::to_prices(ticks, tick_size));
+            tick_universe.push_back(std::move(ticks));
+        }
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+
+    }
+
+    static constexpr double tick_size = 0.0001;
+    static const size_t n_instruments = 5000;
+    static const size_t n_bars = 252;
+    static inline std::vector<SOV::OpenHighLowCloses> float_universe;
+    static inline std::vector<fixed::OpenHighLowCloses> tick_universe;
+};
+
+
+BENCHMARK_F(TickADXBenchmark, BM_FloatScalar)(benchmark::State& state) {
+    std::vector<float> out(n_instruments);
+    for (auto _ : alloc_counter::counted(state)) {
+        for (size_t k = 0; k < n_instruments; ++k) {
+            out[k] = SOV::ADX(float_universe[k]);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n_instruments);
+}
+
+BENCHMARK_F(TickADXBenchmark, BM_FixedScalar)(benchmark::State& state) {
+    std::vector<float> out(n_instruments);
+    for (auto _ : alloc_counter::counted(state)) {
+        for (size_t k = 0; k < n_instruments; ++k) {
+            out[k] = fixed::ADX(tick_universe[k]);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n_instruments);
+}
+
+BENCHMARK_DEFINE_F(TickADXBenchmark, BM_FloatLanes)(benchmark::State& state) {
+    const simd_kernels::KernelTable& kernels = simd_kernels::table_for(state);
+    SOV::ADXLanes engine(kernels);
+    engine.load(float_universe);
+    std::vector<float> out(engine.padded_size());
+    for (auto _ : alloc_counter::counted(state)) {
+        engine.compute(out.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n_instruments);
+    state.SetLabel(kernels.name);
+}
+BENCHMARK_REGISTER_F(TickADXBenchmark, BM_FloatLanes)->Apply(simd_kernels::supported_isa_args);
+
+BENCHMARK_DEFINE_F(TickADXBenchmark, BM_FixedLanes)(benchmark::State& state) {
+    const simd_kernels::KernelTable& kernels = simd_kernels::table_for(state);
+    fixed::ADXLanes engine(kernels);
+    engine.load(tick_universe);
+    std::vector<float> out(engine.padded_size());
+    for (auto _ : alloc_counter::counted(state)) {
+        engine.compute(out.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n_instruments);
+    state.SetLabel(kernels.name);
+}
+BENCHMARK_REGISTER_F(TickADXBenchmark, BM_FixedLanes)->Apply(simd_kernels::supported_isa_args);
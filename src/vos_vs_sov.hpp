@@ -1,9 +1,13 @@
 #pragma once
 #include <vector>
 #include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "simd_dispatch.hpp"
 #include <cmath>
 #include <numeric>
 #include <random>
+#include <span>
+#include <stdexcept>
 
 namespace VOS {
 
@@ -68,32 +72,46 @@ float ADX(const OpenHighLowCloses& data, size_t period = 14) {
 
 namespace SOV {
 
+// Non-owning columns, e.g. of an OpenHighLowCloses or a memory-mapped BarFile.
+struct OpenHighLowClosesView {
+    std::span<const float> opens;
+    std::span<const float> highs;
+    std::span<const float> lows;
+    std::span<const float> closes;
+    std::span<const float> volumes;
+};
+
 struct OpenHighLowCloses {
     std::vector<float> opens;
     std::vector<float> highs;
     std::vector<float> lows;
     std::vector<float> closes;
+    std::vector<float> volumes;   // may be left empty; only VWAP reads it
+
+    operator OpenHighLowClosesView() const {
+        return {opens, highs, lows, closes, volumes};
+    }
 };
 
-float ADX(const OpenHighLowCloses& data, size_t period = 14) {
-    size_t size = data.closes.size();
+// Wilder's ADX over size bars read through high(i), low(i) and close(i), so other
+// layouts (soa_vector.hpp) run exactly the same arithmetic as the columns here.
+template <typename High, typename Low, typename Close>
+float WilderADX(size_t size, size_t period, High high, Low low, Close close) {
     if (size <= period) return 0.0f;
 
     float smoothedTR = 0.0f, smoothedPlusDM = 0.0f, smoothedMinusDM = 0.0f;
     float adx = 0.0f;
+    auto step = [&](size_t i, float& tr, float& plusDM, float& minusDM) {
+        const float h = high(i), l = low(i);
+        const float prev_high = high(i - 1), prev_low = low(i - 1), prev_close = close(i - 1);
+        tr = std::max({h - l, std::abs(h - prev_close), std::abs(l - prev_close)});
+        plusDM = (h - prev_high > prev_low - l && h - prev_high > 0) ? (h - prev_high) : 0;
+        minusDM = (prev_low - l > h - prev_high && prev_low - l > 0) ? (prev_low - l) : 0;
+    };
 
     for (size_t i = 1; i <= period; ++i) {
-        float tr = std::max({
-            data.highs[i] - data.lows[i],
-            std::abs(data.highs[i] - data.closes[i - 1]),
-            std::abs(data.lows[i] - data.closes[i - 1])
-        });
-
-        float plusDM = (data.highs[i] - data.highs[i - 1] > data.lows[i - 1] - data.lows[i] &&
-                        data.highs[i] - data.highs[i - 1] > 0) ? (data.highs[i] - data.highs[i - 1]) : 0;
-        float minusDM = (data.lows[i - 1] - data.lows[i] > data.highs[i] - data.highs[i - 1] &&
-                         data.lows[i - 1] - data.lows[i] > 0) ? (data.lows[i - 1] - data.lows[i]) : 0;
-
+        float tr, plusDM, minusDM;
+        step(i, tr, plusDM, minusDM);
         smoothedTR += tr;
         smoothedPlusDM += plusDM;
         smoothedMinusDM += minusDM;
@@ -109,17 +127,8 @@ float ADX(const OpenHighLowCloses& data, size_t period = 14) {
     adx = dx;
 
     for (size_t i = period + 1; i < size; ++i) {
-        float tr = std::max({
-            data.highs[i] - data.lows[i],
-            std::abs(data.highs[i] - data.closes[i - 1]),
-            std::abs(data.lows[i] - data.closes[i - 1])
-        });
-
-        float plusDM = (data.highs[i] - data.highs[i - 1] > data.lows[i - 1] - data.lows[i] &&
-                        data.highs[i] - data.highs[i - 1] > 0) ? (data.highs[i] - data.highs[i - 1]) : 0;
-        float minusDM = (data.lows[i - 1] - data.lows[i] > data.highs[i] - data.highs[i - 1] &&
-                         data.lows[i - 1] - data.lows[i] > 0) ? (data.lows[i - 1] - data.lows[i]) : 0;
-
+        float tr, plusDM, minusDM;
+        step(i, tr, plusDM, minusDM);
         smoothedTR = (smoothedTR * (period - 1) + tr) / period;
         smoothedPlusDM = (smoothedPlusDM * (period - 1) + plusDM) / period;
         smoothedMinusDM = (smoothedMinusDM * (period - 1) + minusDM) / period;
@@ -133,10 +142,85 @@ float ADX(const OpenHighLowCloses& data, size_t period = 14) {
     return adx;
 }
 
+float ADX(const OpenHighLowClosesView& data, size_t period = 14) {
+    return WilderADX(data.closes.size(), period,
+                     [&](size_t i) { return data.highs[i]; },
+                     [&](size_t i) { return data.lows[i]; },
+                     [&](size_t i) { return data.closes[i]; });
 }
 
 
-class StructOfVectorsBenchmark : public benchmark::Fixture {
+// ADX across a universe of instruments, one instrument per SIMD lane. The recurrence
+// is serial in time, so instead of vectorising along it, load() transposes the
+// universe into blocks of float_lanes instruments stored bar-major, and compute() runs
+// the Wilder smoothing for a whole block per instruction.
+//
+// The SSE2 kernel reproduces SOV::ADX bit for bit. The AVX2 and AVX-512 builds may
+// fuse a multiply and add where the scalar build rounds twice, which moves the result
+// by up to about 1e-6 relative.
+class ADXLanes {
+public:
+    explicit ADXLanes(const simd_kernels::KernelTable& kernels = simd_kernels::active())
+        : kernels_(kernels), lanes_(kernels.float_lanes) {}
+
+    // Every instrument needs the same number of bars. The last block is padded with
+    // copies of the last instrument.
+    void load(const std::vector<OpenHighLowCloses>& universe) {
+        count_ = universe.size();
+        bars_ = count_ ? universe.front().closes.size() : 0;
+        for (const OpenHighLowCloses& instrument : universe) {
+            if (instrument.closes.size() != bars_ || instrument.highs.size() != bars_ || instrument.lows.size() != bars_) {
+                throw std::invalid_argument("ADXLanes: every instrument needs the same number of bars");
+            }
+        }
+
+        const size_t blocks = (count_ + lanes_ - 1) / lanes_;
+        highs_.resize(blocks * bars_ * lanes_);
+        lows_.resize(blocks * bars_ * lanes_);
+        closes_.resize(blocks * bars_ * lanes_);
+        for (size_t block = 0; block < blocks; ++block) {
+            const size_t base = block * bars_ * lanes_;
+            // Bar-major, so the writes are sequential and the reads are one stream
+            // per lane.
+            for (size_t i = 0; i < bars_; ++i) {
+                for (size_t lane = 0; lane < lanes_; ++lane) {
+                    const OpenHighLowCloses& instrument = universe[std::min(block * lanes_ + lane, count_ - 1)];
+                    highs_[base + i * lanes_ + lane] = instrument.highs[i];
+                    lows_[base + i * lanes_ + lane] = instrument.lows[i];
+                    closes_[base + i * lanes_ + lane] = instrument.closes[i];
+                }
+            }
+        }
+    }
+
+    // out[k] is the ADX of universe[k]. out needs room for size() rounded up to a whole
+    // block; see padded_size().
+    void compute(float* out, size_t period = 14) const {
+        const size_t blocks = padded_size() / lanes_;
+        for (size_t block = 0; block < blocks; ++block) {
+            const size_t base = block * bars_ * lanes_;
+            kernels_.adx_lanes(highs_.data() + base, lows_.data() + base, closes_.data() + base,
+                               bars_, period, out + block * lanes_);
+        }
+    }
+
+    size_t size() const { return count_; }
+    size_t padded_size() const { return (count_ + lanes_ - 1) / lanes_ * lanes_; }
+
+private:
+    const simd_kernels::KernelTable& kernels_;
+    size_t lanes_;
+    size_t count_ = 0;
+    size_t bars_ = 0;
+    std::vector<float> highs_;
+    std::vector<float> lows_;
+    std::vector<float> closes_;
+};
+
+}
+
+
+class StructOfVectorsBenchmark : public AllocCountingFixture {
 public:
     void SetUp(const ::benchmark::State& state) override {
 
@@ -192,7 +276,7 @@ inline SOV::OpenHighLowCloses generateSOVData(size_t n) {
 BENCHMARK_F(StructOfVectorsBenchmark, VectorOfStructs)(benchmark::State& state)
 {
     auto data = generateVOSData(n_OHLC);
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         float result = VOS::ADX(data);
         benchmark::DoNotOptimize(result);
     }
@@ -201,8 +285,102 @@ BENCHMARK_F(StructOfVectorsBenchmark, VectorOfStructs)(benchmark::State& state)
 BENCHMARK_F(StructOfVectorsBenchmark, StructOfVectors)(benchmark::State& state)
 {
     auto data = generateSOVData(n_OHLC);
-    for (auto _ : state) {
+    for (auto _ : alloc_counter::counted(state)) {
         float result = SOV::ADX(data);
         benchmark::DoNotOptimize(result);
     }
 }
+
+
+// ADX for a whole universe: one instrument at a time (VOS and SOV) against the
+// lane-transposed engine. items_per_second counts instruments.
+class ADXUniverseBenchmark : public AllocCountingFixture {
+public:
+    void SetUp(const ::benchmark::State& state) override {
+        vos_universe.clear();
+        sov_universe.clear();
+        for (size_t k = 0; k < n_instruments; ++k) {
+            vos_universe.push_back(generateVOSData(n_bars));
+            SOV::OpenHighLowCloses sov;
+            for (const VOS::OpenHighLowClose& bar : vos_universe.back()) {
+                sov.opens.push_back(bar.open);
+                sov.highs.push_back(bar.high);
+                sov.lows.push_back(bar.low);
+                sov.closes.push_back(bar.close);
+            }
+            sov_universe.push_back(std::move(sov));
+        }
+    }
+
+    void TearDown(const ::benchmark::State& state) override {
+        vos_universe.clear();
+        sov_universe.clear();
+    }
+
+    static const size_t n_instruments = 5000;
+    static const size_t n_bars = 252;
+    std::vector<VOS::OpenHighLowCloses> vos_universe;
+    std::vector<SOV::OpenHighLowCloses> sov_universe;
+};
+
+
+BENCHMARK_F(ADXUniverseBenchmark, VectorOfStructsLoop)(benchmark::State& state)
+{
+    std::vector<float> out(n_instruments);
+    for (auto _ : alloc_counter::counted(state)) {
+        for (size_t k = 0; k < n_instruments; ++k) {
+            out[k] = VOS::ADX(vos_universe[k]);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n_instruments);
+}
+
+BENCHMARK_F(ADXUniverseBenchmark, StructOfVectorsLoop)(benchmark::State& state)
+{
+    std::vector<float> out(n_instruments);
+    for (auto _ : alloc_counter::counted(state)) {
+        for (size_t k = 0; k < n_instruments; ++k) {
+            out[k] = SOV::ADX(sov_universe[k]);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n_instruments);
+}
+
+// The universe is transposed once, outside the timed loop.
+BENCHMARK_DEFINE_F(ADXUniverseBenchmark, SIMDLanes)(benchmark::State& state)
+{
+    const simd_kernels::KernelTable& kernels = simd_kernels::table_for(state);
+    SOV::ADXLanes engine(kernels);
+    engine.load(sov_universe);
+    std::vector<float> out(engine.padded_size());
+    for (auto _ : alloc_counter::counted(state)) {
+        engine.compute(out.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n_instruments);
+    state.SetLabel(kernels.name);
+}
+BENCHMARK_REGISTER_F(ADXUniverseBenchmark, SIMDLanes)->Apply(simd_kernels::supported_isa_args);
+
+// Transposing on every call, for data that arrives one instrument at a time.
+BENCHMARK_DEFINE_F(ADXUniverseBenchmark, SIMDLanesWithTranspose)(benchmark::State& state)
+{
+    const simd_kernels::KernelTable& kernels = simd_kernels::table_for(state);
+    SOV::ADXLanes engine(kernels);
+    engine.load(sov_universe);
+    std::vector<float> out(engine.padded_size());
+    for (auto _ : alloc_counter::counted(state)) {
+        engine.load(sov_universe);
+        engine.compute(out.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n_instruments);
+    state.SetLabel(kernels.name);
+}
+BENCHMARK_REGISTER_F(ADXUniverseBenchmark, SIMDLanesWithTranspose)->Apply(simd_kernels::supported_isa_args);
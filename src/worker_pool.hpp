@@ -0,0 +1,98 @@
+#pragma once
+
+#include "affinity.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// A fixed set of worker threads, each pinned to one cpu for its whole life. run()
+// hands every worker the same task, tagged with the worker's index, and blocks until
+// they have all returned; how the work is split is up to the task.
+//
+// Worker k runs on cpus[k], or on cpu k modulo the hardware concurrency if no list is
+// given. Pinning is best effort: a worker that can't be pinned still runs.
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t threads, std::vector<int> cpus = {}) {
+        if (cpus.empty()) {
+            const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+            for (size_t k = 0; k < threads; ++k) cpus.push_back(static_cast<int>(k % hardware));
+        }
+        workers_.reserve(threads);
+        for (size_t k = 0; k < threads; ++k) {
+            const int cpu = cpus[k % cpus.size()];
+            workers_.emplace_back([this, k, cpu] { work(k, cpu); });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        start_.notify_all();
+        for (std::thread& worker : workers_) worker.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t size() const { return workers_.size(); }
+
+    // Calls task(worker) on every worker. The first exception a worker throws is
+    // rethrown here once all of them are done.
+    template<typename Task>
+    void run(Task& task) {
+        std::unique_lock lock(mutex_);
+        task_ = [](void* context, size_t worker) { (*static_cast<Task*>(context))(worker); };
+        context_ = &task;
+        error_ = nullptr;
+        pending_ = workers_.size();
+        ++generation_;
+        start_.notify_all();
+        done_.wait(lock, [this] { return pending_ == 0; });
+        if (error_) std::rethrow_exception(error_);
+    }
+
+private:
+    void work(size_t worker, int cpu) {
+        set_current_thread_affinity(cpu);
+        size_t seen = 0;
+        for (;;) {
+            std::unique_lock lock(mutex_);
+            start_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) return;
+            seen = generation_;
+            void (*task)(void*, size_t) = task_;
+            void* context = context_;
+            lock.unlock();
+
+            std::exception_ptr error;
+            try {
+                task(context, worker);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            if (error && !error_) error_ = error;
+            if (--pending_ == 0) done_.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    void (*task_)(void*, size_t) = nullptr;
+    void* context_ = nullptr;
+    std::exception_ptr error_;
+    size_t pending_ = 0;
+    size_t generation_ = 0;
+    bool stopping_ = false;
+};